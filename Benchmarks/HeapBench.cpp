@@ -0,0 +1,164 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "../DataStructures/BinaryHeap.h"
+#include "../DataStructures/DAryHeap.h"
+#include "../DataStructures/QueryEdge.h"
+#include "../DataStructures/RadixHeap.h"
+#include "../DataStructures/StaticGraph.h"
+#include "../Util/GraphLoader.h"
+#include "../Util/simple_logger.hpp"
+#include "../Util/TimingUtil.h"
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+constexpr int32_t RANDOM_SEED = 42;
+
+using QueryGraph = StaticGraph<QueryEdge::EdgeData>;
+
+struct BenchHeapData
+{
+    NodeID parent;
+    /* explicit */ BenchHeapData(NodeID p) : parent(p) {}
+};
+
+using BenchStorage = TimestampedArrayStorage<NodeID, NodeID>;
+using BenchBinaryHeap = BinaryHeap<NodeID, NodeID, int, BenchHeapData, BenchStorage>;
+using Bench4AryHeap = DAryHeap<NodeID, NodeID, int, BenchHeapData, BenchStorage, 4>;
+using Bench8AryHeap = DAryHeap<NodeID, NodeID, int, BenchHeapData, BenchStorage, 8>;
+using BenchRadixHeap = RadixHeap<NodeID, NodeID, int, BenchHeapData, BenchStorage>;
+
+// Settles the full upward search space of a CH query with stall-on-demand, the way the query
+// searches do. Returns the sum of the settled distances to cross check the heaps.
+template <typename HeapT>
+uint64_t UpwardSearch(const QueryGraph &graph, HeapT &heap, const NodeID source, const bool forward)
+{
+    uint64_t distance_sum = 0;
+    heap.Clear();
+    heap.Insert(source, 0, source);
+    while (!heap.Empty())
+    {
+        const NodeID node = heap.DeleteMin();
+        const int distance = heap.GetKey(node);
+        distance_sum += distance;
+
+        bool stalled = false;
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const QueryEdge::EdgeData &data = graph.GetEdgeData(edge);
+            const NodeID to = graph.GetTarget(edge);
+            if ((forward ? data.backward : data.forward) && heap.WasInserted(to) &&
+                heap.GetKey(to) + data.distance < distance)
+            {
+                stalled = true;
+                break;
+            }
+        }
+        if (stalled)
+        {
+            continue;
+        }
+
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const QueryEdge::EdgeData &data = graph.GetEdgeData(edge);
+            if (!(forward ? data.forward : data.backward))
+            {
+                continue;
+            }
+            const NodeID to = graph.GetTarget(edge);
+            const int to_distance = distance + data.distance;
+            if (!heap.WasInserted(to))
+            {
+                heap.Insert(to, to_distance, node);
+            }
+            else if (to_distance < heap.GetKey(to))
+            {
+                heap.GetData(to).parent = node;
+                heap.DecreaseKey(to, to_distance);
+            }
+        }
+    }
+    return distance_sum;
+}
+
+template <typename HeapT>
+void Benchmark(const std::string &name, const QueryGraph &graph, const std::vector<NodeID> &sources)
+{
+    HeapT heap(graph.GetNumberOfNodes());
+    uint64_t checksum = 0;
+
+    TIMER_START(upward_searches);
+    for (const NodeID source : sources)
+    {
+        checksum += UpwardSearch(graph, heap, source, true);
+        checksum += UpwardSearch(graph, heap, source, false);
+    }
+    TIMER_STOP(upward_searches);
+
+    std::cout << "#### " << name << "\n";
+    std::cout << "Took " << TIMER_MSEC(upward_searches) << " msec for " << sources.size()
+              << " forward and backward searches, checksum " << checksum << "\n";
+    std::cout << TIMER_MSEC(upward_searches) / ((double)sources.size()) << " msec/query."
+              << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "./heap-bench file.hsgr [number of queries]"
+                  << "\n";
+        return 1;
+    }
+
+    const unsigned num_queries = (argc > 2 ? std::stoul(argv[2]) : 10000);
+
+    std::vector<QueryGraph::NodeArrayEntry> node_list;
+    std::vector<QueryGraph::EdgeArrayEntry> edge_list;
+    unsigned check_sum = 0;
+    readHSGRFromStream(argv[1], node_list, edge_list, &check_sum);
+    const QueryGraph graph(node_list, edge_list);
+
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node_udist(0, graph.GetNumberOfNodes() - 1);
+    std::vector<NodeID> sources;
+    for (unsigned i = 0; i < num_queries; ++i)
+    {
+        sources.push_back(node_udist(mt_rand));
+    }
+
+    Benchmark<BenchBinaryHeap>("binary heap", graph, sources);
+    Benchmark<Bench4AryHeap>("4-ary heap", graph, sources);
+    Benchmark<Bench8AryHeap>("8-ary heap", graph, sources);
+    Benchmark<BenchRadixHeap>("radix heap", graph, sources);
+
+    return 0;
+}
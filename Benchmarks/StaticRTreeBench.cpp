@@ -1,5 +1,6 @@
 #include "../DataStructures/OriginalEdgeData.h"
 #include "../DataStructures/QueryNode.h"
+#include "../DataStructures/SegmentDistanceKernel.h"
 #include "../DataStructures/SharedMemoryVectorWrapper.h"
 #include "../DataStructures/StaticRTree.h"
 #include "../Util/BoostFileSystemFix.h"
@@ -7,6 +8,7 @@
 
 #include <osrm/Coordinate.h>
 
+#include <iostream>
 #include <random>
 
 // Choosen by a fair W20 dice roll (this value is completely arbitrary)
@@ -107,6 +109,143 @@ void Benchmark(BenchStaticRTree &rtree, unsigned num_queries)
               << "\n";
 }
 
+// Snapping heavy workloads: GPS traces close to the road network as seen by map matching,
+// and many scattered locations as sent by table requests.
+std::vector<FixedPointCoordinate> GenerateTraceQueries(const FixedPointCoordinateListPtr &coords,
+                                                       unsigned num_queries)
+{
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<unsigned> node_udist(0, coords->size() - 1);
+    std::uniform_int_distribution<> step_udist(-200, 200);
+    std::vector<FixedPointCoordinate> queries;
+    FixedPointCoordinate position;
+    for (unsigned i = 0; i < num_queries; i++)
+    {
+        // start a new trace every 100 points
+        if (0 == i % 100)
+        {
+            position = coords->at(node_udist(mt_rand));
+        }
+        position.lat += step_udist(mt_rand);
+        position.lon += step_udist(mt_rand);
+        queries.emplace_back(position);
+    }
+    return queries;
+}
+
+std::vector<FixedPointCoordinate> GenerateTableQueries(const FixedPointCoordinateListPtr &coords,
+                                                       unsigned num_queries)
+{
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<unsigned> node_udist(0, coords->size() - 1);
+    std::uniform_int_distribution<> offset_udist(-1000, 1000);
+    std::vector<FixedPointCoordinate> queries;
+    for (unsigned i = 0; i < num_queries; i++)
+    {
+        const FixedPointCoordinate &node = coords->at(node_udist(mt_rand));
+        queries.emplace_back(node.lat + offset_udist(mt_rand), node.lon + offset_udist(mt_rand));
+    }
+    return queries;
+}
+
+// Compares the batched leaf distance kernel against the per-segment reference on leaves made of
+// consecutive coordinates, one leaf scan per query. The batched timing includes filling the leaf
+// arrays, which the r-tree stores that way already.
+void BenchmarkLeafKernel(const FixedPointCoordinateListPtr &coords,
+                         const std::vector<FixedPointCoordinate> &queries)
+{
+    const uint32_t leaf_size = std::min<uint32_t>(1024, coords->size() - 1);
+    std::vector<int32_t> u_lats(leaf_size), u_lons(leaf_size), v_lats(leaf_size), v_lons(leaf_size);
+    std::vector<float> squared_distances(leaf_size);
+
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<unsigned> offset_udist(0, coords->size() - leaf_size - 1);
+    std::vector<unsigned> leaf_offsets;
+    for (unsigned i = 0; i < queries.size(); ++i)
+    {
+        leaf_offsets.emplace_back(offset_udist(mt_rand));
+    }
+
+    float reference_checksum = 0.f;
+    TIMER_START(reference_kernel);
+    for (unsigned q = 0; q < queries.size(); ++q)
+    {
+        for (uint32_t i = 0; i < leaf_size; ++i)
+        {
+            reference_checksum += FixedPointCoordinate::ComputePerpendicularDistance(
+                coords->at(leaf_offsets[q] + i), coords->at(leaf_offsets[q] + i + 1), queries[q]);
+        }
+    }
+    TIMER_STOP(reference_kernel);
+
+    float batch_checksum = 0.f;
+    TIMER_START(batch_kernel);
+    for (unsigned q = 0; q < queries.size(); ++q)
+    {
+        for (uint32_t i = 0; i < leaf_size; ++i)
+        {
+            u_lats[i] = coords->at(leaf_offsets[q] + i).lat;
+            u_lons[i] = coords->at(leaf_offsets[q] + i).lon;
+            v_lats[i] = coords->at(leaf_offsets[q] + i + 1).lat;
+            v_lons[i] = coords->at(leaf_offsets[q] + i + 1).lon;
+        }
+        osrm::ComputeSquaredSegmentDistances(queries[q],
+                                             osrm::LongitudeScaleAt(queries[q].lat),
+                                             u_lats.data(),
+                                             u_lons.data(),
+                                             v_lats.data(),
+                                             v_lons.data(),
+                                             leaf_size,
+                                             squared_distances.data());
+        for (uint32_t i = 0; i < leaf_size; ++i)
+        {
+            batch_checksum += std::sqrt(squared_distances[i]) * osrm::FIXED_POINT_UNIT_IN_METERS;
+        }
+    }
+    TIMER_STOP(batch_kernel);
+
+    std::cout << "Leaf scans of " << leaf_size << " segments, " << osrm::SEGMENT_DISTANCE_LANES
+              << " lanes: reference " << TIMER_MSEC(reference_kernel) << " msec, batched "
+              << TIMER_MSEC(batch_kernel) << " msec, speedup "
+              << TIMER_MSEC(reference_kernel) / TIMER_MSEC(batch_kernel) << "x"
+              << " (checksums " << reference_checksum << "/" << batch_checksum << ")"
+              << "\n";
+}
+
+void BenchmarkSnapping(BenchStaticRTree &rtree,
+                       const FixedPointCoordinateListPtr &coords,
+                       const std::string &workload,
+                       const std::vector<FixedPointCoordinate> &queries)
+{
+    std::cout << "#### " << workload << " : " << queries.size() << " queries"
+              << "\n";
+
+    TIMER_START(query_phantom);
+    std::vector<PhantomNode> resulting_phantom_node_vector;
+    for (const auto &q : queries)
+    {
+        resulting_phantom_node_vector.clear();
+        rtree.IncrementalFindPhantomNodeForCoordinate(q, resulting_phantom_node_vector, 18, 1);
+    }
+    TIMER_STOP(query_phantom);
+    std::cout << "IncrementalFindPhantomNodeForCoordinate: "
+              << TIMER_MSEC(query_phantom) / ((double)queries.size()) << " msec/query."
+              << "\n";
+
+    TIMER_START(query_endpoint);
+    FixedPointCoordinate result;
+    for (const auto &q : queries)
+    {
+        rtree.LocateClosestEndPointForCoordinate(q, result, 18);
+    }
+    TIMER_STOP(query_endpoint);
+    std::cout << "LocateClosestEndPointForCoordinate: "
+              << TIMER_MSEC(query_endpoint) / ((double)queries.size()) << " msec/query."
+              << "\n";
+
+    BenchmarkLeafKernel(coords, queries);
+}
+
 int main(int argc, char **argv)
 {
     if (argc < 4)
@@ -125,6 +264,8 @@ int main(int argc, char **argv)
     BenchStaticRTree rtree(ramPath, filePath, coords);
 
     Benchmark(rtree, 10000);
+    BenchmarkSnapping(rtree, coords, "Map matching", GenerateTraceQueries(coords, 10000));
+    BenchmarkSnapping(rtree, coords, "Distance table", GenerateTableQueries(coords, 10000));
 
     return 0;
 }
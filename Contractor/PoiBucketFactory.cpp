@@ -0,0 +1,392 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#include "PoiBucketFactory.h"
+
+#include "../DataStructures/HeapSelection.h"
+#include "../DataStructures/ImportNode.h"
+#include "../DataStructures/Range.h"
+#include "../DataStructures/StaticPoiIndex.h"
+#include "../DataStructures/XORFastHashStorage.h"
+#include "../Util/simple_logger.hpp"
+#include "../Util/TimingUtil.h"
+
+#include <boost/assert.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+struct PoiSearchHeapData
+{
+    PoiSearchHeapData() {}
+};
+
+using PoiSearchHeap =
+    SelectedHeap<NodeID, NodeID, int, PoiSearchHeapData, XORFastHashStorage<NodeID, NodeID>>;
+
+struct PoiSearchThreadData
+{
+    explicit PoiSearchThreadData(const unsigned number_of_nodes) : heap(number_of_nodes) {}
+
+    PoiSearchHeap heap;
+    std::vector<std::pair<NodeID, PoiBucketEntry>> settled_buckets;
+};
+
+// see ManyToManyRouting for the query-time counterpart of the backward search
+bool StallAtNode(const PoiBucketFactory::QueryGraph &graph,
+                 const NodeID node,
+                 const EdgeWeight distance,
+                 PoiSearchHeap &heap)
+{
+    for (const auto edge : graph.GetAdjacentEdgeRange(node))
+    {
+        const auto &data = graph.GetEdgeData(edge);
+        if (data.forward)
+        {
+            const NodeID to = graph.GetTarget(edge);
+            BOOST_ASSERT_MSG(data.distance > 0, "edge_weight invalid");
+            if (heap.WasInserted(to) && heap.GetKey(to) + data.distance < distance)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void RelaxIncomingEdges(const PoiBucketFactory::QueryGraph &graph,
+                        const NodeID node,
+                        const EdgeWeight distance,
+                        const EdgeWeight max_radius,
+                        PoiSearchHeap &heap)
+{
+    for (const auto edge : graph.GetAdjacentEdgeRange(node))
+    {
+        const auto &data = graph.GetEdgeData(edge);
+        if (data.backward)
+        {
+            const NodeID to = graph.GetTarget(edge);
+            const int to_distance = distance + data.distance;
+            if (to_distance > max_radius)
+            {
+                continue;
+            }
+            if (!heap.WasInserted(to))
+            {
+                heap.Insert(to, to_distance, PoiSearchHeapData());
+            }
+            else if (to_distance < heap.GetKey(to))
+            {
+                heap.DecreaseKey(to, to_distance);
+            }
+        }
+    }
+}
+}
+
+/**
+    \brief Reads the .poi file and snaps each POI onto a segment starting or ending at its node
+
+    POIs that are not part of the routable network are dropped.
+ */
+void PoiBucketFactory::LoadPois(const std::string &poi_filename,
+                                const std::vector<NodeInfo> &internal_to_external_node_map,
+                                const std::vector<EdgeBasedNode> &node_based_edge_list)
+{
+    boost::filesystem::ifstream poi_stream(poi_filename, std::ios::binary);
+    if (!poi_stream)
+    {
+        SimpleLogger().Write(logWARNING) << poi_filename << " not found, no POIs are indexed";
+        return;
+    }
+
+    const FingerPrint fingerprint_orig;
+    FingerPrint fingerprint_loaded;
+    poi_stream.read((char *)&fingerprint_loaded, sizeof(FingerPrint));
+    if (!fingerprint_loaded.TestGraphUtil(fingerprint_orig))
+    {
+        SimpleLogger().Write(logWARNING) << ".poi was prepared with different build.\n"
+                                            "Reprocess to get rid of this warning.";
+    }
+
+    unsigned number_of_pois = 0;
+    poi_stream.read((char *)&number_of_pois, sizeof(unsigned));
+    std::vector<ExternalMemoryNode> poi_nodes(number_of_pois);
+    if (number_of_pois > 0)
+    {
+        poi_stream.read((char *)&poi_nodes[0], number_of_pois * sizeof(ExternalMemoryNode));
+    }
+    poi_stream.close();
+
+    std::unordered_map<NodeID, unsigned> external_to_poi_index;
+    for (const auto i : osrm::irange(0u, number_of_pois))
+    {
+        external_to_poi_index.emplace(poi_nodes[i].node_id, i);
+    }
+
+    std::unordered_map<NodeID, unsigned> internal_to_poi_index;
+    for (const auto i : osrm::irange<unsigned>(0, internal_to_external_node_map.size()))
+    {
+        const auto iter = external_to_poi_index.find(internal_to_external_node_map[i].node_id);
+        if (iter != external_to_poi_index.end())
+        {
+            internal_to_poi_index.emplace(i, iter->second);
+        }
+    }
+
+    // a query starts this far below zero at most, see OneToAllPoiRouting
+    max_source_offset = 0;
+    for (const EdgeBasedNode &segment : node_based_edge_list)
+    {
+        if (SPECIAL_NODEID != segment.forward_edge_based_node_id)
+        {
+            max_source_offset =
+                std::max(max_source_offset, segment.forward_weight + segment.forward_offset);
+        }
+        if (SPECIAL_NODEID != segment.reverse_edge_based_node_id)
+        {
+            max_source_offset =
+                std::max(max_source_offset, segment.reverse_weight + segment.reverse_offset);
+        }
+    }
+
+    // a segment in a big component is preferred over one in a tiny component
+    std::vector<PhantomNode> snapped_phantoms(number_of_pois);
+    std::vector<bool> snapped_to_big_component(number_of_pois, false);
+    for (const EdgeBasedNode &segment : node_based_edge_list)
+    {
+        for (const NodeID node : {segment.u, segment.v})
+        {
+            const auto iter = internal_to_poi_index.find(node);
+            if (iter == internal_to_poi_index.end())
+            {
+                continue;
+            }
+            const unsigned poi_index = iter->second;
+            if (snapped_to_big_component[poi_index] ||
+                (snapped_phantoms[poi_index].isValid() && segment.is_in_tiny_cc))
+            {
+                continue;
+            }
+
+            FixedPointCoordinate location(poi_nodes[poi_index].lat, poi_nodes[poi_index].lon);
+            PhantomNode phantom_node(segment.forward_edge_based_node_id,
+                                     segment.reverse_edge_based_node_id,
+                                     segment.name_id,
+                                     segment.forward_weight,
+                                     segment.reverse_weight,
+                                     segment.forward_offset,
+                                     segment.reverse_offset,
+                                     segment.packed_geometry_id,
+                                     location,
+                                     segment.fwd_segment_position,
+                                     segment.forward_travel_mode,
+                                     segment.backward_travel_mode);
+            // the POI sits on one end of the segment, cf. SetForwardAndReverseWeightsOnPhantomNode
+            if (node == segment.u)
+            {
+                phantom_node.forward_weight = 0;
+            }
+            else
+            {
+                phantom_node.reverse_weight = 0;
+            }
+            snapped_phantoms[poi_index] = phantom_node;
+            snapped_to_big_component[poi_index] = !segment.is_in_tiny_cc;
+        }
+    }
+
+    std::vector<unsigned> snapped_poi_indices;
+    std::vector<FixedPointCoordinate> snapped_locations;
+    for (const auto i : osrm::irange(0u, number_of_pois))
+    {
+        if (snapped_phantoms[i].isValid())
+        {
+            snapped_poi_indices.push_back(i);
+            snapped_locations.push_back(snapped_phantoms[i].location);
+        }
+    }
+
+    // poi ids follow the Hilbert curve, which is the leaf order of the poi index
+    for (const unsigned i : StaticPoiIndex<false>::HilbertOrder(snapped_locations))
+    {
+        const unsigned poi_index = snapped_poi_indices[i];
+        poi_list.emplace_back(snapped_phantoms[poi_index].location, poi_nodes[poi_index].node_id);
+        poi_phantom_list.emplace_back(snapped_phantoms[poi_index]);
+    }
+    SimpleLogger().Write() << "snapped " << poi_list.size() << " of " << number_of_pois
+                           << " pois onto the road network";
+}
+
+/**
+    \brief Runs one backward search per POI and collects the search spaces into buckets
+ */
+void PoiBucketFactory::Run(const QueryGraph &query_graph, const EdgeWeight max_radius)
+{
+    radius = max_radius;
+    SimpleLogger().Write() << "computing backward search spaces of " << poi_phantom_list.size()
+                           << " pois";
+    // Queries start at minus the offset of their source segment, so a bucket entry above the
+    // radius can still be within the radius of a query. The searches run that much further.
+    EdgeWeight search_bound = INVALID_EDGE_WEIGHT;
+    if (INVALID_EDGE_WEIGHT != radius)
+    {
+        search_bound = static_cast<EdgeWeight>(
+            std::min(static_cast<int64_t>(radius) + max_source_offset,
+                     static_cast<int64_t>(INVALID_EDGE_WEIGHT)));
+        SimpleLogger().Write() << "search radius: " << radius << ", bucket bound: "
+                               << search_bound;
+    }
+    TIMER_START(poi_buckets);
+
+    const unsigned number_of_nodes = query_graph.GetNumberOfNodes();
+    tbb::enumerable_thread_specific<std::shared_ptr<PoiSearchThreadData>> thread_data_list;
+
+    tbb::parallel_for(tbb::blocked_range<unsigned>(0, poi_phantom_list.size()),
+        [&](const tbb::blocked_range<unsigned> &range)
+        {
+            auto &thread_data = thread_data_list.local();
+            if (!thread_data)
+            {
+                thread_data = std::make_shared<PoiSearchThreadData>(number_of_nodes);
+            }
+            PoiSearchHeap &heap = thread_data->heap;
+
+            for (unsigned poi_id = range.begin(); poi_id != range.end(); ++poi_id)
+            {
+                const PhantomNode &phantom_node = poi_phantom_list[poi_id];
+                heap.Clear();
+                if (SPECIAL_NODEID != phantom_node.forward_node_id)
+                {
+                    heap.Insert(phantom_node.forward_node_id,
+                                phantom_node.GetForwardWeightPlusOffset(),
+                                PoiSearchHeapData());
+                }
+                if (SPECIAL_NODEID != phantom_node.reverse_node_id)
+                {
+                    heap.Insert(phantom_node.reverse_node_id,
+                                phantom_node.GetReverseWeightPlusOffset(),
+                                PoiSearchHeapData());
+                }
+
+                while (!heap.Empty() && heap.MinKey() <= search_bound)
+                {
+                    const NodeID node = heap.DeleteMin();
+                    const int distance = heap.GetKey(node);
+                    thread_data->settled_buckets.emplace_back(node,
+                                                              PoiBucketEntry(poi_id, distance));
+                    if (StallAtNode(query_graph, node, distance, heap))
+                    {
+                        continue;
+                    }
+                    RelaxIncomingEdges(query_graph, node, distance, search_bound, heap);
+                }
+            }
+        });
+
+    // counting sort of all settled (node, bucket) pairs into the CSR layout
+    bucket_offsets.clear();
+    bucket_offsets.resize(number_of_nodes + 1, 0);
+    for (const auto &thread_data : thread_data_list)
+    {
+        for (const auto &settled : thread_data->settled_buckets)
+        {
+            ++bucket_offsets[settled.first + 1];
+        }
+    }
+    for (const auto node : osrm::irange(0u, number_of_nodes))
+    {
+        bucket_offsets[node + 1] += bucket_offsets[node];
+    }
+
+    bucket_list.resize(bucket_offsets.back());
+    std::vector<unsigned> insert_position(bucket_offsets.begin(), bucket_offsets.end() - 1);
+    for (const auto &thread_data : thread_data_list)
+    {
+        for (const auto &settled : thread_data->settled_buckets)
+        {
+            bucket_list[insert_position[settled.first]++] = settled.second;
+        }
+    }
+
+    TIMER_STOP(poi_buckets);
+    SimpleLogger().Write() << "computed " << bucket_list.size() << " poi buckets in "
+                           << TIMER_SEC(poi_buckets) << "s";
+}
+
+/**
+    \brief Writes POI list, bucket CSR array and POI index to the .poibuckets file
+ */
+void PoiBucketFactory::WriteBuckets(const std::string &bucket_filename,
+                                    const FingerPrint &fingerprint) const
+{
+    boost::filesystem::ofstream bucket_stream(bucket_filename, std::ios::binary);
+    bucket_stream.write((char *)&fingerprint, sizeof(FingerPrint));
+    bucket_stream.write((char *)&radius, sizeof(EdgeWeight));
+
+    const unsigned number_of_pois = poi_list.size();
+    bucket_stream.write((char *)&number_of_pois, sizeof(unsigned));
+    if (number_of_pois > 0)
+    {
+        bucket_stream.write((char *)&poi_list[0], number_of_pois * sizeof(PoiInfo));
+    }
+
+    const unsigned number_of_offsets = bucket_offsets.size();
+    bucket_stream.write((char *)&number_of_offsets, sizeof(unsigned));
+    if (number_of_offsets > 0)
+    {
+        bucket_stream.write((char *)&bucket_offsets[0], number_of_offsets * sizeof(unsigned));
+    }
+
+    const unsigned number_of_buckets = bucket_list.size();
+    bucket_stream.write((char *)&number_of_buckets, sizeof(unsigned));
+    if (number_of_buckets > 0)
+    {
+        bucket_stream.write((char *)&bucket_list[0], number_of_buckets * sizeof(PoiBucketEntry));
+    }
+
+    std::vector<PoiBoundingBox> box_list;
+    StaticPoiIndex<false>::Build(poi_list, box_list);
+    const unsigned number_of_boxes = box_list.size();
+    bucket_stream.write((char *)&number_of_boxes, sizeof(unsigned));
+    if (number_of_boxes > 0)
+    {
+        bucket_stream.write((char *)&box_list[0], number_of_boxes * sizeof(PoiBoundingBox));
+    }
+    bucket_stream.close();
+}
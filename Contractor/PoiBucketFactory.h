@@ -0,0 +1,81 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef POI_BUCKET_FACTORY_H
+#define POI_BUCKET_FACTORY_H
+
+#include "../DataStructures/EdgeBasedNode.h"
+#include "../DataStructures/PhantomNodes.h"
+#include "../DataStructures/PoiBuckets.h"
+#include "../DataStructures/QueryEdge.h"
+#include "../DataStructures/QueryNode.h"
+#include "../DataStructures/StaticGraph.h"
+#include "../Util/FingerPrint.h"
+
+#include <string>
+#include <vector>
+
+/**
+    \brief Precomputes the CH backward search spaces of all POIs of the .poi file
+
+    Every POI is snapped onto a road segment that touches its node. A backward search in the
+    contracted graph is run from each of them and the settled nodes are stored as buckets in a
+    CSR array keyed by CH node id. A poitable query then needs a single forward search only.
+    POI ids are assigned in Hilbert order so that the POI list doubles as leaf level of the
+    StaticPoiIndex.
+ */
+class PoiBucketFactory
+{
+  public:
+    using QueryGraph = StaticGraph<QueryEdge::EdgeData>;
+
+    PoiBucketFactory() = default;
+    PoiBucketFactory(const PoiBucketFactory &) = delete;
+
+    void LoadPois(const std::string &poi_filename,
+                  const std::vector<NodeInfo> &internal_to_external_node_map,
+                  const std::vector<EdgeBasedNode> &node_based_edge_list);
+
+    // queries are answered up to max_radius, INVALID_EDGE_WEIGHT for unbounded searches. The
+    // backward searches also cover the largest source offset a query can start with.
+    void Run(const QueryGraph &query_graph, const EdgeWeight max_radius);
+
+    void WriteBuckets(const std::string &bucket_filename, const FingerPrint &fingerprint) const;
+
+    unsigned GetNumberOfPois() const { return static_cast<unsigned>(poi_list.size()); }
+
+  private:
+    EdgeWeight radius = INVALID_EDGE_WEIGHT;
+    EdgeWeight max_source_offset = 0;
+    std::vector<PoiInfo> poi_list;
+    std::vector<PhantomNode> poi_phantom_list;
+    std::vector<unsigned> bucket_offsets;
+    std::vector<PoiBucketEntry> bucket_list;
+};
+
+#endif // POI_BUCKET_FACTORY_H
@@ -89,6 +89,12 @@ int Prepare::Process(int argc, char *argv[])
         return 1;
     }
 
+    if (1 > rtree_leaf_size)
+    {
+        SimpleLogger().Write(logWARNING) << "R-tree leaf size must be 1 or larger";
+        return 1;
+    }
+
     const unsigned recommended_num_threads = tbb::task_scheduler_init::default_num_threads();
 
     SimpleLogger().Write() << "Input file: " << input_path.filename().string();
@@ -117,6 +123,8 @@ int Prepare::Process(int argc, char *argv[])
     graph_out = input_path.string() + ".hsgr";
     rtree_nodes_path = input_path.string() + ".ramIndex";
     rtree_leafs_path = input_path.string() + ".fileIndex";
+    poi_filename = input_path.string() + ".poi";
+    poi_buckets_filename = input_path.string() + ".poibuckets";
 
     /*** Setup Scripting Environment ***/
     // Create a new lua state
@@ -175,6 +183,9 @@ int Prepare::Process(int argc, char *argv[])
 
     BuildRTree(node_based_edge_list);
 
+    // POIs have to be snapped while the node map and the segments are still around
+    poi_bucket_factory.LoadPois(poi_filename, internal_to_external_node_map, node_based_edge_list);
+
     RangebasedCRC32 crc32;
     if (crc32.using_hardware())
     {
@@ -284,6 +295,8 @@ int Prepare::Process(int argc, char *argv[])
     edge = 0;
     int number_of_used_edges = 0;
 
+    std::vector<StaticGraph<EdgeData>::EdgeArrayEntry> edge_array;
+    edge_array.reserve(contracted_edge_count);
     StaticGraph<EdgeData>::EdgeArrayEntry current_edge;
     for (const auto edge : osrm::irange<std::size_t>(0, contracted_edge_list.size()))
     {
@@ -310,10 +323,14 @@ int Prepare::Process(int argc, char *argv[])
 #endif
         hsgr_output_stream.write((char *)&current_edge,
                                  sizeof(StaticGraph<EdgeData>::EdgeArrayEntry));
+        edge_array.emplace_back(current_edge);
 
         ++number_of_used_edges;
     }
     hsgr_output_stream.close();
+    contracted_edge_list.clear();
+
+    BuildPoiBuckets(node_array, edge_array, fingerprint_orig);
 
     TIMER_STOP(preparing);
 
@@ -363,7 +380,13 @@ bool Prepare::ParseArguments(int argc, char *argv[])
         "threads,t",
         boost::program_options::value<unsigned int>(&requested_num_threads)
             ->default_value(tbb::task_scheduler_init::default_num_threads()),
-        "Number of threads to use");
+        "Number of threads to use")(
+        "poi-radius",
+        boost::program_options::value<unsigned int>(&poi_radius)->default_value(0),
+        "Largest distance limit of POI queries in 1/10 seconds, 0 for unbounded")(
+        "rtree-leaf-size",
+        boost::program_options::value<unsigned int>(&rtree_leaf_size)->default_value(1024),
+        "Number of road segments per r-tree leaf");
 
     // hidden options, will be allowed both on command line and in config file, but will not be
     // shown to the user
@@ -569,9 +592,29 @@ void Prepare::WriteNodeMapping()
  */
 void Prepare::BuildRTree(std::vector<EdgeBasedNode> &node_based_edge_list)
 {
-    SimpleLogger().Write() << "building r-tree ...";
+    SimpleLogger().Write() << "building r-tree with " << rtree_leaf_size << " segments per leaf ...";
     StaticRTree<EdgeBasedNode>(node_based_edge_list,
                                rtree_nodes_path.c_str(),
                                rtree_leafs_path.c_str(),
-                               internal_to_external_node_map);
+                               internal_to_external_node_map,
+                               rtree_leaf_size);
+}
+
+/**
+    \brief Precomputing the backward search spaces of all POIs on the contracted graph
+
+    Saves info to file: '.poibuckets'. Consumes node and edge array of the query graph.
+ */
+void Prepare::BuildPoiBuckets(std::vector<StaticGraph<EdgeData>::NodeArrayEntry> &node_array,
+                              std::vector<StaticGraph<EdgeData>::EdgeArrayEntry> &edge_array,
+                              const FingerPrint &fingerprint)
+{
+    SimpleLogger().Write() << "building poi buckets ...";
+    const PoiBucketFactory::QueryGraph query_graph(node_array, edge_array);
+    const EdgeWeight max_radius =
+        (0 == poi_radius || poi_radius >= static_cast<unsigned>(INVALID_EDGE_WEIGHT))
+            ? INVALID_EDGE_WEIGHT
+            : static_cast<EdgeWeight>(poi_radius);
+    poi_bucket_factory.Run(query_graph, max_radius);
+    poi_bucket_factory.WriteBuckets(poi_buckets_filename, fingerprint);
 }
@@ -2,6 +2,7 @@
 #define PREPARE_H
 
 #include "EdgeBasedGraphFactory.h"
+#include "PoiBucketFactory.h"
 #include "../DataStructures/QueryEdge.h"
 #include "../DataStructures/StaticGraph.h"
 #include "../Util/GraphLoader.h"
@@ -40,6 +41,9 @@ class Prepare
                                        EdgeBasedGraphFactory::SpeedProfileProperties &speed_profile);
     void WriteNodeMapping();
     void BuildRTree(std::vector<EdgeBasedNode> &node_based_edge_list);
+    void BuildPoiBuckets(std::vector<StaticGraph<EdgeData>::NodeArrayEntry> &node_array,
+                         std::vector<StaticGraph<EdgeData>::EdgeArrayEntry> &edge_array,
+                         const FingerPrint &fingerprint);
 
   private:
     std::vector<NodeInfo> internal_to_external_node_map;
@@ -48,8 +52,11 @@ class Prepare
     std::vector<NodeID> traffic_light_list;
     std::vector<NodeID> poi_list;
     std::vector<ImportEdge> edge_list;
+    PoiBucketFactory poi_bucket_factory;
 
     unsigned requested_num_threads;
+    unsigned poi_radius;
+    unsigned rtree_leaf_size;
     boost::filesystem::path config_file_path;
     boost::filesystem::path input_path;
     boost::filesystem::path restrictions_path;
@@ -63,6 +70,8 @@ class Prepare
     std::string graph_out;
     std::string rtree_nodes_path;
     std::string rtree_leafs_path;
+    std::string poi_filename;
+    std::string poi_buckets_filename;
 };
 
 #endif // PREPARE_H
@@ -56,6 +56,58 @@ template <typename NodeID, typename Key> class ArrayStorage
     Key *positions;
 };
 
+// Dense array storage that is cleared in O(1). Every entry remembers the generation in which it
+// was last written, entries of older generations read as unset. Clear() starts a new generation.
+template <typename NodeID, typename Key> class TimestampedArrayStorage
+{
+  public:
+    explicit TimestampedArrayStorage(size_t size) : entries(size), generation(1) {}
+
+    Key &operator[](const NodeID node)
+    {
+        BOOST_ASSERT(node < entries.size());
+        Entry &entry = entries[node];
+        if (entry.generation != generation)
+        {
+            entry.generation = generation;
+            entry.position = std::numeric_limits<Key>::max();
+        }
+        return entry.position;
+    }
+
+    Key const &operator[](const NodeID node) const
+    {
+        BOOST_ASSERT(node < entries.size());
+        BOOST_ASSERT(entries[node].generation == generation);
+        return entries[node].position;
+    }
+
+    void Clear()
+    {
+        ++generation;
+        // after a wrap around stale entries could alias the new generation
+        if (0 == generation)
+        {
+            for (Entry &entry : entries)
+            {
+                entry.generation = 0;
+            }
+            generation = 1;
+        }
+    }
+
+  private:
+    struct Entry
+    {
+        Entry() : position(std::numeric_limits<Key>::max()), generation(0) {}
+        Key position;
+        unsigned generation;
+    };
+
+    std::vector<Entry> entries;
+    unsigned generation;
+};
+
 template <typename NodeID, typename Key> class MapStorage
 {
   public:
@@ -103,7 +155,10 @@ class BinaryHeap
     using WeightType = Weight;
     using DataType = Data;
 
-    explicit BinaryHeap(size_t maxID) : node_index(maxID) { Clear(); }
+    explicit BinaryHeap(size_t maxID) : node_index(maxID), max_id(maxID) { Clear(); }
+
+    // number of node ids the index storage was created for
+    std::size_t MaxID() const { return max_id; }
 
     void Clear()
     {
@@ -171,6 +226,12 @@ class BinaryHeap
         return inserted_nodes[heap[1].index].node;
     }
 
+    Weight MinKey() const
+    {
+        BOOST_ASSERT(heap.size() > 1);
+        return heap[1].weight;
+    }
+
     NodeID DeleteMin()
     {
         BOOST_ASSERT(heap.size() > 1);
@@ -230,6 +291,7 @@ class BinaryHeap
     std::vector<HeapNode> inserted_nodes;
     std::vector<HeapElement> heap;
     IndexStorage node_index;
+    std::size_t max_id;
 
     void Downheap(Key key)
     {
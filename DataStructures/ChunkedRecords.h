@@ -0,0 +1,326 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef CHUNKED_RECORDS_H
+#define CHUNKED_RECORDS_H
+
+#include "ImportNode.h"
+#include "TravelMode.h"
+#include "../Util/OSRMException.h"
+#include "../typedefs.h"
+
+#include <boost/crc.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+// The node and edge sections of an .osrm file are sequences of chunks behind a format header.
+// A chunk starts with its record count, its payload size and a CRC32 of the payload. Records are
+// delta and varint encoded against the previous record of the same chunk, so each chunk is
+// verified and decoded on its own and a reader can work on several chunks at once.
+
+// edge as written by the extractor, before its ids are translated
+struct ExtractedEdge
+{
+    NodeID source;
+    NodeID target;
+    int length;
+    short direction;
+    int weight;
+    unsigned name_id;
+    bool is_roundabout;
+    bool is_in_tiny_cc;
+    bool is_access_restricted;
+    TravelMode travel_mode;
+    bool is_split;
+};
+
+namespace chunked_records
+{
+
+// refuse to allocate for a chunk header that is garbage
+static const uint32_t MAX_PAYLOAD_SIZE = 64 * 1024 * 1024;
+
+// written in front of the node section, files of the former raw struct format lack it
+static const char FORMAT_MAGIC[4] = {'O', 'C', 'H', 'K'};
+static const uint32_t FORMAT_VERSION = 1;
+
+inline uint64_t ZigZagEncode(const int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t ZigZagDecode(const uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline void AppendVarInt(uint64_t value, std::vector<char> &payload)
+{
+    while (value >= 0x80)
+    {
+        payload.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    payload.push_back(static_cast<char>(value));
+}
+
+inline uint64_t ReadVarInt(const char *&position, const char *end)
+{
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        if (position == end)
+        {
+            throw OSRMException("truncated record in .osrm chunk");
+        }
+        const uint8_t byte = static_cast<uint8_t>(*position++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (0 == (byte & 0x80))
+        {
+            return value;
+        }
+    }
+    throw OSRMException("malformed varint in .osrm chunk");
+}
+
+inline uint32_t ComputeChecksum(const std::vector<char> &payload)
+{
+    boost::crc_32_type crc;
+    crc.process_bytes(payload.data(), payload.size());
+    return crc.checksum();
+}
+
+class ChunkEncoder
+{
+  public:
+    ChunkEncoder() : number_of_records(0) {}
+
+    std::size_t size() const { return payload.size(); }
+    bool empty() const { return 0 == number_of_records; }
+
+    void Write(std::ostream &output_stream) const
+    {
+        if (empty())
+        {
+            return;
+        }
+        const uint32_t payload_size = static_cast<uint32_t>(payload.size());
+        const uint32_t checksum = ComputeChecksum(payload);
+        output_stream.write((char *)&number_of_records, sizeof(uint32_t));
+        output_stream.write((char *)&payload_size, sizeof(uint32_t));
+        output_stream.write((char *)&checksum, sizeof(uint32_t));
+        output_stream.write(payload.data(), payload.size());
+    }
+
+  protected:
+    void Reset()
+    {
+        payload.clear();
+        number_of_records = 0;
+    }
+
+    std::vector<char> payload;
+    uint32_t number_of_records;
+};
+
+class NodeChunkEncoder : public ChunkEncoder
+{
+  public:
+    NodeChunkEncoder() { clear(); }
+
+    void clear()
+    {
+        Reset();
+        previous_node = ExternalMemoryNode(0, 0, 0, false, false, false);
+    }
+
+    void Append(const ExternalMemoryNode &node)
+    {
+        AppendVarInt(ZigZagEncode(static_cast<int64_t>(node.node_id) - previous_node.node_id),
+                     payload);
+        AppendVarInt(ZigZagEncode(static_cast<int64_t>(node.lat) - previous_node.lat), payload);
+        AppendVarInt(ZigZagEncode(static_cast<int64_t>(node.lon) - previous_node.lon), payload);
+        payload.push_back(static_cast<char>((node.bollard ? 1 : 0) | (node.trafficLight ? 2 : 0) |
+                                            (node.poi ? 4 : 0)));
+        previous_node = node;
+        ++number_of_records;
+    }
+
+  private:
+    ExternalMemoryNode previous_node;
+};
+
+class EdgeChunkEncoder : public ChunkEncoder
+{
+  public:
+    EdgeChunkEncoder() : previous_target(0) {}
+
+    void clear()
+    {
+        Reset();
+        previous_target = 0;
+    }
+
+    void Append(const ExtractedEdge &edge)
+    {
+        // edges are sorted by target and mostly connect nodes with nearby ids
+        AppendVarInt(ZigZagEncode(static_cast<int64_t>(edge.target) - previous_target), payload);
+        AppendVarInt(ZigZagEncode(static_cast<int64_t>(edge.source) - edge.target), payload);
+        AppendVarInt(ZigZagEncode(edge.length), payload);
+        AppendVarInt(ZigZagEncode(edge.weight), payload);
+        AppendVarInt(edge.name_id, payload);
+        payload.push_back(static_cast<char>((edge.direction & 3) | (edge.is_roundabout ? 4 : 0) |
+                                            (edge.is_in_tiny_cc ? 8 : 0) |
+                                            (edge.is_access_restricted ? 16 : 0) |
+                                            (edge.is_split ? 32 : 0)));
+        payload.push_back(static_cast<char>(edge.travel_mode));
+        previous_target = edge.target;
+        ++number_of_records;
+    }
+
+  private:
+    NodeID previous_target;
+};
+
+inline void WriteFormatHeader(std::ostream &output_stream)
+{
+    output_stream.write(FORMAT_MAGIC, sizeof(FORMAT_MAGIC));
+    output_stream.write((char *)&FORMAT_VERSION, sizeof(uint32_t));
+}
+
+inline void ReadFormatHeader(std::istream &input_stream)
+{
+    char magic[sizeof(FORMAT_MAGIC)];
+    uint32_t version = 0;
+    input_stream.read(magic, sizeof(FORMAT_MAGIC));
+    input_stream.read((char *)&version, sizeof(uint32_t));
+    if (!input_stream || !std::equal(magic, magic + sizeof(FORMAT_MAGIC), FORMAT_MAGIC))
+    {
+        throw OSRMException(".osrm file has an unknown format, re-run osrm-extract");
+    }
+    if (FORMAT_VERSION != version)
+    {
+        throw OSRMException(".osrm file has an unsupported version, re-run osrm-extract");
+    }
+}
+
+struct Chunk
+{
+    uint32_t number_of_records;
+    uint32_t checksum;
+    std::vector<char> payload;
+};
+
+// Reads the next chunk, the checksum is verified when the chunk is decoded.
+inline void ReadChunk(std::istream &input_stream, Chunk &chunk)
+{
+    uint32_t payload_size = 0;
+    input_stream.read((char *)&chunk.number_of_records, sizeof(uint32_t));
+    input_stream.read((char *)&payload_size, sizeof(uint32_t));
+    input_stream.read((char *)&chunk.checksum, sizeof(uint32_t));
+    if (!input_stream || 0 == chunk.number_of_records || MAX_PAYLOAD_SIZE < payload_size)
+    {
+        throw OSRMException("broken chunk header in .osrm file, re-run osrm-extract");
+    }
+    chunk.payload.resize(payload_size);
+    input_stream.read(chunk.payload.data(), payload_size);
+    if (!input_stream)
+    {
+        throw OSRMException("truncated .osrm file");
+    }
+}
+
+inline void VerifyChunk(const Chunk &chunk)
+{
+    if (ComputeChecksum(chunk.payload) != chunk.checksum)
+    {
+        throw OSRMException("checksum mismatch in .osrm file");
+    }
+}
+
+inline void DecodeNodes(const Chunk &chunk, std::vector<ExternalMemoryNode> &nodes)
+{
+    VerifyChunk(chunk);
+    nodes.clear();
+    nodes.reserve(chunk.number_of_records);
+    const char *position = chunk.payload.data();
+    const char *end = position + chunk.payload.size();
+    int64_t node_id = 0, lat = 0, lon = 0;
+    for (uint32_t i = 0; i < chunk.number_of_records; ++i)
+    {
+        node_id += ZigZagDecode(ReadVarInt(position, end));
+        lat += ZigZagDecode(ReadVarInt(position, end));
+        lon += ZigZagDecode(ReadVarInt(position, end));
+        if (position == end)
+        {
+            throw OSRMException("truncated record in .osrm chunk");
+        }
+        const uint8_t flags = static_cast<uint8_t>(*position++);
+        nodes.emplace_back(static_cast<int>(lat),
+                           static_cast<int>(lon),
+                           static_cast<NodeID>(node_id),
+                           0 != (flags & 1),
+                           0 != (flags & 2),
+                           0 != (flags & 4));
+    }
+}
+
+inline void DecodeEdges(const Chunk &chunk, std::vector<ExtractedEdge> &edges)
+{
+    VerifyChunk(chunk);
+    edges.resize(chunk.number_of_records);
+    const char *position = chunk.payload.data();
+    const char *end = position + chunk.payload.size();
+    int64_t target = 0;
+    for (ExtractedEdge &edge : edges)
+    {
+        target += ZigZagDecode(ReadVarInt(position, end));
+        edge.target = static_cast<NodeID>(target);
+        edge.source = static_cast<NodeID>(target + ZigZagDecode(ReadVarInt(position, end)));
+        edge.length = static_cast<int>(ZigZagDecode(ReadVarInt(position, end)));
+        edge.weight = static_cast<int>(ZigZagDecode(ReadVarInt(position, end)));
+        edge.name_id = static_cast<unsigned>(ReadVarInt(position, end));
+        if (end - position < 2)
+        {
+            throw OSRMException("truncated record in .osrm chunk");
+        }
+        const uint8_t flags = static_cast<uint8_t>(*position++);
+        edge.direction = static_cast<short>(flags & 3);
+        edge.is_roundabout = 0 != (flags & 4);
+        edge.is_in_tiny_cc = 0 != (flags & 8);
+        edge.is_access_restricted = 0 != (flags & 16);
+        edge.is_split = 0 != (flags & 32);
+        edge.travel_mode = static_cast<TravelMode>(*position++);
+    }
+}
+}
+
+#endif // CHUNKED_RECORDS_H
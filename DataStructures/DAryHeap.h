@@ -0,0 +1,263 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef D_ARY_HEAP_H
+#define D_ARY_HEAP_H
+
+#include "BinaryHeap.h"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Drop-in replacement for BinaryHeap with Arity children per heap element. With the default of
+// four, all children of an element share a cache line and the heap is half as deep.
+template <typename NodeID,
+          typename Key,
+          typename Weight,
+          typename Data,
+          typename IndexStorage = ArrayStorage<NodeID, NodeID>,
+          unsigned Arity = 4>
+class DAryHeap
+{
+  private:
+    static_assert(Arity >= 2, "a heap needs at least two children per element");
+
+    DAryHeap(const DAryHeap &right);
+    void operator=(const DAryHeap &right);
+
+  public:
+    using WeightType = Weight;
+    using DataType = Data;
+
+    explicit DAryHeap(size_t maxID) : node_index(maxID), max_id(maxID) { Clear(); }
+
+    // number of node ids the index storage was created for
+    std::size_t MaxID() const { return max_id; }
+
+    void Clear()
+    {
+        heap.clear();
+        inserted_nodes.clear();
+        node_index.Clear();
+    }
+
+    std::size_t Size() const { return heap.size(); }
+
+    bool Empty() const { return heap.empty(); }
+
+    void Insert(NodeID node, Weight weight, const Data &data)
+    {
+        HeapElement element;
+        element.index = static_cast<Key>(inserted_nodes.size());
+        element.weight = weight;
+        const Key key = static_cast<Key>(heap.size());
+        heap.emplace_back(element);
+        inserted_nodes.emplace_back(node, key, weight, data);
+        node_index[node] = element.index;
+        Upheap(key);
+        CheckHeap();
+    }
+
+    Data &GetData(NodeID node)
+    {
+        const Key index = node_index[node];
+        return inserted_nodes[index].data;
+    }
+
+    Data const &GetData(NodeID node) const
+    {
+        const Key index = node_index[node];
+        return inserted_nodes[index].data;
+    }
+
+    Weight &GetKey(NodeID node)
+    {
+        const Key index = node_index[node];
+        return inserted_nodes[index].weight;
+    }
+
+    bool WasRemoved(const NodeID node)
+    {
+        BOOST_ASSERT(WasInserted(node));
+        const Key index = node_index[node];
+        return inserted_nodes[index].key == REMOVED_KEY;
+    }
+
+    bool WasInserted(const NodeID node)
+    {
+        const Key index = node_index[node];
+        if (index >= static_cast<Key>(inserted_nodes.size()))
+        {
+            return false;
+        }
+        return inserted_nodes[index].node == node;
+    }
+
+    NodeID Min() const
+    {
+        BOOST_ASSERT(!heap.empty());
+        return inserted_nodes[heap.front().index].node;
+    }
+
+    Weight MinKey() const
+    {
+        BOOST_ASSERT(!heap.empty());
+        return heap.front().weight;
+    }
+
+    NodeID DeleteMin()
+    {
+        BOOST_ASSERT(!heap.empty());
+        const Key removed_index = heap.front().index;
+        heap.front() = heap.back();
+        heap.pop_back();
+        if (!heap.empty())
+        {
+            Downheap(0);
+        }
+        inserted_nodes[removed_index].key = REMOVED_KEY;
+        CheckHeap();
+        return inserted_nodes[removed_index].node;
+    }
+
+    void DeleteAll()
+    {
+        for (const HeapElement &element : heap)
+        {
+            inserted_nodes[element.index].key = REMOVED_KEY;
+        }
+        heap.clear();
+    }
+
+    void DecreaseKey(NodeID node, Weight weight)
+    {
+        BOOST_ASSERT(std::numeric_limits<NodeID>::max() != node);
+        const Key index = node_index[node];
+        const Key key = inserted_nodes[index].key;
+        BOOST_ASSERT(REMOVED_KEY != key);
+
+        inserted_nodes[index].weight = weight;
+        heap[key].weight = weight;
+        Upheap(key);
+        CheckHeap();
+    }
+
+  private:
+    static constexpr Key REMOVED_KEY = std::numeric_limits<Key>::max();
+
+    class HeapNode
+    {
+      public:
+        HeapNode(NodeID n, Key k, Weight w, Data d) : node(n), key(k), weight(w), data(d) {}
+
+        NodeID node;
+        Key key;
+        Weight weight;
+        Data data;
+    };
+    struct HeapElement
+    {
+        Key index;
+        Weight weight;
+    };
+
+    std::vector<HeapNode> inserted_nodes;
+    std::vector<HeapElement> heap;
+    IndexStorage node_index;
+    std::size_t max_id;
+
+    void Downheap(Key key)
+    {
+        const HeapElement dropping = heap[key];
+        const Key heap_size = static_cast<Key>(heap.size());
+        Key first_child = key * Arity + 1;
+        while (first_child < heap_size)
+        {
+            const Key last_child = std::min(static_cast<Key>(first_child + Arity), heap_size);
+            Key min_child = first_child;
+            for (Key child = first_child + 1; child < last_child; ++child)
+            {
+                if (heap[child].weight < heap[min_child].weight)
+                {
+                    min_child = child;
+                }
+            }
+            if (dropping.weight <= heap[min_child].weight)
+            {
+                break;
+            }
+            heap[key] = heap[min_child];
+            inserted_nodes[heap[key].index].key = key;
+            key = min_child;
+            first_child = key * Arity + 1;
+        }
+        heap[key] = dropping;
+        inserted_nodes[dropping.index].key = key;
+    }
+
+    void Upheap(Key key)
+    {
+        const HeapElement rising = heap[key];
+        while (key > 0)
+        {
+            const Key parent = (key - 1) / Arity;
+            if (heap[parent].weight <= rising.weight)
+            {
+                break;
+            }
+            heap[key] = heap[parent];
+            inserted_nodes[heap[key].index].key = key;
+            key = parent;
+        }
+        heap[key] = rising;
+        inserted_nodes[rising.index].key = key;
+    }
+
+    void CheckHeap()
+    {
+#ifndef NDEBUG
+        for (Key i = 1; i < static_cast<Key>(heap.size()); ++i)
+        {
+            BOOST_ASSERT(heap[i].weight >= heap[(i - 1) / Arity].weight);
+        }
+#endif
+    }
+};
+
+template <typename NodeID,
+          typename Key,
+          typename Weight,
+          typename Data,
+          typename IndexStorage,
+          unsigned Arity>
+constexpr Key DAryHeap<NodeID, Key, Weight, Data, IndexStorage, Arity>::REMOVED_KEY;
+
+#endif // D_ARY_HEAP_H
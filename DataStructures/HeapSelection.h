@@ -0,0 +1,49 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef HEAP_SELECTION_H
+#define HEAP_SELECTION_H
+
+#include "BinaryHeap.h"
+#include "DAryHeap.h"
+#include "RadixHeap.h"
+
+// Picks the priority queue of the query searches and the contractor's witness searches at
+// compile time. Configure with -DHEAP_TYPE=binary|dary|radix, binary is the default.
+#if defined(OSRM_USE_DARY_HEAP)
+template <typename NodeID, typename Key, typename Weight, typename Data, typename IndexStorage>
+using SelectedHeap = DAryHeap<NodeID, Key, Weight, Data, IndexStorage>;
+#elif defined(OSRM_USE_RADIX_HEAP)
+template <typename NodeID, typename Key, typename Weight, typename Data, typename IndexStorage>
+using SelectedHeap = RadixHeap<NodeID, Key, Weight, Data, IndexStorage>;
+#else
+template <typename NodeID, typename Key, typename Weight, typename Data, typename IndexStorage>
+using SelectedHeap = BinaryHeap<NodeID, Key, Weight, Data, IndexStorage>;
+#endif
+
+#endif // HEAP_SELECTION_H
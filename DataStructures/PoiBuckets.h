@@ -0,0 +1,70 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef POI_BUCKETS_H
+#define POI_BUCKETS_H
+
+#include "../typedefs.h"
+
+#include <osrm/Coordinate.h>
+
+#include <limits>
+
+// The .poibuckets file holds the backward search spaces of all POIs in the contracted graph.
+// Layout: fingerprint, search radius, POI list, bucket offsets (one per CH node plus sentinel),
+// bucket entries, boxes of the StaticPoiIndex. The buckets of CH node n are the entries in
+// [offsets[n], offsets[n+1]).
+// Backward searches stop at the radius, so queries with a larger limit get clamped to it.
+
+struct PoiInfo
+{
+    PoiInfo() : osm_id(std::numeric_limits<unsigned>::max()) {}
+    PoiInfo(const FixedPointCoordinate &location, const NodeID osm_id)
+        : location(location), osm_id(osm_id)
+    {
+    }
+
+    FixedPointCoordinate location;
+    NodeID osm_id;
+};
+
+struct PoiBucketEntry
+{
+    PoiBucketEntry() : poi_id(std::numeric_limits<unsigned>::max()), distance(INVALID_EDGE_WEIGHT)
+    {
+    }
+    PoiBucketEntry(const unsigned poi_id, const EdgeWeight distance)
+        : poi_id(poi_id), distance(distance)
+    {
+    }
+
+    unsigned poi_id; // index into the POI list
+    EdgeWeight distance;
+};
+
+#endif // POI_BUCKETS_H
@@ -0,0 +1,295 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef RADIX_HEAP_H
+#define RADIX_HEAP_H
+
+#include "BinaryHeap.h"
+
+#include <boost/assert.hpp>
+
+#include <array>
+#include <climits>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+// Monotone radix heap for integral weights, with the same interface as BinaryHeap. Bucket i > 0
+// holds the elements whose weight differs from the last extracted minimum first in bit i-1,
+// bucket 0 the ones equal to it. Keys may be arbitrary until the first extraction, afterwards
+// inserted and decreased keys must not be smaller than the last extracted minimum. This holds
+// for all Dijkstra-like searches. Min() and MinKey() redistribute buckets and are not const.
+template <typename NodeID,
+          typename Key,
+          typename Weight,
+          typename Data,
+          typename IndexStorage = ArrayStorage<NodeID, NodeID>>
+class RadixHeap
+{
+  private:
+    static_assert(std::is_integral<Weight>::value, "radix heaps need integral weights");
+
+    using RadixType = typename std::make_unsigned<Weight>::type;
+    static constexpr unsigned NUMBER_OF_BUCKETS = sizeof(Weight) * CHAR_BIT + 1;
+    static constexpr unsigned REMOVED_BUCKET = std::numeric_limits<unsigned>::max();
+
+    RadixHeap(const RadixHeap &right);
+    void operator=(const RadixHeap &right);
+
+  public:
+    using WeightType = Weight;
+    using DataType = Data;
+
+    explicit RadixHeap(size_t maxID) : node_index(maxID), max_id(maxID) { Clear(); }
+
+    // number of node ids the index storage was created for
+    std::size_t MaxID() const { return max_id; }
+
+    void Clear()
+    {
+        for (std::vector<Key> &bucket : buckets)
+        {
+            bucket.clear();
+        }
+        inserted_nodes.clear();
+        node_index.Clear();
+        last_min = 0;
+        number_of_elements = 0;
+    }
+
+    std::size_t Size() const { return number_of_elements; }
+
+    bool Empty() const { return 0 == number_of_elements; }
+
+    void Insert(NodeID node, Weight weight, const Data &data)
+    {
+        const Key index = static_cast<Key>(inserted_nodes.size());
+        inserted_nodes.emplace_back(node, weight, data);
+        node_index[node] = index;
+        PushToBucket(index);
+        ++number_of_elements;
+    }
+
+    Data &GetData(NodeID node)
+    {
+        const Key index = node_index[node];
+        return inserted_nodes[index].data;
+    }
+
+    Data const &GetData(NodeID node) const
+    {
+        const Key index = node_index[node];
+        return inserted_nodes[index].data;
+    }
+
+    Weight &GetKey(NodeID node)
+    {
+        const Key index = node_index[node];
+        return inserted_nodes[index].weight;
+    }
+
+    bool WasRemoved(const NodeID node)
+    {
+        BOOST_ASSERT(WasInserted(node));
+        const Key index = node_index[node];
+        return inserted_nodes[index].bucket == REMOVED_BUCKET;
+    }
+
+    bool WasInserted(const NodeID node)
+    {
+        const Key index = node_index[node];
+        if (index >= static_cast<Key>(inserted_nodes.size()))
+        {
+            return false;
+        }
+        return inserted_nodes[index].node == node;
+    }
+
+    NodeID Min()
+    {
+        BOOST_ASSERT(!Empty());
+        RefillFirstBucket();
+        return inserted_nodes[buckets[0].back()].node;
+    }
+
+    Weight MinKey()
+    {
+        BOOST_ASSERT(!Empty());
+        RefillFirstBucket();
+        return inserted_nodes[buckets[0].back()].weight;
+    }
+
+    NodeID DeleteMin()
+    {
+        BOOST_ASSERT(!Empty());
+        RefillFirstBucket();
+        const Key removed_index = buckets[0].back();
+        buckets[0].pop_back();
+        inserted_nodes[removed_index].bucket = REMOVED_BUCKET;
+        --number_of_elements;
+        return inserted_nodes[removed_index].node;
+    }
+
+    void DeleteAll()
+    {
+        for (std::vector<Key> &bucket : buckets)
+        {
+            for (const Key index : bucket)
+            {
+                inserted_nodes[index].bucket = REMOVED_BUCKET;
+            }
+            bucket.clear();
+        }
+        number_of_elements = 0;
+    }
+
+    void DecreaseKey(NodeID node, Weight weight)
+    {
+        BOOST_ASSERT(std::numeric_limits<NodeID>::max() != node);
+        const Key index = node_index[node];
+        BOOST_ASSERT(REMOVED_BUCKET != inserted_nodes[index].bucket);
+
+        RemoveFromBucket(index);
+        inserted_nodes[index].weight = weight;
+        PushToBucket(index);
+    }
+
+  private:
+    class HeapNode
+    {
+      public:
+        HeapNode(NodeID n, Weight w, Data d)
+            : node(n), weight(w), data(d), bucket(REMOVED_BUCKET), position(0)
+        {
+        }
+
+        NodeID node;
+        Weight weight;
+        Data data;
+        unsigned bucket;
+        Key position;
+    };
+
+    std::vector<HeapNode> inserted_nodes;
+    std::array<std::vector<Key>, NUMBER_OF_BUCKETS> buckets;
+    std::vector<Key> redistributed_indices;
+    IndexStorage node_index;
+    std::size_t max_id;
+    RadixType last_min;
+    std::size_t number_of_elements;
+
+    // order preserving map onto unsigned integers, flips the sign bit of signed weights
+    static RadixType ToRadix(const Weight weight)
+    {
+        const RadixType sign_flip =
+            std::is_signed<Weight>::value ? (RadixType(1) << (sizeof(Weight) * CHAR_BIT - 1)) : 0;
+        return static_cast<RadixType>(weight) ^ sign_flip;
+    }
+
+    unsigned BucketIndex(const RadixType radix) const
+    {
+        BOOST_ASSERT_MSG(radix >= last_min, "radix heap keys have to be monotone");
+        if (radix == last_min)
+        {
+            return 0;
+        }
+        return MostSignificantBit(radix ^ last_min) + 1;
+    }
+
+    static unsigned MostSignificantBit(RadixType value)
+    {
+        BOOST_ASSERT(0 != value);
+#if defined(__GNUC__)
+        return static_cast<unsigned>(sizeof(unsigned long long) * CHAR_BIT - 1 -
+                                     __builtin_clzll(static_cast<unsigned long long>(value)));
+#else
+        unsigned bit = 0;
+        while (value >>= 1)
+        {
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    void PushToBucket(const Key index)
+    {
+        HeapNode &heap_node = inserted_nodes[index];
+        heap_node.bucket = BucketIndex(ToRadix(heap_node.weight));
+        std::vector<Key> &bucket = buckets[heap_node.bucket];
+        heap_node.position = static_cast<Key>(bucket.size());
+        bucket.push_back(index);
+    }
+
+    void RemoveFromBucket(const Key index)
+    {
+        const HeapNode &heap_node = inserted_nodes[index];
+        std::vector<Key> &bucket = buckets[heap_node.bucket];
+        const Key moved_index = bucket.back();
+        bucket[heap_node.position] = moved_index;
+        inserted_nodes[moved_index].position = heap_node.position;
+        bucket.pop_back();
+    }
+
+    // moves the elements of the first non-empty bucket into lower buckets relative to their
+    // minimum, afterwards bucket 0 holds all elements with the minimum weight
+    void RefillFirstBucket()
+    {
+        if (!buckets[0].empty())
+        {
+            return;
+        }
+        unsigned first_non_empty = 1;
+        while (buckets[first_non_empty].empty())
+        {
+            ++first_non_empty;
+            BOOST_ASSERT(first_non_empty < NUMBER_OF_BUCKETS);
+        }
+
+        redistributed_indices.swap(buckets[first_non_empty]);
+        RadixType new_min = std::numeric_limits<RadixType>::max();
+        for (const Key index : redistributed_indices)
+        {
+            new_min = std::min(new_min, ToRadix(inserted_nodes[index].weight));
+        }
+        last_min = new_min;
+        for (const Key index : redistributed_indices)
+        {
+            PushToBucket(index);
+        }
+        redistributed_indices.clear();
+    }
+};
+
+template <typename NodeID, typename Key, typename Weight, typename Data, typename IndexStorage>
+constexpr unsigned RadixHeap<NodeID, Key, Weight, Data, IndexStorage>::NUMBER_OF_BUCKETS;
+
+template <typename NodeID, typename Key, typename Weight, typename Data, typename IndexStorage>
+constexpr unsigned RadixHeap<NodeID, Key, Weight, Data, IndexStorage>::REMOVED_BUCKET;
+
+#endif // RADIX_HEAP_H
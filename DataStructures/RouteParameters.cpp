@@ -32,9 +32,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/fusion/sequence/intrinsic.hpp>
 #include <boost/fusion/include/at_c.hpp>
 
+#include <limits>
+
 RouteParameters::RouteParameters()
     : zoom_level(18), print_instructions(false), alternate_route(true), geometry(true),
-compression(true), deprecatedAPI(false), uturn_default(false), check_sum(-1), num_results(1), distance_limit(std::numeric_limits<unsigned>::max())
+compression(true), deprecatedAPI(false), uturn_default(false), check_sum(-1), num_results(1), distance_limit(std::numeric_limits<unsigned>::max()),
+      radius(0), pois(false)
 {
 }
 
@@ -115,7 +118,26 @@ RouteParameters::addCoordinate(const boost::fusion::vector<double, double> &tran
     coordinates.emplace_back(
         static_cast<int>(COORDINATE_PRECISION * boost::fusion::at_c<0>(transmitted_coordinates)),
         static_cast<int>(COORDINATE_PRECISION * boost::fusion::at_c<1>(transmitted_coordinates)));
+    is_source.push_back(true);
+    is_destination.push_back(true);
+}
+
+void RouteParameters::addSource(const boost::fusion::vector<double, double> &transmitted_coordinates)
+{
+    addCoordinate(transmitted_coordinates);
+    is_destination.back() = false;
+}
+
+void
+RouteParameters::addDestination(const boost::fusion::vector<double, double> &transmitted_coordinates)
+{
+    addCoordinate(transmitted_coordinates);
+    is_source.back() = false;
 }
 
 void
 RouteParameters::setDistanceLimit( const unsigned dlimit ) { distance_limit = dlimit; }
+
+void RouteParameters::setRadius(const unsigned radius_in_meters) { radius = radius_in_meters; }
+
+void RouteParameters::setPoiFlag(const bool flag) { pois = flag; }
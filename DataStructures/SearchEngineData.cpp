@@ -29,65 +29,62 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "BinaryHeap.h"
 
-void SearchEngineData::InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes)
+namespace
+{
+// The heaps index their storage by node id. Their size has to follow the number of nodes, which
+// changes when a different data set gets loaded into shared memory.
+template <class HeapPtrT>
+void InitializeOrClearHeap(HeapPtrT &heap, const unsigned number_of_nodes)
 {
-    if (forwardHeap.get())
+    if (heap.get() && number_of_nodes == heap->MaxID())
     {
-        forwardHeap->Clear();
+        heap->Clear();
     }
     else
     {
-        forwardHeap.reset(new QueryHeap(number_of_nodes));
+        heap.reset(new SearchEngineData::QueryHeap(number_of_nodes));
     }
+}
+}
 
-    if (backwardHeap.get())
-    {
-        backwardHeap->Clear();
-    }
-    else
-    {
-        backwardHeap.reset(new QueryHeap(number_of_nodes));
-    }
+void SearchEngineData::InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes)
+{
+    InitializeOrClearHeap(forwardHeap, number_of_nodes);
+    InitializeOrClearHeap(backwardHeap, number_of_nodes);
 }
 
 void SearchEngineData::InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes)
 {
-    if (forwardHeap2.get())
-    {
-        forwardHeap2->Clear();
-    }
-    else
-    {
-        forwardHeap2.reset(new QueryHeap(number_of_nodes));
-    }
-
-    if (backwardHeap2.get())
-    {
-        backwardHeap2->Clear();
-    }
-    else
-    {
-        backwardHeap2.reset(new QueryHeap(number_of_nodes));
-    }
+    InitializeOrClearHeap(forwardHeap2, number_of_nodes);
+    InitializeOrClearHeap(backwardHeap2, number_of_nodes);
 }
 
 void SearchEngineData::InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes)
 {
-    if (forwardHeap3.get())
-    {
-        forwardHeap3->Clear();
-    }
-    else
-    {
-        forwardHeap3.reset(new QueryHeap(number_of_nodes));
-    }
+    InitializeOrClearHeap(forwardHeap3, number_of_nodes);
+    InitializeOrClearHeap(backwardHeap3, number_of_nodes);
+}
+
+void SearchEngineData::InitializeOrClearPoiThreadLocalStorage(const unsigned number_of_nodes,
+                                                              const unsigned number_of_pois)
+{
+    InitializeOrClearHeap(forwardHeap, number_of_nodes);
 
-    if (backwardHeap3.get())
+    // the number of pois changes when a different data set gets loaded into shared memory
+    if (poiDistanceArena.get() && number_of_pois == poiDistanceArena->GetNumberOfPois())
     {
-        backwardHeap3->Clear();
+        poiDistanceArena->Clear();
     }
     else
     {
-        backwardHeap3.reset(new QueryHeap(number_of_nodes));
+        poiDistanceArena.reset(new PoiDistanceArena(number_of_pois));
     }
 }
+
+SearchEngineData::QueryHeap &
+SearchEngineData::InitializeOrClearPooledHeap(const unsigned number_of_nodes)
+{
+    std::shared_ptr<QueryHeap> &heap = pooledHeaps.local();
+    InitializeOrClearHeap(heap, number_of_nodes);
+    return *heap;
+}
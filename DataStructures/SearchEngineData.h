@@ -28,10 +28,16 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef SEARCH_ENGINE_DATA_H
 #define SEARCH_ENGINE_DATA_H
 
+#include <boost/assert.hpp>
 #include <boost/thread/tss.hpp>
 
+#include <tbb/enumerable_thread_specific.h>
+
 #include "../typedefs.h"
-#include "BinaryHeap.h"
+#include "HeapSelection.h"
+
+#include <memory>
+#include <vector>
 
 struct HeapData
 {
@@ -39,10 +45,58 @@ struct HeapData
     /* explicit */ HeapData(NodeID p) : parent(p) {}
 };
 
+// Result storage of a one-to-all poi query. The distance array is sized to the number of pois once
+// per thread and only the entries touched by the previous query are reset.
+class PoiDistanceArena
+{
+  public:
+    explicit PoiDistanceArena(const unsigned number_of_pois)
+        : distances(number_of_pois, INVALID_EDGE_WEIGHT)
+    {
+    }
+
+    void Clear()
+    {
+        for (const unsigned poi_id : touched_pois)
+        {
+            distances[poi_id] = INVALID_EDGE_WEIGHT;
+        }
+        touched_pois.clear();
+    }
+
+    void Relax(const unsigned poi_id, const EdgeWeight distance)
+    {
+        BOOST_ASSERT(poi_id < distances.size());
+        if (INVALID_EDGE_WEIGHT == distances[poi_id])
+        {
+            touched_pois.push_back(poi_id);
+            distances[poi_id] = distance;
+        }
+        else if (distance < distances[poi_id])
+        {
+            distances[poi_id] = distance;
+        }
+    }
+
+    EdgeWeight GetDistance(const unsigned poi_id) const { return distances[poi_id]; }
+
+    // pois reached by the last query, in the order they were found
+    const std::vector<unsigned> &GetTouchedPois() const { return touched_pois; }
+
+    unsigned GetNumberOfPois() const { return static_cast<unsigned>(distances.size()); }
+
+  private:
+    std::vector<EdgeWeight> distances;
+    std::vector<unsigned> touched_pois;
+};
+
 struct SearchEngineData
 {
-    using QueryHeap = BinaryHeap<NodeID, NodeID, int, HeapData, UnorderedMapStorage<NodeID, int>>;
+    using QueryHeap =
+        SelectedHeap<NodeID, NodeID, int, HeapData, TimestampedArrayStorage<NodeID, NodeID>>;
     using SearchEngineHeapPtr = boost::thread_specific_ptr<QueryHeap>;
+    using PoiDistanceArenaPtr = boost::thread_specific_ptr<PoiDistanceArena>;
+    using QueryHeapPool = tbb::enumerable_thread_specific<std::shared_ptr<QueryHeap>>;
 
     static SearchEngineHeapPtr forwardHeap;
     static SearchEngineHeapPtr backwardHeap;
@@ -50,12 +104,21 @@ struct SearchEngineData
     static SearchEngineHeapPtr backwardHeap2;
     static SearchEngineHeapPtr forwardHeap3;
     static SearchEngineHeapPtr backwardHeap3;
+    static PoiDistanceArenaPtr poiDistanceArena;
+
+    // one heap per thread that runs searches inside of TBB parallel algorithms
+    QueryHeapPool pooledHeaps;
 
     void InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes);
 
     void InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes);
 
     void InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes);
+
+    void InitializeOrClearPoiThreadLocalStorage(const unsigned number_of_nodes,
+                                                const unsigned number_of_pois);
+
+    QueryHeap &InitializeOrClearPooledHeap(const unsigned number_of_nodes);
 };
 
 #endif // SEARCH_ENGINE_DATA_H
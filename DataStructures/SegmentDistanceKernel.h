@@ -0,0 +1,223 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef SEGMENT_DISTANCE_KERNEL_H
+#define SEGMENT_DISTANCE_KERNEL_H
+
+#include <osrm/Coordinate.h>
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Batch distance computation for the segments of an r-tree leaf. Coordinates are projected
+// equirectangularly around the query, i.e. longitude differences are scaled by lon_scale, and the
+// result is the squared distance from the query to the closest point of each segment in fixed
+// point units. FixedPointCoordinate::ComputePerpendicularDistance stays the reference that
+// decides the final snapping result.
+namespace osrm
+{
+
+// converts a distance in fixed point units to meters like ApproximateEuclideanDistance does
+constexpr float FIXED_POINT_UNIT_IN_METERS =
+    0.017453292519943295769236907684886f / COORDINATE_PRECISION * 6372797.560856f;
+
+// how far the reference may fall below the kernel scaled at the highest latitude. It computes in
+// single precision, which costs up to a few meters at high latitudes, and follows straight lines
+// in mercator, which bend away from the segment on segments of several kilometers.
+constexpr float SEGMENT_LOWER_BOUND_SLACK_IN_METERS = 10.f;
+
+inline float LongitudeScaleAt(const int lat)
+{
+    return static_cast<float>(std::cos(lat / COORDINATE_PRECISION * 0.017453292519943295));
+}
+
+inline void ComputeSquaredSegmentDistancesScalar(const FixedPointCoordinate &query,
+                                                 const float lon_scale,
+                                                 const int32_t *u_lats,
+                                                 const int32_t *u_lons,
+                                                 const int32_t *v_lats,
+                                                 const int32_t *v_lons,
+                                                 const uint32_t begin,
+                                                 const uint32_t end,
+                                                 float *squared_distances)
+{
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        const float segment_x = static_cast<float>(v_lons[i] - u_lons[i]) * lon_scale;
+        const float segment_y = static_cast<float>(v_lats[i] - u_lats[i]);
+        const float query_x = static_cast<float>(query.lon - u_lons[i]) * lon_scale;
+        const float query_y = static_cast<float>(query.lat - u_lats[i]);
+
+        const float squared_length = std::max(segment_x * segment_x + segment_y * segment_y,
+                                              std::numeric_limits<float>::min());
+        const float ratio = std::min(
+            1.f, std::max(0.f, (query_x * segment_x + query_y * segment_y) / squared_length));
+
+        const float delta_x = query_x - ratio * segment_x;
+        const float delta_y = query_y - ratio * segment_y;
+        squared_distances[i] = delta_x * delta_x + delta_y * delta_y;
+    }
+}
+
+#if defined(__AVX2__)
+constexpr uint32_t SEGMENT_DISTANCE_LANES = 8;
+
+inline void ComputeSquaredSegmentDistancesVector(const FixedPointCoordinate &query,
+                                                 const float lon_scale,
+                                                 const int32_t *u_lats,
+                                                 const int32_t *u_lons,
+                                                 const int32_t *v_lats,
+                                                 const int32_t *v_lons,
+                                                 const uint32_t end,
+                                                 float *squared_distances)
+{
+    const __m256i query_lat = _mm256_set1_epi32(query.lat);
+    const __m256i query_lon = _mm256_set1_epi32(query.lon);
+    const __m256 scale = _mm256_set1_ps(lon_scale);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256 smallest = _mm256_set1_ps(std::numeric_limits<float>::min());
+
+    for (uint32_t i = 0; i < end; i += SEGMENT_DISTANCE_LANES)
+    {
+        const __m256i u_lat = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(u_lats + i));
+        const __m256i u_lon = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(u_lons + i));
+        const __m256i v_lat = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v_lats + i));
+        const __m256i v_lon = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v_lons + i));
+
+        const __m256 segment_x =
+            _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(v_lon, u_lon)), scale);
+        const __m256 segment_y = _mm256_cvtepi32_ps(_mm256_sub_epi32(v_lat, u_lat));
+        const __m256 query_x =
+            _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(query_lon, u_lon)), scale);
+        const __m256 query_y = _mm256_cvtepi32_ps(_mm256_sub_epi32(query_lat, u_lat));
+
+        const __m256 squared_length = _mm256_max_ps(
+            _mm256_add_ps(_mm256_mul_ps(segment_x, segment_x), _mm256_mul_ps(segment_y, segment_y)),
+            smallest);
+        const __m256 dot =
+            _mm256_add_ps(_mm256_mul_ps(query_x, segment_x), _mm256_mul_ps(query_y, segment_y));
+        const __m256 ratio =
+            _mm256_min_ps(one, _mm256_max_ps(zero, _mm256_div_ps(dot, squared_length)));
+
+        const __m256 delta_x = _mm256_sub_ps(query_x, _mm256_mul_ps(ratio, segment_x));
+        const __m256 delta_y = _mm256_sub_ps(query_y, _mm256_mul_ps(ratio, segment_y));
+        _mm256_storeu_ps(squared_distances + i,
+                         _mm256_add_ps(_mm256_mul_ps(delta_x, delta_x),
+                                       _mm256_mul_ps(delta_y, delta_y)));
+    }
+}
+#elif defined(__SSE2__)
+constexpr uint32_t SEGMENT_DISTANCE_LANES = 4;
+
+inline void ComputeSquaredSegmentDistancesVector(const FixedPointCoordinate &query,
+                                                 const float lon_scale,
+                                                 const int32_t *u_lats,
+                                                 const int32_t *u_lons,
+                                                 const int32_t *v_lats,
+                                                 const int32_t *v_lons,
+                                                 const uint32_t end,
+                                                 float *squared_distances)
+{
+    const __m128i query_lat = _mm_set1_epi32(query.lat);
+    const __m128i query_lon = _mm_set1_epi32(query.lon);
+    const __m128 scale = _mm_set1_ps(lon_scale);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 smallest = _mm_set1_ps(std::numeric_limits<float>::min());
+
+    for (uint32_t i = 0; i < end; i += SEGMENT_DISTANCE_LANES)
+    {
+        const __m128i u_lat = _mm_loadu_si128(reinterpret_cast<const __m128i *>(u_lats + i));
+        const __m128i u_lon = _mm_loadu_si128(reinterpret_cast<const __m128i *>(u_lons + i));
+        const __m128i v_lat = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v_lats + i));
+        const __m128i v_lon = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v_lons + i));
+
+        const __m128 segment_x = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(v_lon, u_lon)), scale);
+        const __m128 segment_y = _mm_cvtepi32_ps(_mm_sub_epi32(v_lat, u_lat));
+        const __m128 query_x = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(query_lon, u_lon)), scale);
+        const __m128 query_y = _mm_cvtepi32_ps(_mm_sub_epi32(query_lat, u_lat));
+
+        const __m128 squared_length = _mm_max_ps(
+            _mm_add_ps(_mm_mul_ps(segment_x, segment_x), _mm_mul_ps(segment_y, segment_y)),
+            smallest);
+        const __m128 dot =
+            _mm_add_ps(_mm_mul_ps(query_x, segment_x), _mm_mul_ps(query_y, segment_y));
+        const __m128 ratio = _mm_min_ps(one, _mm_max_ps(zero, _mm_div_ps(dot, squared_length)));
+
+        const __m128 delta_x = _mm_sub_ps(query_x, _mm_mul_ps(ratio, segment_x));
+        const __m128 delta_y = _mm_sub_ps(query_y, _mm_mul_ps(ratio, segment_y));
+        _mm_storeu_ps(squared_distances + i,
+                      _mm_add_ps(_mm_mul_ps(delta_x, delta_x), _mm_mul_ps(delta_y, delta_y)));
+    }
+}
+#else
+constexpr uint32_t SEGMENT_DISTANCE_LANES = 1;
+#endif
+
+// Computes squared_distances[i] for all i < count. The vector path handles full lanes and the
+// scalar kernel the remainder.
+inline void ComputeSquaredSegmentDistances(const FixedPointCoordinate &query,
+                                           const float lon_scale,
+                                           const int32_t *u_lats,
+                                           const int32_t *u_lons,
+                                           const int32_t *v_lats,
+                                           const int32_t *v_lons,
+                                           const uint32_t count,
+                                           float *squared_distances)
+{
+    BOOST_ASSERT(query.isValid());
+    uint32_t vectorized_count = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+    vectorized_count = count - (count % SEGMENT_DISTANCE_LANES);
+    ComputeSquaredSegmentDistancesVector(
+        query, lon_scale, u_lats, u_lons, v_lats, v_lons, vectorized_count, squared_distances);
+#endif
+    ComputeSquaredSegmentDistancesScalar(query,
+                                         lon_scale,
+                                         u_lats,
+                                         u_lons,
+                                         v_lats,
+                                         v_lons,
+                                         vectorized_count,
+                                         count,
+                                         squared_distances);
+}
+}
+
+#endif // SEGMENT_DISTANCE_KERNEL_H
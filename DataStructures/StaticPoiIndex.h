@@ -0,0 +1,324 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef STATIC_POI_INDEX_H
+#define STATIC_POI_INDEX_H
+
+#include "HilbertValue.h"
+#include "PoiBuckets.h"
+#include "Range.h"
+#include "SharedMemoryVectorWrapper.h"
+#include "../typedefs.h"
+
+#include <osrm/Coordinate.h>
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+struct PoiBoundingBox
+{
+    PoiBoundingBox()
+        : min_lat(std::numeric_limits<int>::max()), max_lat(std::numeric_limits<int>::min()),
+          min_lon(std::numeric_limits<int>::max()), max_lon(std::numeric_limits<int>::min())
+    {
+    }
+
+    int32_t min_lat, max_lat;
+    int32_t min_lon, max_lon;
+
+    inline void Extend(const FixedPointCoordinate &location)
+    {
+        min_lat = std::min(min_lat, location.lat);
+        max_lat = std::max(max_lat, location.lat);
+        min_lon = std::min(min_lon, location.lon);
+        max_lon = std::max(max_lon, location.lon);
+    }
+
+    inline void Extend(const PoiBoundingBox &other)
+    {
+        min_lat = std::min(min_lat, other.min_lat);
+        max_lat = std::max(max_lat, other.max_lat);
+        min_lon = std::min(min_lon, other.min_lon);
+        max_lon = std::max(max_lon, other.max_lon);
+    }
+
+    inline bool Contains(const FixedPointCoordinate &location) const
+    {
+        return (location.lat >= min_lat) && (location.lat <= max_lat) &&
+               (location.lon >= min_lon) && (location.lon <= max_lon);
+    }
+
+    inline bool Intersects(const PoiBoundingBox &other) const
+    {
+        return (min_lat <= other.max_lat) && (other.min_lat <= max_lat) &&
+               (min_lon <= other.max_lon) && (other.min_lon <= max_lon);
+    }
+
+    // distance to the closest point of the box, zero if the location is inside
+    inline float GetMinDist(const FixedPointCoordinate &location) const
+    {
+        const FixedPointCoordinate closest_point(std::min(std::max(location.lat, min_lat), max_lat),
+                                                 std::min(std::max(location.lon, min_lon), max_lon));
+        return FixedPointCoordinate::ApproximateEuclideanDistance(location, closest_point);
+    }
+};
+
+/**
+    \brief Packed spatial index over the POI list of the .poibuckets file
+
+    The POIs are sorted by the Hilbert value of their location during preprocessing, so each leaf
+    box covers a run of consecutive poi ids. The tree is stored as an array of bounding boxes,
+    level by level starting at the root. Its shape only depends on the number of POIs: box i of a
+    level covers the boxes [i*BRANCHING_FACTOR, (i+1)*BRANCHING_FACTOR) of the next level, or the
+    POIs in that range for the leaf level.
+ */
+template <bool UseSharedMemory, unsigned BRANCHING_FACTOR = 16> class StaticPoiIndex
+{
+  public:
+    using PoiList = typename ShM<PoiInfo, UseSharedMemory>::vector;
+    using BoxList = typename ShM<PoiBoundingBox, UseSharedMemory>::vector;
+
+    // returns the permutation that orders the locations along the Hilbert curve
+    static std::vector<unsigned> HilbertOrder(const std::vector<FixedPointCoordinate> &locations)
+    {
+        HilbertCode get_hilbert_number;
+        std::vector<uint64_t> hilbert_values(locations.size());
+        for (unsigned i = 0; i < locations.size(); ++i)
+        {
+            hilbert_values[i] = get_hilbert_number(locations[i]);
+        }
+        std::vector<unsigned> permutation(locations.size());
+        std::iota(permutation.begin(), permutation.end(), 0);
+        std::stable_sort(permutation.begin(),
+                         permutation.end(),
+                         [&hilbert_values](const unsigned first, const unsigned second)
+                         {
+            return hilbert_values[first] < hilbert_values[second];
+        });
+        return permutation;
+    }
+
+    // builds the boxes of a Hilbert ordered POI list
+    static void Build(const std::vector<PoiInfo> &poi_list, std::vector<PoiBoundingBox> &box_list)
+    {
+        const std::vector<unsigned> level_offsets =
+            ComputeLevelOffsets(static_cast<unsigned>(poi_list.size()));
+        box_list.clear();
+        box_list.resize(level_offsets.back());
+        if (poi_list.empty())
+        {
+            return;
+        }
+
+        const unsigned leaf_level = static_cast<unsigned>(level_offsets.size()) - 2;
+        for (unsigned poi_id = 0; poi_id < poi_list.size(); ++poi_id)
+        {
+            box_list[level_offsets[leaf_level] + poi_id / BRANCHING_FACTOR].Extend(
+                poi_list[poi_id].location);
+        }
+        for (unsigned level = leaf_level; level > 0; --level)
+        {
+            for (unsigned box = level_offsets[level]; box < level_offsets[level + 1]; ++box)
+            {
+                const unsigned parent = (box - level_offsets[level]) / BRANCHING_FACTOR;
+                box_list[level_offsets[level - 1] + parent].Extend(box_list[box]);
+            }
+        }
+    }
+
+    StaticPoiIndex(const PoiList &poi_list, const BoxList &box_list)
+        : poi_list(poi_list), box_list(box_list),
+          level_offsets(ComputeLevelOffsets(static_cast<unsigned>(poi_list.size())))
+    {
+        BOOST_ASSERT(level_offsets.back() == box_list.size());
+    }
+
+    // Range queries: the callback is invoked with the id of every poi within max_distance meters
+    // of the location, or inside the box, in ascending order of the ids. The traversal stops as
+    // soon as the callback returns false, false is then returned.
+    template <typename CallbackT>
+    bool ForEachPoiInRadius(const FixedPointCoordinate &location,
+                            const float max_distance,
+                            CallbackT &&callback) const
+    {
+        if (poi_list.empty())
+        {
+            return true;
+        }
+
+        const unsigned poi_level = static_cast<unsigned>(level_offsets.size()) - 1;
+        std::vector<std::pair<unsigned, unsigned>> traversal_stack;
+        traversal_stack.emplace_back(0, 0);
+        while (!traversal_stack.empty())
+        {
+            const unsigned level = traversal_stack.back().first;
+            const unsigned index = traversal_stack.back().second;
+            traversal_stack.pop_back();
+
+            if (GetMinDist(location, level, index) > max_distance)
+            {
+                continue;
+            }
+            if (poi_level == level)
+            {
+                if (!callback(index))
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            // push in reverse to visit the children and thus the pois in ascending order
+            const auto children = GetChildRange(level, index);
+            for (unsigned child = children.back() + 1; child > children.front(); --child)
+            {
+                traversal_stack.emplace_back(level + 1, child - 1);
+            }
+        }
+        return true;
+    }
+
+    template <typename CallbackT>
+    bool ForEachPoiInRectangle(const PoiBoundingBox &search_box, CallbackT &&callback) const
+    {
+        if (poi_list.empty())
+        {
+            return true;
+        }
+
+        const unsigned poi_level = static_cast<unsigned>(level_offsets.size()) - 1;
+        std::vector<std::pair<unsigned, unsigned>> traversal_stack;
+        traversal_stack.emplace_back(0, 0);
+        while (!traversal_stack.empty())
+        {
+            const unsigned level = traversal_stack.back().first;
+            const unsigned index = traversal_stack.back().second;
+            traversal_stack.pop_back();
+
+            if (poi_level == level)
+            {
+                if (search_box.Contains(poi_list[index].location) && !callback(index))
+                {
+                    return false;
+                }
+                continue;
+            }
+            if (!box_list[level_offsets[level] + index].Intersects(search_box))
+            {
+                continue;
+            }
+
+            const auto children = GetChildRange(level, index);
+            for (unsigned child = children.back() + 1; child > children.front(); --child)
+            {
+                traversal_stack.emplace_back(level + 1, child - 1);
+            }
+        }
+        return true;
+    }
+
+    // appends the ids of all pois within max_distance meters, in ascending order of their ids
+    void PoisInRadius(const FixedPointCoordinate &location,
+                      const float max_distance,
+                      std::vector<unsigned> &result_poi_ids) const
+    {
+        ForEachPoiInRadius(location,
+                           max_distance,
+                           [&result_poi_ids](const unsigned poi_id)
+                           {
+            result_poi_ids.push_back(poi_id);
+            return true;
+        });
+    }
+
+    // appends the ids of all pois inside the box, in ascending order
+    void PoisInRectangle(const PoiBoundingBox &search_box,
+                         std::vector<unsigned> &result_poi_ids) const
+    {
+        ForEachPoiInRectangle(search_box,
+                              [&result_poi_ids](const unsigned poi_id)
+                              {
+            result_poi_ids.push_back(poi_id);
+            return true;
+        });
+    }
+
+  private:
+    // offsets of the levels in the box array, the last entry is the total number of boxes
+    static std::vector<unsigned> ComputeLevelOffsets(const unsigned number_of_pois)
+    {
+        std::vector<unsigned> level_sizes;
+        unsigned level_size = number_of_pois;
+        while (level_size > 1 || level_sizes.empty())
+        {
+            level_size = (level_size + BRANCHING_FACTOR - 1) / BRANCHING_FACTOR;
+            level_sizes.push_back(level_size);
+        }
+        std::reverse(level_sizes.begin(), level_sizes.end());
+
+        std::vector<unsigned> offsets(1, 0);
+        for (const unsigned size : level_sizes)
+        {
+            offsets.push_back(offsets.back() + size);
+        }
+        return offsets;
+    }
+
+    osrm::range<unsigned> GetChildRange(const unsigned level, const unsigned index) const
+    {
+        const unsigned number_of_children =
+            (level + 2 < level_offsets.size())
+                ? level_offsets[level + 2] - level_offsets[level + 1]
+                : static_cast<unsigned>(poi_list.size());
+        return osrm::irange(index * BRANCHING_FACTOR,
+                            std::min((index + 1) * BRANCHING_FACTOR, number_of_children));
+    }
+
+    float GetMinDist(const FixedPointCoordinate &location,
+                     const unsigned level,
+                     const unsigned index) const
+    {
+        if (level + 1 == level_offsets.size())
+        {
+            return FixedPointCoordinate::ApproximateEuclideanDistance(location,
+                                                                      poi_list[index].location);
+        }
+        return box_list[level_offsets[level] + index].GetMinDist(location);
+    }
+
+    const PoiList &poi_list;
+    const BoxList &box_list;
+    const std::vector<unsigned> level_offsets;
+};
+
+#endif // STATIC_POI_INDEX_H
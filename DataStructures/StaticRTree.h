@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "HilbertValue.h"
 #include "PhantomNodes.h"
 #include "QueryNode.h"
+#include "SegmentDistanceKernel.h"
 #include "SharedMemoryFactory.h"
 #include "SharedMemoryVectorWrapper.h"
 
@@ -48,6 +49,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/assert.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/thread.hpp>
 
 #include <tbb/parallel_for.h>
@@ -55,6 +58,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <limits>
 #include <memory>
 #include <queue>
@@ -74,14 +78,23 @@ class StaticRTree
     {
         RectangleInt2D() : min_lon(INT_MAX), max_lon(INT_MIN), min_lat(INT_MAX), max_lat(INT_MIN) {}
 
+        // rectangle spanned by two opposite corners given in any order
+        RectangleInt2D(const FixedPointCoordinate &first_corner,
+                       const FixedPointCoordinate &second_corner)
+            : min_lon(std::min(first_corner.lon, second_corner.lon)),
+              max_lon(std::max(first_corner.lon, second_corner.lon)),
+              min_lat(std::min(first_corner.lat, second_corner.lat)),
+              max_lat(std::max(first_corner.lat, second_corner.lat))
+        {
+        }
+
         int32_t min_lon, max_lon;
         int32_t min_lat, max_lat;
 
-        inline void InitializeMBRectangle(const std::array<EdgeDataT, LEAF_NODE_SIZE> &objects,
-                                          const uint32_t element_count,
+        inline void InitializeMBRectangle(const std::vector<EdgeDataT> &objects,
                                           const std::vector<NodeInfo> &coordinate_list)
         {
-            for (uint32_t i = 0; i < element_count; ++i)
+            for (uint32_t i = 0; i < objects.size(); ++i)
             {
                 min_lon = std::min(min_lon,
                                    std::min(coordinate_list.at(objects[i].u).lon,
@@ -125,15 +138,57 @@ class StaticRTree
             return centroid;
         }
 
+        // also true if the rectangles cross without containing each other's corners
         inline bool Intersects(const RectangleInt2D &other) const
         {
-            FixedPointCoordinate upper_left(other.max_lat, other.min_lon);
-            FixedPointCoordinate upper_right(other.max_lat, other.max_lon);
-            FixedPointCoordinate lower_right(other.min_lat, other.max_lon);
-            FixedPointCoordinate lower_left(other.min_lat, other.min_lon);
+            return (min_lat <= other.max_lat) && (other.min_lat <= max_lat) &&
+                   (min_lon <= other.max_lon) && (other.min_lon <= max_lon);
+        }
+
+        // Liang-Barsky clipping of the segment from u to v against the rectangle
+        inline bool Intersects(const FixedPointCoordinate &u, const FixedPointCoordinate &v) const
+        {
+            if (Contains(u) || Contains(v))
+            {
+                return true;
+            }
 
-            return (Contains(upper_left) || Contains(upper_right) || Contains(lower_right) ||
-                    Contains(lower_left));
+            const double delta_lat = static_cast<double>(v.lat) - u.lat;
+            const double delta_lon = static_cast<double>(v.lon) - u.lon;
+            const std::array<double, 4> directions = {
+                {-delta_lat, delta_lat, -delta_lon, delta_lon}};
+            const std::array<double, 4> distances = {{static_cast<double>(u.lat) - min_lat,
+                                                      static_cast<double>(max_lat) - u.lat,
+                                                      static_cast<double>(u.lon) - min_lon,
+                                                      static_cast<double>(max_lon) - u.lon}};
+            double entering = 0.;
+            double leaving = 1.;
+            for (unsigned i = 0; i < 4; ++i)
+            {
+                if (0. == directions[i])
+                {
+                    // parallel to this boundary and outside of it
+                    if (distances[i] < 0.)
+                    {
+                        return false;
+                    }
+                    continue;
+                }
+                const double ratio = distances[i] / directions[i];
+                if (directions[i] < 0.)
+                {
+                    entering = std::max(entering, ratio);
+                }
+                else
+                {
+                    leaving = std::min(leaving, ratio);
+                }
+                if (entering > leaving)
+                {
+                    return false;
+                }
+            }
+            return true;
         }
 
         inline float GetMinDist(const FixedPointCoordinate &location) const
@@ -284,11 +339,89 @@ class StaticRTree
         }
     };
 
+    // The leaf file starts with this header, followed by equally sized leaves. Each leaf stores
+    // its segments as a structure of arrays, so that the distance computations only touch the
+    // endpoint coordinates and the payload is read just for the candidates:
+    //   uint32_t object_count, uint32_t padding
+    //   int32_t u_lat[n], u_lon[n], v_lat[n], v_lon[n]
+    //   uint8_t is_in_tiny_cc[n], padding
+    //   EdgeDataT objects[n]
+    // where n is the leaf node size chosen at construction. The version is bumped whenever the
+    // layout changes, files of another version or another EdgeDataT are refused.
+    struct LeafFileHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t element_count;
+        uint32_t leaf_node_size;
+        uint32_t object_size;
+    };
+
+    static constexpr uint32_t LEAF_FILE_VERSION = 1;
+
+    static bool HasLeafFileMagic(const LeafFileHeader &header)
+    {
+        return 'O' == header.magic[0] && 'R' == header.magic[1] && 'T' == header.magic[2] &&
+               'L' == header.magic[3];
+    }
+
+    struct LeafLayout
+    {
+        explicit LeafLayout(const uint32_t leaf_node_size)
+            : leaf_node_size(leaf_node_size),
+              coordinates_offset(2 * sizeof(uint32_t)),
+              tiny_cc_offset(coordinates_offset + 4 * sizeof(int32_t) * leaf_node_size),
+              objects_offset(AlignUp(tiny_cc_offset + leaf_node_size, OBJECT_ALIGNMENT)),
+              leaf_size(AlignUp(objects_offset + sizeof(EdgeDataT) * leaf_node_size,
+                                OBJECT_ALIGNMENT))
+        {
+        }
+
+        static constexpr uint64_t OBJECT_ALIGNMENT =
+            alignof(EdgeDataT) > alignof(uint64_t) ? alignof(EdgeDataT) : alignof(uint64_t);
+
+        static uint64_t AlignUp(const uint64_t offset, const uint64_t alignment)
+        {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        uint32_t leaf_node_size;
+        uint64_t coordinates_offset;
+        uint64_t tiny_cc_offset;
+        uint64_t objects_offset;
+        uint64_t leaf_size;
+    };
+
+    // read-only view of a leaf inside the mapped leaf file
     struct LeafNode
     {
-        LeafNode() : object_count(0), objects() {}
+        LeafNode(const char *leaf_begin, const LeafLayout &layout)
+            : object_count(*reinterpret_cast<const uint32_t *>(leaf_begin)),
+              u_lats(reinterpret_cast<const int32_t *>(leaf_begin + layout.coordinates_offset)),
+              u_lons(u_lats + layout.leaf_node_size), v_lats(u_lons + layout.leaf_node_size),
+              v_lons(v_lats + layout.leaf_node_size),
+              is_in_tiny_cc(reinterpret_cast<const uint8_t *>(leaf_begin + layout.tiny_cc_offset)),
+              objects(reinterpret_cast<const EdgeDataT *>(leaf_begin + layout.objects_offset))
+        {
+        }
+
+        FixedPointCoordinate GetU(const uint32_t i) const
+        {
+            return FixedPointCoordinate(u_lats[i], u_lons[i]);
+        }
+
+        FixedPointCoordinate GetV(const uint32_t i) const
+        {
+            return FixedPointCoordinate(v_lats[i], v_lons[i]);
+        }
+
         uint32_t object_count;
-        std::array<EdgeDataT, LEAF_NODE_SIZE> objects;
+        const int32_t *u_lats;
+        const int32_t *u_lons;
+        const int32_t *v_lats;
+        const int32_t *v_lons;
+        const uint8_t *is_in_tiny_cc;
+        const EdgeDataT *objects;
     };
 
     struct QueryCandidate
@@ -329,10 +462,15 @@ class StaticRTree
 
     typename ShM<TreeNode, UseSharedMemory>::vector m_search_tree;
     uint64_t m_element_count;
+    uint64_t m_number_of_leaves;
     const std::string m_leaf_node_filename;
     std::shared_ptr<CoordinateListT> m_coordinate_list;
-    std::unordered_set<NodeID> m_poi_node_ids ;
-    boost::filesystem::ifstream leaves_stream;
+    LeafLayout m_leaf_layout;
+    // the leaves are mapped read-only, queries read them in place without locking. The leaf
+    // file must never be modified in place while a server may have it mapped, only replaced.
+    boost::interprocess::file_mapping m_leaves_mapping;
+    boost::interprocess::mapped_region m_leaves_region;
+    const char *m_leaves;
 
   public:
     StaticRTree() = delete;
@@ -342,9 +480,17 @@ class StaticRTree
     explicit StaticRTree(std::vector<EdgeDataT> &input_data_vector,
                          const std::string tree_node_filename,
                          const std::string leaf_node_filename,
-                         const std::vector<NodeInfo> &coordinate_list)
-        : m_element_count(input_data_vector.size()), m_leaf_node_filename(leaf_node_filename)
+                         const std::vector<NodeInfo> &coordinate_list,
+                         const uint32_t leaf_node_size = LEAF_NODE_SIZE)
+        : m_element_count(input_data_vector.size()), m_number_of_leaves(0),
+          m_leaf_node_filename(leaf_node_filename), m_leaf_layout(leaf_node_size),
+          m_leaves(nullptr)
     {
+        if (0 == leaf_node_size)
+        {
+            throw OSRMException("r-tree leaf node size must be positive");
+        }
+
         SimpleLogger().Write() << "constructing r-tree of " << m_element_count
                                << " edge elements build on-top of " << coordinate_list.size()
                                << " coordinates";
@@ -381,24 +527,32 @@ class StaticRTree
                 }
             });
 
-        // open leaf file
-        boost::filesystem::ofstream leaf_node_file(leaf_node_filename, std::ios::binary);
-        leaf_node_file.write((char *)&m_element_count, sizeof(uint64_t));
+        // Running servers may have the leaf file mapped, truncating it underneath them would
+        // fault their queries. The leaves are written to a temporary file that replaces the old
+        // one by a rename, mappings of the old file keep their own copy.
+        const boost::filesystem::path temporary_leaf_node_filename(leaf_node_filename + ".tmp");
+        boost::filesystem::ofstream leaf_node_file(temporary_leaf_node_filename,
+                                                   std::ios::binary);
+        const LeafFileHeader leaf_file_header = {{'O', 'R', 'T', 'L'},
+                                                 LEAF_FILE_VERSION,
+                                                 m_element_count,
+                                                 leaf_node_size,
+                                                 static_cast<uint32_t>(sizeof(EdgeDataT))};
+        leaf_node_file.write((char *)&leaf_file_header, sizeof(LeafFileHeader));
 
         // sort the hilbert-value representatives
         tbb::parallel_sort(input_wrapper_vector.begin(), input_wrapper_vector.end());
         std::vector<TreeNode> tree_nodes_in_level;
 
         // pack M elements into leaf node and write to leaf file
+        std::vector<char> leaf_buffer(m_leaf_layout.leaf_size);
+        std::vector<EdgeDataT> leaf_objects;
         uint64_t processed_objects_count = 0;
         while (processed_objects_count < m_element_count)
         {
-
-            LeafNode current_leaf;
+            leaf_objects.clear();
             TreeNode current_node;
-            // SimpleLogger().Write() << "reading " << tree_size << " tree nodes in " <<
-            // (sizeof(TreeNode)*tree_size) << " bytes";
-            for (uint32_t current_element_index = 0; LEAF_NODE_SIZE > current_element_index;
+            for (uint32_t current_element_index = 0; leaf_node_size > current_element_index;
                  ++current_element_index)
             {
                 if (m_element_count > (processed_objects_count + current_element_index))
@@ -406,26 +560,30 @@ class StaticRTree
                     uint32_t index_of_next_object =
                         input_wrapper_vector[processed_objects_count + current_element_index]
                             .m_array_index;
-                    current_leaf.objects[current_element_index] =
-                        input_data_vector[index_of_next_object];
-                    ++current_leaf.object_count;
+                    leaf_objects.emplace_back(input_data_vector[index_of_next_object]);
                 }
             }
 
             // generate tree node that resemble the objects in leaf and store it for next level
-            current_node.minimum_bounding_rectangle.InitializeMBRectangle(
-                current_leaf.objects, current_leaf.object_count, coordinate_list);
+            current_node.minimum_bounding_rectangle.InitializeMBRectangle(leaf_objects,
+                                                                          coordinate_list);
             current_node.child_is_on_disk = true;
             current_node.children[0] = tree_nodes_in_level.size();
             tree_nodes_in_level.emplace_back(current_node);
 
             // write leaf_node to leaf node file
-            leaf_node_file.write((char *)&current_leaf, sizeof(current_leaf));
-            processed_objects_count += current_leaf.object_count;
+            SerializeLeaf(leaf_objects, coordinate_list, leaf_buffer);
+            leaf_node_file.write(leaf_buffer.data(), leaf_buffer.size());
+            processed_objects_count += leaf_objects.size();
         }
 
-        // close leaf file
+        // close leaf file and move it into place
         leaf_node_file.close();
+        if (!leaf_node_file)
+        {
+            throw OSRMException("could not write mem index file");
+        }
+        boost::filesystem::rename(temporary_leaf_node_filename, leaf_node_filename);
 
         uint32_t processing_level = 0;
         while (1 < tree_nodes_in_level.size())
@@ -501,10 +659,9 @@ class StaticRTree
     // Read-only operation for queries
     explicit StaticRTree(const boost::filesystem::path &node_file,
                          const boost::filesystem::path &leaf_file,
-                         const std::shared_ptr<CoordinateListT> coordinate_list,
-                         const std::unordered_set<NodeID> poi_node_ids
-                         )
-        : m_leaf_node_filename(leaf_file.string()), m_poi_node_ids(poi_node_ids)
+                         const std::shared_ptr<CoordinateListT> coordinate_list)
+        : m_leaf_node_filename(leaf_file.string()), m_leaf_layout(LEAF_NODE_SIZE),
+          m_leaves(nullptr)
     {
         // open tree node file and load into RAM.
         m_coordinate_list = coordinate_list;
@@ -528,21 +685,8 @@ class StaticRTree
             tree_node_file.read((char *)&m_search_tree[0], sizeof(TreeNode) * tree_size);
         }
         tree_node_file.close();
-        // open leaf node file and store thread specific pointer
-        if (!boost::filesystem::exists(leaf_file))
-        {
-            throw OSRMException("mem index file does not exist");
-        }
-        if (0 == boost::filesystem::file_size(leaf_file))
-        {
-            throw OSRMException("mem index file is empty");
-        }
-
-        leaves_stream.open(leaf_file, std::ios::binary);
-        leaves_stream.read((char *)&m_element_count, sizeof(uint64_t));
 
-        // SimpleLogger().Write() << tree_size << " nodes in search tree";
-        // SimpleLogger().Write() << m_element_count << " elements in leafs";
+        MapLeafFile(leaf_file);
     }
 
     explicit StaticRTree(TreeNode *tree_node_ptr,
@@ -550,23 +694,9 @@ class StaticRTree
                          const boost::filesystem::path &leaf_file,
                          std::shared_ptr<CoordinateListT> coordinate_list)
         : m_search_tree(tree_node_ptr, number_of_nodes), m_leaf_node_filename(leaf_file.string()),
-          m_coordinate_list(coordinate_list)
+          m_coordinate_list(coordinate_list), m_leaf_layout(LEAF_NODE_SIZE), m_leaves(nullptr)
     {
-        // open leaf node file and store thread specific pointer
-        if (!boost::filesystem::exists(leaf_file))
-        {
-            throw OSRMException("mem index file does not exist");
-        }
-        if (0 == boost::filesystem::file_size(leaf_file))
-        {
-            throw OSRMException("mem index file is empty");
-        }
-
-        leaves_stream.open(leaf_file, std::ios::binary);
-        leaves_stream.read((char *)&m_element_count, sizeof(uint64_t));
-
-        // SimpleLogger().Write() << tree_size << " nodes in search tree";
-        // SimpleLogger().Write() << m_element_count << " elements in leafs";
+        MapLeafFile(leaf_file);
     }
     // Read-only operation for queries
 
@@ -578,6 +708,7 @@ class StaticRTree
 
         float min_dist = std::numeric_limits<float>::max();
         float min_max_dist = std::numeric_limits<float>::max();
+        std::vector<float> u_squared_distances, v_squared_distances;
 
         // initialize queue with root element
         std::priority_queue<QueryCandidate> traversal_queue;
@@ -595,41 +726,51 @@ class StaticRTree
                 TreeNode &current_tree_node = m_search_tree[current_query_node.node_id];
                 if (current_tree_node.child_is_on_disk)
                 {
-                    LeafNode current_leaf_node;
-                    LoadLeafFromDisk(current_tree_node.children[0], current_leaf_node);
+                    const LeafNode current_leaf_node = GetLeafNode(current_tree_node.children[0]);
+                    ComputeEndPointLowerBounds(input_coordinate,
+                                               current_tree_node.minimum_bounding_rectangle,
+                                               current_leaf_node,
+                                               u_squared_distances,
+                                               v_squared_distances);
                     for (uint32_t i = 0; i < current_leaf_node.object_count; ++i)
                     {
-                        EdgeDataT const &current_edge = current_leaf_node.objects[i];
-                        if (ignore_tiny_components && current_edge.is_in_tiny_cc)
+                        if (ignore_tiny_components && current_leaf_node.is_in_tiny_cc[i])
                         {
                             continue;
                         }
 
-                        float current_minimum_distance =
-                            FixedPointCoordinate::ApproximateEuclideanDistance(
-                                input_coordinate.lat,
-                                input_coordinate.lon,
-                                m_coordinate_list->at(current_edge.u).lat,
-                                m_coordinate_list->at(current_edge.u).lon);
-                        if (current_minimum_distance < min_dist)
+                        // the exact distance is only computed if the lower bound can beat
+                        // the current minimum
+                        if (IsBelow(u_squared_distances[i], min_dist))
                         {
-                            // found a new minimum
-                            min_dist = current_minimum_distance;
-                            result_coordinate = m_coordinate_list->at(current_edge.u);
+                            const float current_minimum_distance =
+                                FixedPointCoordinate::ApproximateEuclideanDistance(
+                                    input_coordinate.lat,
+                                    input_coordinate.lon,
+                                    current_leaf_node.u_lats[i],
+                                    current_leaf_node.u_lons[i]);
+                            if (current_minimum_distance < min_dist)
+                            {
+                                // found a new minimum
+                                min_dist = current_minimum_distance;
+                                result_coordinate = current_leaf_node.GetU(i);
+                            }
                         }
 
-                        current_minimum_distance =
-                            FixedPointCoordinate::ApproximateEuclideanDistance(
-                                input_coordinate.lat,
-                                input_coordinate.lon,
-                                m_coordinate_list->at(current_edge.v).lat,
-                                m_coordinate_list->at(current_edge.v).lon);
-
-                        if (current_minimum_distance < min_dist)
+                        if (IsBelow(v_squared_distances[i], min_dist))
                         {
-                            // found a new minimum
-                            min_dist = current_minimum_distance;
-                            result_coordinate = m_coordinate_list->at(current_edge.v);
+                            const float current_minimum_distance =
+                                FixedPointCoordinate::ApproximateEuclideanDistance(
+                                    input_coordinate.lat,
+                                    input_coordinate.lon,
+                                    current_leaf_node.v_lats[i],
+                                    current_leaf_node.v_lons[i]);
+                            if (current_minimum_distance < min_dist)
+                            {
+                                // found a new minimum
+                                min_dist = current_minimum_distance;
+                                result_coordinate = current_leaf_node.GetV(i);
+                            }
                         }
                     }
                 }
@@ -669,6 +810,8 @@ class StaticRTree
         unsigned number_of_results_found_in_big_cc = 0;
         unsigned number_of_results_found_in_tiny_cc = 0;
 
+        std::vector<float> squared_distances;
+
         // initialize queue with root element
         std::priority_queue<IncrementalQueryCandidate> traversal_queue;
         traversal_queue.emplace(0.f, m_search_tree[0]);
@@ -700,23 +843,30 @@ class StaticRTree
                     //     current_tree_node.minimum_bounding_rectangle.max_lat/COORDINATE_PRECISION << "-" <<
                     //     current_tree_node.minimum_bounding_rectangle.max_lon/COORDINATE_PRECISION << "]";
 
-                    LeafNode current_leaf_node;
-                    LoadLeafFromDisk(current_tree_node.children[0], current_leaf_node);
+                    const LeafNode current_leaf_node = GetLeafNode(current_tree_node.children[0]);
+                    ComputeSegmentLowerBounds(input_coordinate,
+                                              current_tree_node.minimum_bounding_rectangle,
+                                              current_leaf_node,
+                                              squared_distances);
                     // Add all objects from leaf into queue
                     for (uint32_t i = 0; i < current_leaf_node.object_count; ++i)
                     {
-                        const auto &current_edge = current_leaf_node.objects[i];
+                        // the bound only filters, queue order and acceptance use the reference
+                        if (!IsBelow(squared_distances[i],
+                                     current_min_dist + osrm::SEGMENT_LOWER_BOUND_SLACK_IN_METERS))
+                        {
+                            ++ignored_segments;
+                            continue;
+                        }
                         const float current_perpendicular_distance =
-                            FixedPointCoordinate::ComputePerpendicularDistance(
-                                m_coordinate_list->at(current_edge.u),
-                                m_coordinate_list->at(current_edge.v),
-                                input_coordinate);
+                            ComputeSegmentDistance(input_coordinate, current_leaf_node, i);
                         // distance must be non-negative
                         BOOST_ASSERT(0. <= current_perpendicular_distance);
 
                         if (current_perpendicular_distance < current_min_dist)
                         {
-                            traversal_queue.emplace(current_perpendicular_distance, current_edge);
+                            traversal_queue.emplace(current_perpendicular_distance,
+                                                    current_leaf_node.objects[i]);
                         }
                         else
                         {
@@ -860,226 +1010,6 @@ class StaticRTree
         return !result_phantom_node_vector.empty();
     }
     
-    // implementation of the Hjaltason/Samet query [3], a BFS traversal of the tree
-    bool
-    IncrementalFindPhantomPoiNodeForCoordinate(const FixedPointCoordinate &input_coordinate,
-                                            std::vector<PhantomNode> &result_phantom_node_vector,
-                                            const unsigned zoom_level,
-                                            const unsigned number_of_results,
-                                            const unsigned max_checked_segments = 4*LEAF_NODE_SIZE)
-    {
-        // TIMER_START(samet);
-        // SimpleLogger().Write(logDEBUG) << "searching for " << number_of_results << " results";
-        std::vector<float> min_found_distances(number_of_results, std::numeric_limits<float>::max());
-        
-        unsigned dequeues = 0;
-        unsigned inspected_mbrs = 0;
-        unsigned loaded_leafs = 0;
-        unsigned inspected_segments = 0;
-        unsigned pruned_elements = 0;
-        unsigned ignored_segments = 0;
-        unsigned ignored_mbrs = 0;
-        
-        unsigned number_of_results_found_in_big_cc = 0;
-        unsigned number_of_results_found_in_tiny_cc = 0;
-        
-        // initialize queue with root element
-        std::priority_queue<IncrementalQueryCandidate> traversal_queue;
-        traversal_queue.emplace(0.f, m_search_tree[0]);
-        
-        while (!traversal_queue.empty())
-        {
-            const IncrementalQueryCandidate current_query_node = traversal_queue.top();
-            traversal_queue.pop();
-            
-            ++dequeues;
-            
-            const float current_min_dist = min_found_distances[number_of_results-1];
-            
-            if (current_query_node.min_dist > current_min_dist)
-            {
-                ++pruned_elements;
-                continue;
-            }
-            
-            if (current_query_node.node.template is<TreeNode>())
-            {
-                const TreeNode & current_tree_node = current_query_node.node.template get<TreeNode>();
-                if (current_tree_node.child_is_on_disk)
-                {
-                    ++loaded_leafs;
-                    // SimpleLogger().Write(logDEBUG) << "loading leaf: " << current_tree_node.children[0] << " w/ mbr [" <<
-                    //     current_tree_node.minimum_bounding_rectangle.min_lat/COORDINATE_PRECISION << "," <<
-                    //     current_tree_node.minimum_bounding_rectangle.min_lon/COORDINATE_PRECISION << "," <<
-                    //     current_tree_node.minimum_bounding_rectangle.max_lat/COORDINATE_PRECISION << "-" <<
-                    //     current_tree_node.minimum_bounding_rectangle.max_lon/COORDINATE_PRECISION << "]";
-                    
-                    LeafNode current_leaf_node;
-                    LoadLeafFromDisk(current_tree_node.children[0], current_leaf_node);
-                    // Add all objects from leaf into queue
-                    for (uint32_t i = 0; i < current_leaf_node.object_count; ++i)
-                    {
-                        const auto &current_edge = current_leaf_node.objects[i];
-                        const float current_perpendicular_distance =
-                        FixedPointCoordinate::ComputePerpendicularDistance(
-                                                                           m_coordinate_list->at(current_edge.u),
-                                                                           m_coordinate_list->at(current_edge.v),
-                                                                           input_coordinate);
-                        // distance must be non-negative
-                        BOOST_ASSERT(0. <= current_perpendicular_distance);
-                        
-                        if (current_perpendicular_distance < current_min_dist)
-                        {
-                            traversal_queue.emplace(current_perpendicular_distance, current_edge);
-                        }
-                        else
-                        {
-                            ++ignored_segments;
-                        }
-                    }
-                    // SimpleLogger().Write(logDEBUG) << "added " << current_leaf_node.object_count << " roads into queue of " << traversal_queue.size();
-                }
-                else
-                {
-                    ++inspected_mbrs;
-                    // explore inner node
-                    // SimpleLogger().Write(logDEBUG) << "explore inner node w/ mbr [" <<
-                    //     current_tree_node.minimum_bounding_rectangle.min_lat/COORDINATE_PRECISION << "," <<
-                    //     current_tree_node.minimum_bounding_rectangle.min_lon/COORDINATE_PRECISION << "," <<
-                    //     current_tree_node.minimum_bounding_rectangle.max_lat/COORDINATE_PRECISION << "-" <<
-                    //     current_tree_node.minimum_bounding_rectangle.max_lon/COORDINATE_PRECISION << "," << "]";
-                    
-                    // for each child mbr
-                    for (uint32_t i = 0; i < current_tree_node.child_count; ++i)
-                    {
-                        const int32_t child_id = current_tree_node.children[i];
-                        const TreeNode &child_tree_node = m_search_tree[child_id];
-                        const RectangleT &child_rectangle = child_tree_node.minimum_bounding_rectangle;
-                        const float lower_bound_to_element = child_rectangle.GetMinDist(input_coordinate);
-                        
-                        // TODO - enough elements found, i.e. nearest distance > maximum distance?
-                        //        ie. some measure of 'confidence of accuracy'
-                        
-                        // check if it needs to be explored by mindist
-                        if (lower_bound_to_element < current_min_dist)
-                        {
-                            traversal_queue.emplace(lower_bound_to_element, child_tree_node);
-                        }
-                        else
-                        {
-                            ++ignored_mbrs;
-                        }
-                    }
-                    // SimpleLogger().Write(logDEBUG) << "added " << current_tree_node.child_count << " mbrs into queue of " << traversal_queue.size();
-                }
-            }
-            else
-            {
-                ++inspected_segments;
-                // inspecting an actual road segment
-                const EdgeDataT & current_segment = current_query_node.node.template get<EdgeDataT>();
-                
-                // don't collect too many results from small components
-                if (number_of_results_found_in_big_cc == number_of_results && !current_segment.is_in_tiny_cc)
-                {
-                    continue;
-                }
-                
-                // don't collect too many results from big components
-                if (number_of_results_found_in_tiny_cc == number_of_results && current_segment.is_in_tiny_cc)
-                {
-                    continue;
-                }
-                
-                //only collect pois
-                if ( m_poi_node_ids.find( current_segment.u ) == m_poi_node_ids.end() &&
-                    m_poi_node_ids.find( current_segment.v ) == m_poi_node_ids.end()) {
-                    continue ;
-                }
-                
-                // check if it is smaller than what we had before
-                float current_ratio = 0.;
-                FixedPointCoordinate foot_point_coordinate_on_segment;
-                const float current_perpendicular_distance =
-                FixedPointCoordinate::ComputePerpendicularDistance(
-                                                                   m_coordinate_list->at(current_segment.u),
-                                                                   m_coordinate_list->at(current_segment.v),
-                                                                   input_coordinate,
-                                                                   foot_point_coordinate_on_segment,
-                                                                   current_ratio);
-                
-                BOOST_ASSERT(0. <= current_perpendicular_distance);
-                
-                if ((current_perpendicular_distance < current_min_dist) &&
-                    !osrm::epsilon_compare(current_perpendicular_distance, current_min_dist))
-                {
-                    // store phantom node in result vector
-                    result_phantom_node_vector.emplace_back(
-                                                            current_segment.forward_edge_based_node_id,
-                                                            current_segment.reverse_edge_based_node_id,
-                                                            current_segment.name_id,
-                                                            current_segment.forward_weight,
-                                                            current_segment.reverse_weight,
-                                                            current_segment.forward_offset,
-                                                            current_segment.reverse_offset,
-                                                            current_segment.packed_geometry_id,
-                                                            foot_point_coordinate_on_segment,
-                                                            current_segment.fwd_segment_position,
-                                                            current_segment.forward_travel_mode,
-                                                            current_segment.backward_travel_mode);
-                    
-                    // Hack to fix rounding errors and wandering via nodes.
-                    FixUpRoundingIssue(input_coordinate, result_phantom_node_vector.back());
-                    
-                    // set forward and reverse weights on the phantom node
-                    SetForwardAndReverseWeightsOnPhantomNode(current_segment,
-                                                             result_phantom_node_vector.back());
-                    
-                    // do we have results only in a small scc
-                    if (current_segment.is_in_tiny_cc)
-                    {
-                        ++number_of_results_found_in_tiny_cc;
-                    }
-                    else
-                    {
-                        // found an element in a large component
-                        min_found_distances[number_of_results_found_in_big_cc] = current_perpendicular_distance;
-                        ++number_of_results_found_in_big_cc;
-                        // SimpleLogger().Write(logDEBUG) << std::setprecision(8) << foot_point_coordinate_on_segment << " at " << current_perpendicular_distance;
-                    }
-                }
-            }
-            
-            // TODO add indicator to prune if maxdist > threshold
-            if (number_of_results == number_of_results_found_in_big_cc || inspected_segments >= max_checked_segments)
-            {
-                // SimpleLogger().Write(logDEBUG) << "flushing queue of " << traversal_queue.size() << " elements";
-                // work-around for traversal_queue.clear();
-                traversal_queue = std::priority_queue<IncrementalQueryCandidate>{};
-            }
-        }
-        
-        // for (const PhantomNode& result_node : result_phantom_node_vector)
-        // {
-        //     SimpleLogger().Write(logDEBUG) << std::setprecision(8) << "found location " << result_node.forward_node_id << " at " << result_node.location;
-        // }
-        // SimpleLogger().Write(logDEBUG) << "dequeues: " << dequeues;
-        // SimpleLogger().Write(logDEBUG) << "inspected_mbrs: " << inspected_mbrs;
-        // SimpleLogger().Write(logDEBUG) << "loaded_leafs: " << loaded_leafs;
-        // SimpleLogger().Write(logDEBUG) << "inspected_segments: " << inspected_segments;
-        // SimpleLogger().Write(logDEBUG) << "pruned_elements: " << pruned_elements;
-        // SimpleLogger().Write(logDEBUG) << "ignored_segments: " << ignored_segments;
-        // SimpleLogger().Write(logDEBUG) << "ignored_mbrs: " << ignored_mbrs;
-        
-        // SimpleLogger().Write(logDEBUG) << "number_of_results_found_in_big_cc: " << number_of_results_found_in_big_cc;
-        // SimpleLogger().Write(logDEBUG) << "number_of_results_found_in_tiny_cc: " << number_of_results_found_in_tiny_cc;
-        // TIMER_STOP(samet);
-        // SimpleLogger().Write() << "query took " << TIMER_MSEC(samet) << "ms";
-        
-        // if we found an element in either category, then we are good
-        return !result_phantom_node_vector.empty();
-    }
-    
     
 
     // implementation of the Hjaltason/Samet query [3], a BFS traversal of the tree
@@ -1097,6 +1027,8 @@ class StaticRTree
 
         unsigned inspected_segments = 0;
 
+        std::vector<float> squared_distances;
+
         // initialize queue with root element
         std::priority_queue<IncrementalQueryCandidate> traversal_queue;
         traversal_queue.emplace(0.f, m_search_tree[0]);
@@ -1118,23 +1050,28 @@ class StaticRTree
                 const TreeNode & current_tree_node = current_query_node.node.template get<TreeNode>();
                 if (current_tree_node.child_is_on_disk)
                 {
-                    LeafNode current_leaf_node;
-                    LoadLeafFromDisk(current_tree_node.children[0], current_leaf_node);
+                    const LeafNode current_leaf_node = GetLeafNode(current_tree_node.children[0]);
+                    ComputeSegmentLowerBounds(input_coordinate,
+                                              current_tree_node.minimum_bounding_rectangle,
+                                              current_leaf_node,
+                                              squared_distances);
                     // Add all objects from leaf into queue
                     for (uint32_t i = 0; i < current_leaf_node.object_count; ++i)
                     {
-                        const auto &current_edge = current_leaf_node.objects[i];
+                        if (!IsBelow(squared_distances[i],
+                                     current_min_dist + osrm::SEGMENT_LOWER_BOUND_SLACK_IN_METERS))
+                        {
+                            continue;
+                        }
                         const float current_perpendicular_distance =
-                            FixedPointCoordinate::ComputePerpendicularDistance(
-                                m_coordinate_list->at(current_edge.u),
-                                m_coordinate_list->at(current_edge.v),
-                                input_coordinate);
+                            ComputeSegmentDistance(input_coordinate, current_leaf_node, i);
                         // distance must be non-negative
                         BOOST_ASSERT(0. <= current_perpendicular_distance);
 
                         if (current_perpendicular_distance < current_min_dist)
                         {
-                            traversal_queue.emplace(current_perpendicular_distance, current_edge);
+                            traversal_queue.emplace(current_perpendicular_distance,
+                                                    current_leaf_node.objects[i]);
                         }
                     }
                 }
@@ -1269,12 +1206,10 @@ class StaticRTree
                 const TreeNode &current_tree_node = m_search_tree[current_query_node.node_id];
                 if (current_tree_node.child_is_on_disk)
                 {
-                    LeafNode current_leaf_node;
-                    LoadLeafFromDisk(current_tree_node.children[0], current_leaf_node);
+                    const LeafNode current_leaf_node = GetLeafNode(current_tree_node.children[0]);
                     for (uint32_t i = 0; i < current_leaf_node.object_count; ++i)
                     {
-                        const EdgeDataT &current_edge = current_leaf_node.objects[i];
-                        if (ignore_tiny_components && current_edge.is_in_tiny_cc)
+                        if (ignore_tiny_components && current_leaf_node.is_in_tiny_cc[i])
                         {
                             continue;
                         }
@@ -1283,8 +1218,8 @@ class StaticRTree
                         FixedPointCoordinate nearest;
                         const float current_perpendicular_distance =
                             FixedPointCoordinate::ComputePerpendicularDistance(
-                                m_coordinate_list->at(current_edge.u),
-                                m_coordinate_list->at(current_edge.v),
+                                current_leaf_node.GetU(i),
+                                current_leaf_node.GetV(i),
                                 input_coordinate,
                                 nearest,
                                 current_ratio);
@@ -1294,6 +1229,7 @@ class StaticRTree
                         if ((current_perpendicular_distance < min_dist) &&
                             !osrm::epsilon_compare(current_perpendicular_distance, min_dist))
                         { // found a new minimum
+                            const EdgeDataT &current_edge = current_leaf_node.objects[i];
                             min_dist = current_perpendicular_distance;
                             result_phantom_node = {current_edge.forward_edge_based_node_id,
                                                    current_edge.reverse_edge_based_node_id,
@@ -1333,7 +1269,192 @@ class StaticRTree
         return result_phantom_node.location.isValid();
     }
 
+    // Batched variants of the phantom node queries, results are stored in input order. The
+    // inputs are snapped in the Hilbert order of the tree itself, so consecutive searches descend
+    // into the same inner nodes and scan the same leaves while these are still cached. Large
+    // batches are split over threads in contiguous runs of that order.
+    bool FindPhantomNodesForCoordinates(const std::vector<FixedPointCoordinate> &input_coordinates,
+                                        std::vector<PhantomNode> &result_phantom_nodes,
+                                        const unsigned zoom_level)
+    {
+        result_phantom_nodes.clear();
+        result_phantom_nodes.resize(input_coordinates.size());
+        std::vector<char> found(input_coordinates.size(), 0);
+        ForEachInHilbertOrder(input_coordinates,
+                              [&](const uint32_t index)
+                              {
+            found[index] = FindPhantomNodeForCoordinate(
+                input_coordinates[index], result_phantom_nodes[index], zoom_level);
+        });
+        return std::all_of(found.begin(), found.end(), [](const char f) { return 0 != f; });
+    }
+
+    bool IncrementalFindPhantomNodesForCoordinates(
+        const std::vector<FixedPointCoordinate> &input_coordinates,
+        std::vector<std::vector<PhantomNode>> &result_phantom_node_vectors,
+        const unsigned zoom_level,
+        const unsigned number_of_results)
+    {
+        result_phantom_node_vectors.clear();
+        result_phantom_node_vectors.resize(input_coordinates.size());
+        std::vector<char> found(input_coordinates.size(), 0);
+        ForEachInHilbertOrder(input_coordinates,
+                              [&](const uint32_t index)
+                              {
+            found[index] =
+                IncrementalFindPhantomNodeForCoordinate(input_coordinates[index],
+                                                        result_phantom_node_vectors[index],
+                                                        zoom_level,
+                                                        number_of_results);
+        });
+        return std::all_of(found.begin(), found.end(), [](const char f) { return 0 != f; });
+    }
+
+    // Range queries: the callback is invoked once for every segment that intersects the
+    // rectangle, or whose perpendicular distance to the center is at most max_distance meters.
+    // Results are reported in leaf order while the tree is traversed, nothing is buffered.
+    // The traversal stops as soon as the callback returns false, false is then returned.
+    template <typename CallbackT>
+    bool ForEachSegmentInRectangle(const RectangleInt2D &search_rectangle, CallbackT &&callback)
+    {
+        std::vector<uint32_t> traversal_stack(1, 0);
+        while (!traversal_stack.empty())
+        {
+            const TreeNode &current_tree_node = m_search_tree[traversal_stack.back()];
+            traversal_stack.pop_back();
+            if (!current_tree_node.minimum_bounding_rectangle.Intersects(search_rectangle))
+            {
+                continue;
+            }
+
+            if (current_tree_node.child_is_on_disk)
+            {
+                const LeafNode current_leaf_node = GetLeafNode(current_tree_node.children[0]);
+                for (uint32_t i = 0; i < current_leaf_node.object_count; ++i)
+                {
+                    if (search_rectangle.Intersects(current_leaf_node.GetU(i),
+                                                    current_leaf_node.GetV(i)) &&
+                        !callback(current_leaf_node.objects[i]))
+                    {
+                        return false;
+                    }
+                }
+                continue;
+            }
+
+            for (uint32_t i = 0; i < current_tree_node.child_count; ++i)
+            {
+                traversal_stack.push_back(current_tree_node.children[i]);
+            }
+        }
+        return true;
+    }
+
+    template <typename CallbackT>
+    bool ForEachSegmentInRadius(const FixedPointCoordinate &center,
+                                const float max_distance,
+                                CallbackT &&callback)
+    {
+        std::vector<uint32_t> traversal_stack(1, 0);
+        while (!traversal_stack.empty())
+        {
+            const TreeNode &current_tree_node = m_search_tree[traversal_stack.back()];
+            traversal_stack.pop_back();
+            if (current_tree_node.minimum_bounding_rectangle.GetMinDist(center) > max_distance)
+            {
+                continue;
+            }
+
+            if (current_tree_node.child_is_on_disk)
+            {
+                const LeafNode current_leaf_node = GetLeafNode(current_tree_node.children[0]);
+                for (uint32_t i = 0; i < current_leaf_node.object_count; ++i)
+                {
+                    const float current_perpendicular_distance =
+                        FixedPointCoordinate::ComputePerpendicularDistance(
+                            current_leaf_node.GetU(i), current_leaf_node.GetV(i), center);
+                    if (current_perpendicular_distance <= max_distance &&
+                        !callback(current_leaf_node.objects[i]))
+                    {
+                        return false;
+                    }
+                }
+                continue;
+            }
+
+            for (uint32_t i = 0; i < current_tree_node.child_count; ++i)
+            {
+                traversal_stack.push_back(current_tree_node.children[i]);
+            }
+        }
+        return true;
+    }
+
+    void FindSegmentsInRectangle(const RectangleInt2D &search_rectangle,
+                                 std::vector<EdgeDataT> &result_segments)
+    {
+        ForEachSegmentInRectangle(search_rectangle,
+                                  [&result_segments](const EdgeDataT &segment)
+                                  {
+            result_segments.emplace_back(segment);
+            return true;
+        });
+    }
+
+    void FindSegmentsInRadius(const FixedPointCoordinate &center,
+                              const float max_distance,
+                              std::vector<EdgeDataT> &result_segments)
+    {
+        ForEachSegmentInRadius(center,
+                               max_distance,
+                               [&result_segments](const EdgeDataT &segment)
+                               {
+            result_segments.emplace_back(segment);
+            return true;
+        });
+    }
+
   private:
+    template <typename QueryT>
+    void ForEachInHilbertOrder(const std::vector<FixedPointCoordinate> &input_coordinates,
+                               QueryT &&query)
+    {
+        // below this size a batch is not worth spreading over threads
+        constexpr uint32_t PARALLEL_BATCH_SIZE = 128;
+        constexpr uint32_t BATCH_GRAIN_SIZE = 32;
+
+        HilbertCode get_hilbert_number;
+        std::vector<WrappedInputElement> input_order;
+        input_order.reserve(input_coordinates.size());
+        for (uint32_t i = 0; i < input_coordinates.size(); ++i)
+        {
+            // same mercator projection as the tree construction, clamped to its valid range
+            const double lat = input_coordinates[i].lat / static_cast<double>(COORDINATE_PRECISION);
+            const FixedPointCoordinate projected(
+                COORDINATE_PRECISION * lat2y(std::max(-85., std::min(85., lat))),
+                input_coordinates[i].lon);
+            input_order.emplace_back(get_hilbert_number(projected), i);
+        }
+        std::sort(input_order.begin(), input_order.end());
+
+        if (input_order.size() < PARALLEL_BATCH_SIZE)
+        {
+            for (const WrappedInputElement &element : input_order)
+            {
+                query(element.m_array_index);
+            }
+            return;
+        }
+
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, input_order.size(), BATCH_GRAIN_SIZE),
+                          [&input_order, &query](const tbb::blocked_range<std::size_t> &range)
+                          {
+            for (std::size_t i = range.begin(); i != range.end(); ++i)
+            {
+                query(input_order[i].m_array_index);
+            }
+        });
+    }
 
     inline void SetForwardAndReverseWeightsOnPhantomNode(const EdgeDataT & nearest_edge,
                                                          PhantomNode &result_phantom_node) const
@@ -1398,23 +1519,183 @@ class StaticRTree
         return new_min_max_dist;
     }
 
-    inline void LoadLeafFromDisk(const uint32_t leaf_id, LeafNode &result_node)
+    void MapLeafFile(const boost::filesystem::path &leaf_file)
     {
-        if (!leaves_stream.is_open())
+        if (!boost::filesystem::exists(leaf_file))
+        {
+            throw OSRMException("mem index file does not exist");
+        }
+        if (boost::filesystem::file_size(leaf_file) < sizeof(LeafFileHeader))
+        {
+            throw OSRMException("mem index file is empty or truncated");
+        }
+
+        m_leaves_mapping = boost::interprocess::file_mapping(leaf_file.string().c_str(),
+                                                             boost::interprocess::read_only);
+        m_leaves_region =
+            boost::interprocess::mapped_region(m_leaves_mapping, boost::interprocess::read_only);
+        // leaves are visited at random, ask the kernel to page the whole file in up front
+        m_leaves_region.advise(boost::interprocess::mapped_region::advice_willneed);
+
+        if (m_leaves_region.get_size() < sizeof(LeafFileHeader))
+        {
+            throw OSRMException("mem index file is truncated");
+        }
+        const char *leaves_base = static_cast<const char *>(m_leaves_region.get_address());
+        const LeafFileHeader &leaf_file_header =
+            *reinterpret_cast<const LeafFileHeader *>(leaves_base);
+        if (!HasLeafFileMagic(leaf_file_header) || LEAF_FILE_VERSION != leaf_file_header.version)
+        {
+            throw OSRMException("mem index file has an unknown format, re-run osrm-prepare");
+        }
+        if (sizeof(EdgeDataT) != leaf_file_header.object_size)
+        {
+            throw OSRMException("mem index file was prepared with a different build");
+        }
+        if (0 == leaf_file_header.leaf_node_size)
+        {
+            throw OSRMException("mem index file has an invalid leaf size");
+        }
+        m_element_count = leaf_file_header.element_count;
+        m_leaf_layout = LeafLayout(leaf_file_header.leaf_node_size);
+        m_number_of_leaves = (m_element_count + m_leaf_layout.leaf_node_size - 1) /
+                             m_leaf_layout.leaf_node_size;
+        if (m_leaves_region.get_size() !=
+            sizeof(LeafFileHeader) + m_number_of_leaves * m_leaf_layout.leaf_size)
+        {
+            throw OSRMException("mem index file size does not match its header");
+        }
+        m_leaves = leaves_base + sizeof(LeafFileHeader);
+
+        // the tree is read from another file, its leaf references must lie within this one
+        for (const TreeNode &tree_node : m_search_tree)
         {
-            leaves_stream.open(m_leaf_node_filename, std::ios::in | std::ios::binary);
+            if (tree_node.child_is_on_disk && tree_node.children[0] >= m_number_of_leaves)
+            {
+                throw OSRMException("ram index refers to leaves beyond the mem index file");
+            }
         }
-        if (!leaves_stream.good())
+    }
+
+    // leaf ids are checked against the leaf file when it is mapped
+    inline LeafNode GetLeafNode(const uint32_t leaf_id) const
+    {
+        BOOST_ASSERT(leaf_id < m_number_of_leaves);
+        return LeafNode(m_leaves + leaf_id * m_leaf_layout.leaf_size, m_leaf_layout);
+    }
+
+    // Lower bounds of the distances between the query and a leaf's segments, up to
+    // SEGMENT_LOWER_BOUND_SLACK_IN_METERS. The reference distance is measured to a foot point
+    // inside the leaf with longitudes scaled at a latitude no higher than the highest absolute
+    // latitude of the query and the leaf.
+    inline void ComputeSegmentLowerBounds(const FixedPointCoordinate &input_coordinate,
+                                          const RectangleInt2D &leaf_rectangle,
+                                          const LeafNode &leaf_node,
+                                          std::vector<float> &squared_distances) const
+    {
+        const int max_abs_lat = std::max(std::abs(input_coordinate.lat),
+                                         std::max(std::abs(leaf_rectangle.min_lat),
+                                                  std::abs(leaf_rectangle.max_lat)));
+        const float lon_scale = std::max(0.f, osrm::LongitudeScaleAt(max_abs_lat));
+        squared_distances.resize(leaf_node.object_count);
+        osrm::ComputeSquaredSegmentDistances(input_coordinate,
+                                             lon_scale,
+                                             leaf_node.u_lats,
+                                             leaf_node.u_lons,
+                                             leaf_node.v_lats,
+                                             leaf_node.v_lons,
+                                             leaf_node.object_count,
+                                             squared_distances.data());
+    }
+
+    // Lower bounds of the distances between the query and the end points of a leaf's segments.
+    // ApproximateEuclideanDistance scales longitudes by the cosine of the mean latitude, which is
+    // never smaller than the cosine at the highest absolute latitude of the query and the leaf.
+    inline void ComputeEndPointLowerBounds(const FixedPointCoordinate &input_coordinate,
+                                           const RectangleInt2D &leaf_rectangle,
+                                           const LeafNode &leaf_node,
+                                           std::vector<float> &u_squared_distances,
+                                           std::vector<float> &v_squared_distances) const
+    {
+        const int max_abs_lat = std::max(std::abs(input_coordinate.lat),
+                                         std::max(std::abs(leaf_rectangle.min_lat),
+                                                  std::abs(leaf_rectangle.max_lat)));
+        const float lon_scale = std::max(0.f, osrm::LongitudeScaleAt(max_abs_lat));
+
+        // a segment from a point to itself yields the distance to that point
+        u_squared_distances.resize(leaf_node.object_count);
+        osrm::ComputeSquaredSegmentDistances(input_coordinate,
+                                             lon_scale,
+                                             leaf_node.u_lats,
+                                             leaf_node.u_lons,
+                                             leaf_node.u_lats,
+                                             leaf_node.u_lons,
+                                             leaf_node.object_count,
+                                             u_squared_distances.data());
+        v_squared_distances.resize(leaf_node.object_count);
+        osrm::ComputeSquaredSegmentDistances(input_coordinate,
+                                             lon_scale,
+                                             leaf_node.v_lats,
+                                             leaf_node.v_lons,
+                                             leaf_node.v_lats,
+                                             leaf_node.v_lons,
+                                             leaf_node.object_count,
+                                             v_squared_distances.data());
+    }
+
+    // the reference distance that the segment is accepted with once it is dequeued
+    static inline float ComputeSegmentDistance(const FixedPointCoordinate &input_coordinate,
+                                               const LeafNode &leaf_node,
+                                               const uint32_t i)
+    {
+        float ratio = 0.;
+        FixedPointCoordinate foot_point_coordinate_on_segment;
+        return FixedPointCoordinate::ComputePerpendicularDistance(leaf_node.GetU(i),
+                                                                  leaf_node.GetV(i),
+                                                                  input_coordinate,
+                                                                  foot_point_coordinate_on_segment,
+                                                                  ratio);
+    }
+
+    // compares a lower bound in squared fixed point units against a distance in meters. The
+    // slack absorbs the rounding of the single precision reference computation.
+    static inline bool IsBelow(const float squared_lower_bound, const float distance)
+    {
+        const float bound_in_meters =
+            std::sqrt(squared_lower_bound) * osrm::FIXED_POINT_UNIT_IN_METERS;
+        return bound_in_meters * 0.999f < distance;
+    }
+
+    void SerializeLeaf(const std::vector<EdgeDataT> &leaf_objects,
+                       const std::vector<NodeInfo> &coordinate_list,
+                       std::vector<char> &leaf_buffer) const
+    {
+        const uint32_t object_count = static_cast<uint32_t>(leaf_objects.size());
+        const uint32_t leaf_node_size = m_leaf_layout.leaf_node_size;
+        BOOST_ASSERT(object_count <= leaf_node_size);
+
+        std::fill(leaf_buffer.begin(), leaf_buffer.end(), 0);
+        char *leaf_begin = leaf_buffer.data();
+        *reinterpret_cast<uint32_t *>(leaf_begin) = object_count;
+        int32_t *u_lats =
+            reinterpret_cast<int32_t *>(leaf_begin + m_leaf_layout.coordinates_offset);
+        int32_t *u_lons = u_lats + leaf_node_size;
+        int32_t *v_lats = u_lons + leaf_node_size;
+        int32_t *v_lons = v_lats + leaf_node_size;
+        uint8_t *is_in_tiny_cc =
+            reinterpret_cast<uint8_t *>(leaf_begin + m_leaf_layout.tiny_cc_offset);
+        EdgeDataT *objects =
+            reinterpret_cast<EdgeDataT *>(leaf_begin + m_leaf_layout.objects_offset);
+        for (uint32_t i = 0; i < object_count; ++i)
         {
-            leaves_stream.clear(std::ios::goodbit);
-            SimpleLogger().Write(logDEBUG) << "Resetting stale filestream";
+            const EdgeDataT &object = leaf_objects[i];
+            u_lats[i] = coordinate_list.at(object.u).lat;
+            u_lons[i] = coordinate_list.at(object.u).lon;
+            v_lats[i] = coordinate_list.at(object.v).lat;
+            v_lons[i] = coordinate_list.at(object.v).lon;
+            is_in_tiny_cc[i] = object.is_in_tiny_cc ? 1 : 0;
+            objects[i] = object;
         }
-        const uint64_t seek_pos = sizeof(uint64_t) + leaf_id * sizeof(LeafNode);
-        leaves_stream.seekg(seek_pos);
-        BOOST_ASSERT_MSG(leaves_stream.good(),
-                         "Seeking to position in leaf file failed.");
-        leaves_stream.read((char *)&result_node, sizeof(LeafNode));
-        BOOST_ASSERT_MSG(leaves_stream.good(), "Reading from leaf file failed.");
     }
 
     inline bool EdgesAreEquivalent(const FixedPointCoordinate &a,
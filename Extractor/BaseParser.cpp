@@ -47,6 +47,7 @@ BaseParser::BaseParser(ExtractorCallbacks *extractor_callbacks,
 {
     ReadUseRestrictionsSetting();
     ReadRestrictionExceptions();
+    ReadWayTagKeys();
 }
 
 void BaseParser::ReadUseRestrictionsSetting()
@@ -91,6 +92,21 @@ void BaseParser::ReadRestrictionExceptions()
     }
 }
 
+void BaseParser::ReadWayTagKeys()
+{
+    if (lua_function_exists(lua_state, "get_way_tag_keys"))
+    {
+        // get list of tags that way_function depends on
+        luabind::call_function<void>(lua_state, "get_way_tag_keys", boost::ref(way_tag_keys));
+        SimpleLogger().Write() << "Caching way profile results keyed by " << way_tag_keys.size()
+                               << " tags";
+    }
+    else
+    {
+        SimpleLogger().Write() << "Profile declares no way tag keys, way results are not cached";
+    }
+}
+
 void BaseParser::report_errors(lua_State *lua_state, const int status) const
 {
     if (0 != status)
@@ -105,9 +121,71 @@ void BaseParser::ParseNodeInLua(ImportNode &node, lua_State *local_lua_state)
     luabind::call_function<void>(local_lua_state, "node_function", boost::ref(node));
 }
 
+namespace
+{
+// copies everything way_function may set, but not the id, nodes and tags of the way
+void CopyProfileResult(const ExtractionWay &source, ExtractionWay &target)
+{
+    target.name = source.name;
+    target.forward_speed = source.forward_speed;
+    target.backward_speed = source.backward_speed;
+    target.duration = source.duration;
+    target.access = source.access;
+    target.roundabout = source.roundabout;
+    target.isAccessRestricted = source.isAccessRestricted;
+    target.ignoreInGrid = source.ignoreInGrid;
+    target.forward_travel_mode = source.forward_travel_mode;
+    target.backward_travel_mode = source.backward_travel_mode;
+}
+}
+
 void BaseParser::ParseWayInLua(ExtractionWay &way, lua_State *local_lua_state)
 {
+    if (way_tag_keys.empty())
+    {
+        luabind::call_function<void>(local_lua_state, "way_function", boost::ref(way));
+        return;
+    }
+
+    // a missing tag and an empty value are told apart, the profile may check for both
+    std::string cache_key;
+    for (const std::string &key : way_tag_keys)
+    {
+        if (way.keyVals.Holds(key))
+        {
+            cache_key += '+';
+            cache_key += way.keyVals.Find(key);
+        }
+        cache_key += '\0';
+    }
+
+    WayCache &cache = way_caches.local();
+    const auto cache_iterator = cache.results.find(cache_key);
+    if (cache.results.end() != cache_iterator)
+    {
+        ++cache.hits;
+        CopyProfileResult(cache_iterator->second, way);
+        return;
+    }
+
+    ++cache.misses;
     luabind::call_function<void>(local_lua_state, "way_function", boost::ref(way));
+    if (MAX_WAY_CACHE_SIZE <= cache.results.size())
+    {
+        cache.results.clear();
+    }
+    CopyProfileResult(way, cache.results[std::move(cache_key)]);
+}
+
+BaseParser::WayCacheStatistics BaseParser::GetWayCacheStatistics() const
+{
+    WayCacheStatistics statistics = {0, 0};
+    for (const WayCache &cache : way_caches)
+    {
+        statistics.hits += cache.hits;
+        statistics.misses += cache.misses;
+    }
+    return statistics;
 }
 
 bool BaseParser::ShouldIgnoreRestriction(const std::string &except_tag_string) const
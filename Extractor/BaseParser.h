@@ -28,13 +28,18 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef BASEPARSER_H_
 #define BASEPARSER_H_
 
+#include "ExtractionWay.h"
+
+#include <tbb/enumerable_thread_specific.h>
+
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 struct lua_State;
 class ExtractorCallbacks;
 class ScriptingEnvironment;
-struct ExtractionWay;
 struct ImportNode;
 
 class BaseParser
@@ -52,15 +57,36 @@ class BaseParser
     virtual void ParseWayInLua(ExtractionWay &way, lua_State *lua_state);
     virtual void report_errors(lua_State *lua_state, const int status) const;
 
+    struct WayCacheStatistics
+    {
+        uint64_t hits;
+        uint64_t misses;
+    };
+    WayCacheStatistics GetWayCacheStatistics() const;
+
   protected:
     virtual void ReadUseRestrictionsSetting();
     virtual void ReadRestrictionExceptions();
+    virtual void ReadWayTagKeys();
     virtual bool ShouldIgnoreRestriction(const std::string &except_tag_string) const;
 
+    // Results of way_function for the tag combinations seen by one thread. The profile declares
+    // which tags way_function reads, ways that agree on these tags get the same result.
+    struct WayCache
+    {
+        WayCache() : hits(0), misses(0) {}
+        std::unordered_map<std::string, ExtractionWay> results;
+        uint64_t hits;
+        uint64_t misses;
+    };
+    static const std::size_t MAX_WAY_CACHE_SIZE = 32 * 1024;
+
     ExtractorCallbacks *extractor_callbacks;
     lua_State *lua_state;
     ScriptingEnvironment &scripting_environment;
     std::vector<std::string> restriction_exceptions;
+    std::vector<std::string> way_tag_keys;
+    tbb::enumerable_thread_specific<WayCache> way_caches;
     bool use_turn_restrictions;
 };
 
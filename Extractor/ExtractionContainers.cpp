@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../Util/OSRMException.h"
 #include "../Util/simple_logger.hpp"
 #include "../Util/TimingUtil.h"
+#include "../DataStructures/ChunkedRecords.h"
 #include "../DataStructures/RangeTable.h"
 
 #include <boost/assert.hpp>
@@ -38,29 +39,278 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <stxxl/sort>
 
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
 #include <chrono>
 #include <limits>
 
-ExtractionContainers::ExtractionContainers()
+namespace
+{
+// the joins work on chunks of this many list entries
+const std::size_t JOIN_CHUNK_SIZE = 64 * 1024;
+// chunks joined in parallel before their output is written
+const std::size_t CHUNKS_PER_WAVE = 64;
+// output is written once this many bytes are buffered
+const std::size_t WRITE_BUFFER_SIZE = 4 * 1024 * 1024;
+
+// output of a join that only updates the list
+struct NoOutput
+{
+    void clear() {}
+    std::size_t size() const { return 0; }
+};
+
+// Merges a part of a list with the nodes, both are sorted by node id. Returns the number of
+// entries for which join added output.
+template <typename ListIteratorT,
+          typename NodeIteratorT,
+          typename GetKeyT,
+          typename JoinT,
+          typename OutputT>
+unsigned MergeWithNodes(ListIteratorT list_iterator,
+                        const ListIteratorT list_end,
+                        NodeIteratorT node_iterator,
+                        const NodeIteratorT node_end,
+                        const GetKeyT &get_key,
+                        const JoinT &join,
+                        OutputT &output)
+{
+    unsigned number_of_joined_entries = 0;
+    while (list_iterator != list_end && node_iterator != node_end)
+    {
+        const NodeID node_id = get_key(*list_iterator);
+        if (node_id < node_iterator->node_id)
+        {
+            ++list_iterator;
+            continue;
+        }
+        if (node_id > node_iterator->node_id)
+        {
+            ++node_iterator;
+            continue;
+        }
+        BOOST_ASSERT(node_id == node_iterator->node_id);
+        if (join(*list_iterator, *node_iterator, output))
+        {
+            ++number_of_joined_entries;
+        }
+        ++list_iterator;
+    }
+    return number_of_joined_entries;
+}
+
+// In memory, the list is cut into chunks by node id range that are joined in parallel. The
+// output of a wave of chunks is written in list order before the next wave starts.
+template <typename OutputT, typename T, typename GetKeyT, typename JoinT, typename WriteT>
+unsigned JoinWithNodes(ExtractionContainers::InternalVector<T> &list,
+                       ExtractionContainers::InternalVector<ExternalMemoryNode> &nodes,
+                       const GetKeyT &get_key,
+                       const JoinT &join,
+                       const WriteT &write)
+{
+    const std::size_t number_of_chunks = (list.size() + JOIN_CHUNK_SIZE - 1) / JOIN_CHUNK_SIZE;
+    std::vector<OutputT> outputs(std::min(number_of_chunks, CHUNKS_PER_WAVE));
+    std::vector<unsigned> joined_entries(outputs.size());
+    unsigned number_of_joined_entries = 0;
+    for (std::size_t wave_begin = 0; wave_begin < number_of_chunks; wave_begin += CHUNKS_PER_WAVE)
+    {
+        const std::size_t wave_end = std::min(number_of_chunks, wave_begin + CHUNKS_PER_WAVE);
+        tbb::parallel_for(wave_begin,
+                          wave_end,
+                          [&](const std::size_t chunk)
+                          {
+            const auto list_begin = list.begin() + chunk * JOIN_CHUNK_SIZE;
+            const auto list_end =
+                list.begin() + std::min(list.size(), (chunk + 1) * JOIN_CHUNK_SIZE);
+            // nodes below the first id of the chunk can not match any of its entries
+            const auto node_begin = std::lower_bound(
+                nodes.begin(),
+                nodes.end(),
+                get_key(*list_begin),
+                [](const ExternalMemoryNode &node, const NodeID node_id)
+                { return node.node_id < node_id; });
+            OutputT &output = outputs[chunk - wave_begin];
+            output.clear();
+            joined_entries[chunk - wave_begin] = MergeWithNodes(
+                list_begin, list_end, node_begin, nodes.end(), get_key, join, output);
+        });
+        for (std::size_t chunk = wave_begin; chunk < wave_end; ++chunk)
+        {
+            write(outputs[chunk - wave_begin]);
+            number_of_joined_entries += joined_entries[chunk - wave_begin];
+        }
+    }
+    return number_of_joined_entries;
+}
+
+// stxxl vectors must not be accessed concurrently, they are merged in a single sequential pass
+template <typename OutputT, typename T, typename GetKeyT, typename JoinT, typename WriteT>
+unsigned JoinWithNodes(ExtractionContainers::ExternalVector<T> &list,
+                       ExtractionContainers::ExternalVector<ExternalMemoryNode> &nodes,
+                       const GetKeyT &get_key,
+                       const JoinT &join,
+                       const WriteT &write)
 {
-    // Check if stxxl can be instantiated
-    stxxl::vector<unsigned> dummy_vector;
-    name_list.push_back("");
+    OutputT output;
+    const unsigned number_of_joined_entries = MergeWithNodes(
+        list.begin(),
+        list.end(),
+        nodes.begin(),
+        nodes.end(),
+        get_key,
+        [&join, &write](T &entry, const ExternalMemoryNode &node, OutputT &output)
+        {
+            const bool joined = join(entry, node, output);
+            if (WRITE_BUFFER_SIZE <= output.size())
+            {
+                write(output);
+                output.clear();
+            }
+            return joined;
+        },
+        output);
+    write(output);
+    return number_of_joined_entries;
+}
 }
 
-ExtractionContainers::~ExtractionContainers()
+ExtractionContainers::ExtractionContainers(const bool in_memory)
 {
-    used_node_id_list.clear();
-    all_nodes_list.clear();
-    all_edges_list.clear();
-    name_list.clear();
-    restrictions_list.clear();
-    way_start_end_id_list.clear();
+    if (in_memory)
+    {
+        internal_lists.reset(new Lists<InternalVector>());
+        internal_lists->name_list.push_back("");
+    }
+    else
+    {
+        // Check if stxxl can be instantiated
+        stxxl::vector<unsigned> dummy_vector;
+        external_lists.reset(new Lists<ExternalVector>());
+        external_lists->name_list.push_back("");
+    }
+}
+
+ExtractionContainers::~ExtractionContainers() {}
+
+void ExtractionContainers::AddNode(const ExternalMemoryNode &node)
+{
+    if (internal_lists)
+    {
+        internal_lists->all_nodes_list.push_back(node);
+    }
+    else
+    {
+        external_lists->all_nodes_list.push_back(node);
+    }
+}
+
+void ExtractionContainers::AddUsedNodeID(const NodeID node_id)
+{
+    if (internal_lists)
+    {
+        internal_lists->used_node_id_list.push_back(node_id);
+    }
+    else
+    {
+        external_lists->used_node_id_list.push_back(node_id);
+    }
+}
+
+void ExtractionContainers::AddEdge(const InternalExtractorEdge &edge)
+{
+    if (internal_lists)
+    {
+        internal_lists->all_edges_list.push_back(edge);
+    }
+    else
+    {
+        external_lists->all_edges_list.push_back(edge);
+    }
+}
+
+unsigned ExtractionContainers::AddName(const std::string &name)
+{
+    if (internal_lists)
+    {
+        internal_lists->name_list.push_back(name);
+        return static_cast<unsigned>(internal_lists->name_list.size() - 1);
+    }
+    external_lists->name_list.push_back(name);
+    return static_cast<unsigned>(external_lists->name_list.size() - 1);
+}
+
+void ExtractionContainers::AddRestriction(const InputRestrictionContainer &restriction)
+{
+    if (internal_lists)
+    {
+        internal_lists->restrictions_list.push_back(restriction);
+    }
+    else
+    {
+        external_lists->restrictions_list.push_back(restriction);
+    }
+}
+
+void ExtractionContainers::AddWayStartAndEndEdge(const WayIDStartAndEndEdge &way_start_and_end)
+{
+    if (internal_lists)
+    {
+        internal_lists->way_start_end_id_list.push_back(way_start_and_end);
+    }
+    else
+    {
+        external_lists->way_start_end_id_list.push_back(way_start_and_end);
+    }
+}
+
+bool ExtractionContainers::HasEdges() const
+{
+    if (internal_lists)
+    {
+        return !internal_lists->all_edges_list.empty();
+    }
+    return !external_lists->all_edges_list.empty();
+}
+
+template <typename T, typename CompareT>
+void ExtractionContainers::SortList(ExternalVector<T> &list, const CompareT &comparator)
+{
+    stxxl::sort(list.begin(), list.end(), comparator, stxxl_memory);
+}
+
+template <typename T, typename CompareT>
+void ExtractionContainers::SortList(InternalVector<T> &list, const CompareT &comparator)
+{
+    tbb::parallel_sort(list.begin(), list.end(), comparator);
 }
 
 void ExtractionContainers::PrepareData(const std::string &output_file_name,
                                        const std::string &restrictions_file_name)
 {
+    if (internal_lists)
+    {
+        PrepareLists(*internal_lists, output_file_name, restrictions_file_name);
+    }
+    else
+    {
+        PrepareLists(*external_lists, output_file_name, restrictions_file_name);
+    }
+}
+
+template <template <typename> class VectorT>
+void ExtractionContainers::PrepareLists(Lists<VectorT> &lists,
+                                        const std::string &output_file_name,
+                                        const std::string &restrictions_file_name)
+{
+    auto &used_node_id_list = lists.used_node_id_list;
+    auto &all_nodes_list = lists.all_nodes_list;
+    auto &all_edges_list = lists.all_edges_list;
+    auto &name_list = lists.name_list;
+    auto &restrictions_list = lists.restrictions_list;
+    auto &way_start_end_id_list = lists.way_start_end_id_list;
+
     try
     {
         unsigned number_of_used_nodes = 0;
@@ -68,7 +318,7 @@ void ExtractionContainers::PrepareData(const std::string &output_file_name,
 
         std::cout << "[extractor] Sorting used nodes        ... " << std::flush;
         TIMER_START(sorting_used_nodes);
-        stxxl::sort(used_node_id_list.begin(), used_node_id_list.end(), Cmp(), stxxl_memory);
+        SortList(used_node_id_list, Cmp());
         TIMER_STOP(sorting_used_nodes);
         std::cout << "ok, after " << TIMER_SEC(sorting_used_nodes) << "s" << std::endl;
 
@@ -82,24 +332,20 @@ void ExtractionContainers::PrepareData(const std::string &output_file_name,
 
         std::cout << "[extractor] Sorting all nodes         ... " << std::flush;
         TIMER_START(sorting_nodes);
-        stxxl::sort(all_nodes_list.begin(), all_nodes_list.end(), CmpNodeByID(), stxxl_memory);
+        SortList(all_nodes_list, CmpNodeByID());
         TIMER_STOP(sorting_nodes);
         std::cout << "ok, after " << TIMER_SEC(sorting_nodes) << "s" << std::endl;
 
 
         std::cout << "[extractor] Sorting used ways         ... " << std::flush;
         TIMER_START(sort_ways);
-        stxxl::sort(
-            way_start_end_id_list.begin(), way_start_end_id_list.end(), CmpWayByID(), stxxl_memory);
+        SortList(way_start_end_id_list, CmpWayByID());
         TIMER_STOP(sort_ways);
         std::cout << "ok, after " << TIMER_SEC(sort_ways) << "s" << std::endl;
 
         std::cout << "[extractor] Sorting restrictions. by from... " << std::flush;
         TIMER_START(sort_restrictions);
-        stxxl::sort(restrictions_list.begin(),
-                    restrictions_list.end(),
-                    CmpRestrictionContainerByFrom(),
-                    stxxl_memory);
+        SortList(restrictions_list, CmpRestrictionContainerByFrom());
         TIMER_STOP(sort_restrictions);
         std::cout << "ok, after " << TIMER_SEC(sort_restrictions) << "s" << std::endl;
 
@@ -153,10 +399,7 @@ void ExtractionContainers::PrepareData(const std::string &output_file_name,
 
         std::cout << "[extractor] Sorting restrictions. by to  ... " << std::flush;
         TIMER_START(sort_restrictions_to);
-        stxxl::sort(restrictions_list.begin(),
-                    restrictions_list.end(),
-                    CmpRestrictionContainerByTo(),
-                    stxxl_memory);
+        SortList(restrictions_list, CmpRestrictionContainerByTo());
         TIMER_STOP(sort_restrictions_to);
         std::cout << "ok, after " << TIMER_SEC(sort_restrictions_to) << "s" << std::endl;
 
@@ -227,39 +470,33 @@ void ExtractionContainers::PrepareData(const std::string &output_file_name,
         std::ofstream file_out_stream;
         file_out_stream.open(output_file_name.c_str(), std::ios::binary);
         file_out_stream.write((char *)&fingerprint, sizeof(FingerPrint));
+        chunked_records::WriteFormatHeader(file_out_stream);
+        const std::ios::pos_type number_of_nodes_position = file_out_stream.tellp();
         file_out_stream.write((char *)&number_of_used_nodes, sizeof(unsigned));
         std::cout << "[extractor] Confirming/Writing used nodes     ... " << std::flush;
         TIMER_START(write_nodes);
         // identify all used nodes by a merging step of two sorted lists
-        auto node_iterator = all_nodes_list.begin();
-        auto node_id_iterator = used_node_id_list.begin();
-        while (node_id_iterator != used_node_id_list.end() && node_iterator != all_nodes_list.end())
-        {
-            if (*node_id_iterator < node_iterator->node_id)
-            {
-                ++node_id_iterator;
-                continue;
-            }
-            if (*node_id_iterator > node_iterator->node_id)
+        number_of_used_nodes = JoinWithNodes<chunked_records::NodeChunkEncoder>(
+            used_node_id_list,
+            all_nodes_list,
+            [](const NodeID node_id)
+            { return node_id; },
+            [](const NodeID,
+               const ExternalMemoryNode &node,
+               chunked_records::NodeChunkEncoder &output)
             {
-                ++node_iterator;
-                continue;
-            }
-            BOOST_ASSERT(*node_id_iterator == node_iterator->node_id);
-
-            file_out_stream.write((char *)&(*node_iterator), sizeof(ExternalMemoryNode));
-
-            ++number_of_used_nodes;
-            ++node_id_iterator;
-            ++node_iterator;
-        }
+                output.Append(node);
+                return true;
+            },
+            [&file_out_stream](const chunked_records::NodeChunkEncoder &output)
+            { output.Write(file_out_stream); });
 
         TIMER_STOP(write_nodes);
         std::cout << "ok, after " << TIMER_SEC(write_nodes) << "s" << std::endl;
 
         std::cout << "[extractor] setting number of nodes   ... " << std::flush;
         std::ios::pos_type previous_file_position = file_out_stream.tellp();
-        file_out_stream.seekp(std::ios::beg + sizeof(FingerPrint));
+        file_out_stream.seekp(number_of_nodes_position);
         file_out_stream.write((char *)&number_of_used_nodes, sizeof(unsigned));
         file_out_stream.seekp(previous_file_position);
 
@@ -268,7 +505,7 @@ void ExtractionContainers::PrepareData(const std::string &output_file_name,
         // Sort edges by start.
         std::cout << "[extractor] Sorting edges by start    ... " << std::flush;
         TIMER_START(sort_edges_by_start);
-        stxxl::sort(all_edges_list.begin(), all_edges_list.end(), CmpEdgeByStartID(), stxxl_memory);
+        SortList(all_edges_list, CmpEdgeByStartID());
         TIMER_STOP(sort_edges_by_start);
         std::cout << "ok, after " << TIMER_SEC(sort_edges_by_start) << "s" << std::endl;
 
@@ -277,113 +514,89 @@ void ExtractionContainers::PrepareData(const std::string &output_file_name,
         TIMER_START(set_start_coords);
         file_out_stream.write((char *)&number_of_used_edges, sizeof(unsigned));
         // Traverse list of edges and nodes in parallel and set start coord
-        node_iterator = all_nodes_list.begin();
-        auto edge_iterator = all_edges_list.begin();
-        while (edge_iterator != all_edges_list.end() && node_iterator != all_nodes_list.end())
-        {
-            if (edge_iterator->start < node_iterator->node_id)
-            {
-                ++edge_iterator;
-                continue;
-            }
-            if (edge_iterator->start > node_iterator->node_id)
+        JoinWithNodes<NoOutput>(
+            all_edges_list,
+            all_nodes_list,
+            [](const InternalExtractorEdge &edge)
+            { return edge.start; },
+            [](InternalExtractorEdge &edge, const ExternalMemoryNode &node, NoOutput &)
             {
-                node_iterator++;
-                continue;
-            }
-
-            BOOST_ASSERT(edge_iterator->start == node_iterator->node_id);
-            edge_iterator->source_coordinate.lat = node_iterator->lat;
-            edge_iterator->source_coordinate.lon = node_iterator->lon;
-            ++edge_iterator;
-        }
+                edge.source_coordinate.lat = node.lat;
+                edge.source_coordinate.lon = node.lon;
+                return false;
+            },
+            [](const NoOutput &)
+            {});
         TIMER_STOP(set_start_coords);
         std::cout << "ok, after " << TIMER_SEC(set_start_coords) << "s" << std::endl;
 
         // Sort Edges by target
         std::cout << "[extractor] Sorting edges by target   ... " << std::flush;
         TIMER_START(sort_edges_by_target);
-        stxxl::sort(all_edges_list.begin(), all_edges_list.end(), CmpEdgeByTargetID(), stxxl_memory);
+        SortList(all_edges_list, CmpEdgeByTargetID());
         TIMER_STOP(sort_edges_by_target);
         std::cout << "ok, after " << TIMER_SEC(sort_edges_by_target) << "s" << std::endl;
 
         std::cout << "[extractor] Setting target coords     ... " << std::flush;
         TIMER_START(set_target_coords);
-        // Traverse list of edges and nodes in parallel and set target coord
-        node_iterator = all_nodes_list.begin();
-        edge_iterator = all_edges_list.begin();
-
-        while (edge_iterator != all_edges_list.end() && node_iterator != all_nodes_list.end())
-        {
-            if (edge_iterator->target < node_iterator->node_id)
+        // Traverse list of edges and nodes in parallel, set target coord and write the edges
+        number_of_used_edges = JoinWithNodes<chunked_records::EdgeChunkEncoder>(
+            all_edges_list,
+            all_nodes_list,
+            [](const InternalExtractorEdge &edge)
+            { return edge.target; },
+            [](InternalExtractorEdge &edge,
+               const ExternalMemoryNode &node,
+               chunked_records::EdgeChunkEncoder &output)
             {
-                ++edge_iterator;
-                continue;
-            }
-            if (edge_iterator->target > node_iterator->node_id)
-            {
-                ++node_iterator;
-                continue;
-            }
-            BOOST_ASSERT(edge_iterator->target == node_iterator->node_id);
-            if (edge_iterator->source_coordinate.lat != std::numeric_limits<int>::min() &&
-                edge_iterator->source_coordinate.lon != std::numeric_limits<int>::min())
-            {
-                BOOST_ASSERT(edge_iterator->speed != -1);
-                edge_iterator->target_coordinate.lat = node_iterator->lat;
-                edge_iterator->target_coordinate.lon = node_iterator->lon;
+                if (edge.source_coordinate.lat == std::numeric_limits<int>::min() ||
+                    edge.source_coordinate.lon == std::numeric_limits<int>::min())
+                {
+                    return false;
+                }
+                BOOST_ASSERT(edge.speed != -1);
+                edge.target_coordinate.lat = node.lat;
+                edge.target_coordinate.lon = node.lon;
 
                 const double distance = FixedPointCoordinate::ApproximateEuclideanDistance(
-                    edge_iterator->source_coordinate.lat,
-                    edge_iterator->source_coordinate.lon,
-                    node_iterator->lat,
-                    node_iterator->lon);
-
-                const double weight = (distance * 10.) / (edge_iterator->speed / 3.6);
-                int integer_weight = std::max(
-                    1,
-                    (int)std::floor(
-                        (edge_iterator->is_duration_set ? edge_iterator->speed : weight) + .5));
-                int integer_distance = std::max(1, (int)distance);
-                short zero = 0;
-                short one = 1;
-
-                file_out_stream.write((char *)&edge_iterator->start, sizeof(unsigned));
-                file_out_stream.write((char *)&edge_iterator->target, sizeof(unsigned));
-                file_out_stream.write((char *)&integer_distance, sizeof(int));
-                switch (edge_iterator->direction)
+                    edge.source_coordinate.lat, edge.source_coordinate.lon, node.lat, node.lon);
+
+                const double weight = (distance * 10.) / (edge.speed / 3.6);
+
+                ExtractedEdge extracted_edge;
+                extracted_edge.source = edge.start;
+                extracted_edge.target = edge.target;
+                extracted_edge.length = std::max(1, (int)distance);
+                switch (edge.direction)
                 {
                 case ExtractionWay::notSure:
-                    file_out_stream.write((char *)&zero, sizeof(short));
+                    extracted_edge.direction = 0;
                     break;
                 case ExtractionWay::oneway:
-                    file_out_stream.write((char *)&one, sizeof(short));
+                    extracted_edge.direction = 1;
                     break;
                 case ExtractionWay::bidirectional:
-                    file_out_stream.write((char *)&zero, sizeof(short));
+                    extracted_edge.direction = 0;
                     break;
                 case ExtractionWay::opposite:
-                    file_out_stream.write((char *)&one, sizeof(short));
+                    extracted_edge.direction = 1;
                     break;
                 default:
                     throw OSRMException("edge has broken direction");
                 }
-
-                file_out_stream.write((char *)&integer_weight, sizeof(int));
-                file_out_stream.write((char *)&edge_iterator->name_id, sizeof(unsigned));
-                file_out_stream.write((char *)&edge_iterator->is_roundabout, sizeof(bool));
-                file_out_stream.write((char *)&edge_iterator->is_in_tiny_cc, sizeof(bool));
-                file_out_stream.write((char *)&edge_iterator->is_access_restricted, sizeof(bool));
-
-                // cannot take adress of bit field, so use local
-                const TravelMode  travel_mode = edge_iterator->travel_mode;
-                file_out_stream.write((char *)&travel_mode, sizeof(TravelMode));
-
-                file_out_stream.write((char *)&edge_iterator->is_split, sizeof(bool));
-                ++number_of_used_edges;
-            }
-            ++edge_iterator;
-        }
+                extracted_edge.weight = std::max(
+                    1, (int)std::floor((edge.is_duration_set ? edge.speed : weight) + .5));
+                extracted_edge.name_id = edge.name_id;
+                extracted_edge.is_roundabout = edge.is_roundabout;
+                extracted_edge.is_in_tiny_cc = edge.is_in_tiny_cc;
+                extracted_edge.is_access_restricted = edge.is_access_restricted;
+                extracted_edge.travel_mode = edge.travel_mode;
+                extracted_edge.is_split = edge.is_split;
+                output.Append(extracted_edge);
+                return true;
+            },
+            [&file_out_stream](const chunked_records::EdgeChunkEncoder &output)
+            { output.Write(file_out_stream); });
         TIMER_STOP(set_target_coords);
         std::cout << "ok, after " << TIMER_SEC(set_target_coords) << "s" << std::endl;
 
@@ -35,6 +35,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <stxxl/vector>
 
+#include <memory>
+#include <string>
+#include <vector>
+
+// Collects the parsed data and writes the .osrm and .restrictions files. The lists are kept
+// either in std::vectors that are sorted in parallel, or in stxxl::vectors for inputs that do
+// not fit into main memory. The choice is made once, before parsing starts.
 class ExtractionContainers
 {
 #ifndef _MSC_VER
@@ -43,27 +50,54 @@ class ExtractionContainers
     const static unsigned stxxl_memory = ((sizeof(std::size_t) == 4) ? INT_MAX : UINT_MAX);
 #endif
   public:
-    using  STXXLNodeIDVector = stxxl::vector<NodeID>;
-    using  STXXLNodeVector = stxxl::vector<ExternalMemoryNode>;
-    using  STXXLEdgeVector = stxxl::vector<InternalExtractorEdge>;
-    using  STXXLStringVector = stxxl::vector<std::string>;
-    using  STXXLRestrictionsVector = stxxl::vector<InputRestrictionContainer>;
-    using  STXXLWayIDStartEndVector = stxxl::vector<WayIDStartAndEndEdge>;
-
-    STXXLNodeIDVector used_node_id_list;
-    STXXLNodeVector all_nodes_list;
-    STXXLEdgeVector all_edges_list;
-    STXXLStringVector name_list;
-    STXXLRestrictionsVector restrictions_list;
-    STXXLWayIDStartEndVector way_start_end_id_list;
+    template <typename T> using ExternalVector = stxxl::vector<T>;
+    template <typename T> using InternalVector = std::vector<T>;
+
+    template <template <typename> class VectorT> struct Lists
+    {
+        VectorT<NodeID> used_node_id_list;
+        VectorT<ExternalMemoryNode> all_nodes_list;
+        VectorT<InternalExtractorEdge> all_edges_list;
+        VectorT<std::string> name_list;
+        VectorT<InputRestrictionContainer> restrictions_list;
+        VectorT<WayIDStartAndEndEdge> way_start_end_id_list;
+    };
+
     const FingerPrint fingerprint;
 
-    ExtractionContainers();
+    explicit ExtractionContainers(const bool in_memory);
 
     ~ExtractionContainers();
 
+    bool IsInMemory() const { return nullptr != internal_lists; }
+
+    void AddNode(const ExternalMemoryNode &node);
+    void AddUsedNodeID(const NodeID node_id);
+    void AddEdge(const InternalExtractorEdge &edge);
+    // returns the id of the new name
+    unsigned AddName(const std::string &name);
+    void AddRestriction(const InputRestrictionContainer &restriction);
+    void AddWayStartAndEndEdge(const WayIDStartAndEndEdge &way_start_and_end);
+
+    bool HasEdges() const;
+
     void PrepareData(const std::string &output_file_name,
                      const std::string &restrictions_file_name);
+
+  private:
+    template <template <typename> class VectorT>
+    void PrepareLists(Lists<VectorT> &lists,
+                      const std::string &output_file_name,
+                      const std::string &restrictions_file_name);
+
+    template <typename T, typename CompareT>
+    static void SortList(ExternalVector<T> &list, const CompareT &comparator);
+    template <typename T, typename CompareT>
+    static void SortList(InternalVector<T> &list, const CompareT &comparator);
+
+    // exactly one of them is set
+    std::unique_ptr<Lists<InternalVector>> internal_lists;
+    std::unique_ptr<Lists<ExternalVector>> external_lists;
 };
 
 #endif /* EXTRACTIONCONTAINERS_H_ */
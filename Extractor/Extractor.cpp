@@ -44,11 +44,17 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <tbb/task_scheduler_init.h>
 
+#include <cstdint>
 #include <cstdlib>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <thread>
 #include <unordered_map>
 
@@ -58,6 +64,36 @@ Extractor::Extractor() : requested_num_threads(0), file_has_pbf_format(false)
 
 Extractor::~Extractor() {}
 
+namespace
+{
+// memory that can be allocated without swapping in bytes, 0 if it is unknown
+uint64_t GetAvailableMemorySize()
+{
+    // MemAvailable includes the page cache the kernel is able to drop
+    std::ifstream meminfo_stream("/proc/meminfo");
+    std::string line;
+    while (std::getline(meminfo_stream, line))
+    {
+        std::istringstream line_stream(line);
+        std::string key;
+        uint64_t size_in_kb = 0;
+        if (line_stream >> key >> size_in_kb && "MemAvailable:" == key)
+        {
+            return size_in_kb * 1024;
+        }
+    }
+#if defined(_SC_AVPHYS_PAGES) && defined(_SC_PAGESIZE)
+    const long number_of_pages = sysconf(_SC_AVPHYS_PAGES);
+    const long page_size = sysconf(_SC_PAGESIZE);
+    if (0 < number_of_pages && 0 < page_size)
+    {
+        return static_cast<uint64_t>(number_of_pages) * static_cast<uint64_t>(page_size);
+    }
+#endif
+    return 0;
+}
+}
+
 bool Extractor::ParseArguments(int argc, char *argv[])
 {
     // declare a group of options that will be allowed only on command line
@@ -77,7 +113,10 @@ bool Extractor::ParseArguments(int argc, char *argv[])
         "threads,t",
         boost::program_options::value<unsigned int>(&requested_num_threads)
             ->default_value(tbb::task_scheduler_init::default_num_threads()),
-        "Number of threads to use");
+        "Number of threads to use")(
+        "extraction-mode",
+        boost::program_options::value<std::string>(&extraction_mode)->default_value("auto"),
+        "Keep the extracted data in memory or in stxxl: auto|memory|stxxl");
 
     // hidden options, will be allowed both on command line and in config file, but will not be
     // shown to the user
@@ -190,6 +229,44 @@ void Extractor::GenerateOutputFilesNames()
     }
 }
 
+bool Extractor::ShouldExtractInMemory() const
+{
+    if ("auto" != extraction_mode)
+    {
+        const bool in_memory = "memory" == extraction_mode;
+        SimpleLogger().Write() << "Extracting " << (in_memory ? "in memory" : "with stxxl")
+                               << " as requested";
+        return in_memory;
+    }
+
+    const uint64_t available_memory = GetAvailableMemorySize();
+    if (0 == available_memory)
+    {
+        return false;
+    }
+
+    // Rough number of bytes the extraction lists take per byte of input. Compressed inputs
+    // expand a lot, plain XML is mostly markup.
+    uint64_t expansion_factor = 1;
+    if (file_has_pbf_format)
+    {
+        expansion_factor = 10;
+    }
+    else if (".bz2" == input_path.extension().string())
+    {
+        expansion_factor = 8;
+    }
+    const uint64_t estimated_memory =
+        boost::filesystem::file_size(input_path) * expansion_factor;
+
+    // leave the other half for the sort buffers, the Lua states and the name index
+    const bool in_memory = estimated_memory < available_memory / 2;
+    SimpleLogger().Write() << "Estimated " << (estimated_memory >> 20) << " MB for "
+                           << (available_memory >> 20) << " MB of available RAM, extracting "
+                           << (in_memory ? "in memory" : "with stxxl");
+    return in_memory;
+}
+
 int Extractor::Run(int argc, char *argv[])
 {
     try
@@ -207,6 +284,13 @@ int Extractor::Run(int argc, char *argv[])
             return 1;
         }
 
+        if ("auto" != extraction_mode && "memory" != extraction_mode &&
+            "stxxl" != extraction_mode)
+        {
+            SimpleLogger().Write(logWARNING) << "Extraction mode must be auto, memory or stxxl";
+            return 1;
+        }
+
         if (!boost::filesystem::is_regular_file(input_path))
         {
             SimpleLogger().Write(logWARNING) << "Input file " << input_path.string()
@@ -241,7 +325,7 @@ int Extractor::Run(int argc, char *argv[])
         GenerateOutputFilesNames();
 
         std::unordered_map<std::string, NodeID> string_map;
-        ExtractionContainers extraction_containers;
+        ExtractionContainers extraction_containers(ShouldExtractInMemory());
 
         string_map[""] = 0;
         auto extractor_callbacks = new ExtractorCallbacks(extraction_containers, string_map);
@@ -269,13 +353,15 @@ int Extractor::Run(int argc, char *argv[])
         TIMER_START(parsing);
 
         parser->Parse();
+        const BaseParser::WayCacheStatistics way_cache_statistics =
+            parser->GetWayCacheStatistics();
         delete parser;
         delete extractor_callbacks;
 
         TIMER_STOP(parsing);
         SimpleLogger().Write() << "Parsing finished after " << TIMER_SEC(parsing) << " seconds";
 
-        if (extraction_containers.all_edges_list.empty())
+        if (!extraction_containers.HasEdges())
         {
             SimpleLogger().Write(logWARNING) << "The input data is empty, exiting.";
             return 1;
@@ -285,6 +371,15 @@ int Extractor::Run(int argc, char *argv[])
 
         TIMER_STOP(extracting);
         SimpleLogger().Write() << "extraction finished after " << TIMER_SEC(extracting) << "s";
+        const uint64_t way_cache_lookups =
+            way_cache_statistics.hits + way_cache_statistics.misses;
+        if (0 < way_cache_lookups)
+        {
+            SimpleLogger().Write() << "way profile cache: " << way_cache_statistics.hits
+                                   << " hits, " << way_cache_statistics.misses << " misses ("
+                                   << (100. * way_cache_statistics.hits / way_cache_lookups)
+                                   << "% hit rate)";
+        }
         SimpleLogger().Write() << "To prepare the data for routing, run: "
                                << "./osrm-prepare " << output_file_name << std::endl;
     }
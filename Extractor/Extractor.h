@@ -15,6 +15,7 @@ class Extractor
     boost::filesystem::path config_file_path;
     boost::filesystem::path input_path;
     boost::filesystem::path profile_path;
+    std::string extraction_mode;
 
     std::string output_file_name;
     std::string restriction_file_name;
@@ -25,6 +26,8 @@ class Extractor
 
     /** \brief Parses config file, if present in options */
     void GenerateOutputFilesNames();
+    /** \brief Decides if the extracted data is expected to fit into main memory */
+    bool ShouldExtractInMemory() const;
 
   public:
     explicit Extractor();
@@ -50,16 +50,16 @@ void ExtractorCallbacks::ProcessNode(const ExternalMemoryNode &n)
 {
     if (n.lat <= 85 * COORDINATE_PRECISION && n.lat >= -85 * COORDINATE_PRECISION)
     {
-        external_memory.all_nodes_list.push_back(n);
+        external_memory.AddNode(n);
         if( n.poi ) {
-            external_memory.used_node_id_list.push_back(n.node_id) ; //TODO check this: add poi nodes as used
+            external_memory.AddUsedNodeID(n.node_id) ; //TODO check this: add poi nodes as used
         }
     }
 }
 
 bool ExtractorCallbacks::ProcessRestriction(const InputRestrictionContainer &restriction)
 {
-    external_memory.restrictions_list.push_back(restriction);
+    external_memory.AddRestriction(restriction);
     return true;
 }
 
@@ -105,8 +105,7 @@ void ExtractorCallbacks::ProcessWay(ExtractionWay &parsed_way)
     const auto &string_map_iterator = string_map.find(parsed_way.name);
     if (string_map.end() == string_map_iterator)
     {
-        parsed_way.nameID = external_memory.name_list.size();
-        external_memory.name_list.push_back(parsed_way.name);
+        parsed_way.nameID = external_memory.AddName(parsed_way.name);
         string_map.insert(std::make_pair(parsed_way.name, parsed_way.nameID));
     }
     else
@@ -130,7 +129,7 @@ void ExtractorCallbacks::ProcessWay(ExtractionWay &parsed_way)
     BOOST_ASSERT(parsed_way.forward_travel_mode>0);
     for (unsigned n = 0; n < (parsed_way.path.size() - 1); ++n)
     {
-        external_memory.all_edges_list.push_back(InternalExtractorEdge(
+        external_memory.AddEdge(InternalExtractorEdge(
             parsed_way.path[n],
             parsed_way.path[n + 1],
             ((split_edge || TRAVEL_MODE_INACCESSIBLE == parsed_way.backward_travel_mode) ? ExtractionWay::oneway
@@ -143,12 +142,12 @@ void ExtractorCallbacks::ProcessWay(ExtractionWay &parsed_way)
             parsed_way.isAccessRestricted,
             parsed_way.forward_travel_mode,
             split_edge));
-        external_memory.used_node_id_list.push_back(parsed_way.path[n]);
+        external_memory.AddUsedNodeID(parsed_way.path[n]);
     }
-    external_memory.used_node_id_list.push_back(parsed_way.path.back());
+    external_memory.AddUsedNodeID(parsed_way.path.back());
 
     // The following information is needed to identify start and end segments of restrictions
-    external_memory.way_start_end_id_list.push_back(
+    external_memory.AddWayStartAndEndEdge(
         WayIDStartAndEndEdge(parsed_way.id,
                              parsed_way.path[0],
                              parsed_way.path[1],
@@ -162,7 +161,7 @@ void ExtractorCallbacks::ProcessWay(ExtractionWay &parsed_way)
 
         for (std::vector<NodeID>::size_type n = 0; n < parsed_way.path.size() - 1; ++n)
         {
-            external_memory.all_edges_list.push_back(
+            external_memory.AddEdge(
                 InternalExtractorEdge(parsed_way.path[n],
                                       parsed_way.path[n + 1],
                                       ExtractionWay::oneway,
@@ -175,7 +174,7 @@ void ExtractorCallbacks::ProcessWay(ExtractionWay &parsed_way)
                                       parsed_way.backward_travel_mode,
                                       split_edge));
         }
-        external_memory.way_start_end_id_list.push_back(
+        external_memory.AddWayStartAndEndEdge(
             WayIDStartAndEndEdge(parsed_way.id,
                                  parsed_way.path[0],
                                  parsed_way.path[1],
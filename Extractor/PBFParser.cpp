@@ -42,6 +42,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/assert.hpp>
 
 #include <tbb/parallel_for.h>
+#include <tbb/pipeline.h>
 #include <tbb/task_scheduler_init.h>
 
 #include <osrm/Coordinate.h>
@@ -51,13 +52,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <functional>
 #include <iostream>
 #include <limits>
-#include <thread>
 
 PBFParser::PBFParser(const char *fileName,
                      ExtractorCallbacks *extractor_callbacks,
                      ScriptingEnvironment &scripting_environment,
                      unsigned num_threads)
-    : BaseParser(extractor_callbacks, scripting_environment)
+    : BaseParser(extractor_callbacks, scripting_environment), decoding_failed(false)
 {
     if (0 == num_threads)
     {
@@ -69,11 +69,6 @@ PBFParser::PBFParser(const char *fileName,
     }
 
     GOOGLE_PROTOBUF_VERIFY_VERSION;
-    // TODO: What is the bottleneck here? Filling the queue or reading the stuff from disk?
-    // NOTE: With Lua scripting, it is parsing the stuff. I/O is virtually for free.
-
-    // Max 2500 items in queue, hardcoded.
-    thread_data_queue = std::make_shared<ConcurrentQueue<ParserThreadData *>>(2500);
     input.open(fileName, std::ios::in | std::ios::binary);
 
     if (!input)
@@ -91,13 +86,6 @@ PBFParser::~PBFParser()
     {
         input.close();
     }
-
-    // Clean up any leftover ThreadData objects in the queue
-    ParserThreadData *thread_data;
-    while (thread_data_queue->try_pop(thread_data))
-    {
-        delete thread_data;
-    }
     google::protobuf::ShutdownProtobufLibrary();
 
     SimpleLogger().Write(logDEBUG) << "parsed " << block_count << " blocks from pbf with "
@@ -113,7 +101,7 @@ inline bool PBFParser::ReadHeader()
         return false;
     }
 
-    if (readBlob(input, &init_data))
+    if (readBlob(input, &init_data) && unpackBlob(&init_data))
     {
         if (!init_data.PBFHeaderBlock.ParseFromArray(&(init_data.charBuffer[0]),
                                                      static_cast<int>(init_data.charBuffer.size())))
@@ -151,84 +139,97 @@ inline bool PBFParser::ReadHeader()
     return true;
 }
 
-inline void PBFParser::ReadData()
+inline PBFParser::ParserThreadData *PBFParser::ReadData(bool &end_of_data)
 {
-    bool keep_running = true;
-    do
+    ParserThreadData *thread_data = new ParserThreadData();
+    if (decoding_failed || !readNextBlock(input, thread_data))
     {
-        ParserThreadData *thread_data = new ParserThreadData();
-        keep_running = readNextBlock(input, thread_data);
+        delete thread_data;
+        end_of_data = true;
+        return nullptr;
+    }
+    return thread_data;
+}
 
-        if (keep_running)
-        {
-            thread_data_queue->push(thread_data);
-        }
-        else
-        {
-            // No more data to read, parse stops when nullptr encountered
-            thread_data_queue->push(nullptr);
-            delete thread_data;
-        }
-    } while (keep_running);
+inline PBFParser::ParserThreadData *PBFParser::DecodeData(ParserThreadData *thread_data)
+{
+    thread_data->decoded = decodeBlock(thread_data);
+    // the raw blob is not needed anymore, release it before the block waits for its turn
+    std::vector<char>().swap(thread_data->blobBuffer);
+    std::vector<char>().swap(thread_data->charBuffer);
+    return thread_data;
 }
 
-inline void PBFParser::ParseData()
+inline void PBFParser::ParseData(ParserThreadData *thread_data)
 {
-    tbb::task_scheduler_init init(num_parser_threads);
+    // blocks behind a broken one are dropped, just like the serial reader stopped there
+    if (!thread_data->decoded || decoding_failed)
+    {
+        decoding_failed = true;
+        delete thread_data;
+        return;
+    }
+
+    loadBlock(thread_data);
 
-    while (true)
+    int group_size = thread_data->PBFprimitiveBlock.primitivegroup_size();
+    for (int i = 0; i < group_size; ++i)
     {
-        ParserThreadData *thread_data;
-        thread_data_queue->wait_and_pop(thread_data);
-        if (nullptr == thread_data)
+        thread_data->currentGroupID = i;
+        loadGroup(thread_data);
+
+        if (thread_data->entityTypeIndicator == TypeNode)
         {
-            thread_data_queue->push(nullptr); // Signal end of data for other threads
-            break;
+            parseNode(thread_data);
         }
-
-        loadBlock(thread_data);
-
-        int group_size = thread_data->PBFprimitiveBlock.primitivegroup_size();
-        for (int i = 0; i < group_size; ++i)
+        if (thread_data->entityTypeIndicator == TypeWay)
         {
-            thread_data->currentGroupID = i;
-            loadGroup(thread_data);
-
-            if (thread_data->entityTypeIndicator == TypeNode)
-            {
-                parseNode(thread_data);
-            }
-            if (thread_data->entityTypeIndicator == TypeWay)
-            {
-                parseWay(thread_data);
-            }
-            if (thread_data->entityTypeIndicator == TypeRelation)
-            {
-                parseRelation(thread_data);
-            }
-            if (thread_data->entityTypeIndicator == TypeDenseNode)
-            {
-                parseDenseNode(thread_data);
-            }
+            parseWay(thread_data);
+        }
+        if (thread_data->entityTypeIndicator == TypeRelation)
+        {
+            parseRelation(thread_data);
+        }
+        if (thread_data->entityTypeIndicator == TypeDenseNode)
+        {
+            parseDenseNode(thread_data);
         }
-
-        delete thread_data;
-        thread_data = nullptr;
     }
+
+    delete thread_data;
 }
 
 inline bool PBFParser::Parse()
 {
-    // Start the read and parse threads
-    std::thread read_thread(std::bind(&PBFParser::ReadData, this));
-
-    // Open several parse threads that are synchronized before call to
-    std::thread parse_thread(std::bind(&PBFParser::ParseData, this));
+    tbb::task_scheduler_init init(num_parser_threads);
 
-    // Wait for the threads to finish
-    read_thread.join();
-    parse_thread.join();
+    // Reading is serial, inflating and decoding blocks runs in parallel. The callbacks see the
+    // blocks in file order again, so entity order is the same as with a single thread.
+    tbb::parallel_pipeline(
+        num_parser_threads * BLOCKS_PER_THREAD,
+        tbb::make_filter<void, ParserThreadData *>(tbb::filter::serial_in_order,
+                                                   [this](tbb::flow_control &flow_control)
+                                                   {
+            bool end_of_data = false;
+            ParserThreadData *thread_data = ReadData(end_of_data);
+            if (end_of_data)
+            {
+                flow_control.stop();
+            }
+            return thread_data;
+        }) &
+            tbb::make_filter<ParserThreadData *, ParserThreadData *>(
+                tbb::filter::parallel,
+                [this](ParserThreadData *thread_data)
+                { return DecodeData(thread_data); }) &
+            tbb::make_filter<ParserThreadData *, void>(tbb::filter::serial_in_order,
+                                                       [this](ParserThreadData *thread_data)
+                                                       { ParseData(thread_data); }));
 
+    if (decoding_failed)
+    {
+        SimpleLogger().Write(logWARNING) << "stopped at a pbf block that could not be decoded";
+    }
     return true;
 }
 
@@ -531,11 +532,13 @@ inline bool PBFParser::readPBFBlobHeader(std::fstream &stream, ParserThreadData
 inline bool PBFParser::unpackZLIB(ParserThreadData *thread_data)
 {
     auto raw_size = thread_data->PBFBlob.raw_size();
-    char *unpacked_data_array = new char[raw_size];
+    // inflate straight into the buffer the block is parsed from
+    thread_data->charBuffer.clear();
+    thread_data->charBuffer.resize(raw_size);
     z_stream compressed_data_stream;
     compressed_data_stream.next_in = (unsigned char *)thread_data->PBFBlob.zlib_data().data();
     compressed_data_stream.avail_in = thread_data->PBFBlob.zlib_data().size();
-    compressed_data_stream.next_out = (unsigned char *)unpacked_data_array;
+    compressed_data_stream.next_out = (unsigned char *)thread_data->charBuffer.data();
     compressed_data_stream.avail_out = raw_size;
     compressed_data_stream.zalloc = Z_NULL;
     compressed_data_stream.zfree = Z_NULL;
@@ -544,7 +547,6 @@ inline bool PBFParser::unpackZLIB(ParserThreadData *thread_data)
     if (return_code != Z_OK)
     {
         std::cerr << "[error] failed to init zlib stream" << std::endl;
-        delete[] unpacked_data_array;
         return false;
     }
 
@@ -553,7 +555,7 @@ inline bool PBFParser::unpackZLIB(ParserThreadData *thread_data)
     {
         std::cerr << "[error] failed to inflate zlib stream" << std::endl;
         std::cerr << "[error] Error type: " << return_code << std::endl;
-        delete[] unpacked_data_array;
+        inflateEnd(&compressed_data_stream);
         return false;
     }
 
@@ -561,40 +563,19 @@ inline bool PBFParser::unpackZLIB(ParserThreadData *thread_data)
     if (return_code != Z_OK)
     {
         std::cerr << "[error] failed to deinit zlib stream" << std::endl;
-        delete[] unpacked_data_array;
         return false;
     }
-
-    thread_data->charBuffer.clear();
-    thread_data->charBuffer.resize(raw_size);
-    std::copy(unpacked_data_array, unpacked_data_array + raw_size, thread_data->charBuffer.begin());
-    delete[] unpacked_data_array;
     return true;
 }
 
 inline bool PBFParser::unpackLZMA(ParserThreadData *) { return false; }
 
-inline bool PBFParser::readBlob(std::fstream &stream, ParserThreadData *thread_data)
+inline bool PBFParser::unpackBlob(ParserThreadData *thread_data)
 {
-    if (stream.eof())
-    {
-        return false;
-    }
-
-    const int size = thread_data->PBFBlobHeader.datasize();
-    if (size < 0 || size > MAX_BLOB_SIZE)
-    {
-        std::cerr << "[error] invalid Blob size:" << size << std::endl;
-        return false;
-    }
-
-    char *data = new char[size];
-    stream.read(data, sizeof(data[0]) * size);
-
-    if (!thread_data->PBFBlob.ParseFromArray(data, size))
+    if (!thread_data->PBFBlob.ParseFromArray(thread_data->blobBuffer.data(),
+                                             static_cast<int>(thread_data->blobBuffer.size())))
     {
         std::cerr << "[error] failed to parse blob" << std::endl;
-        delete[] data;
         return false;
     }
 
@@ -610,7 +591,6 @@ inline bool PBFParser::readBlob(std::fstream &stream, ParserThreadData *thread_d
         if (!unpackZLIB(thread_data))
         {
             std::cerr << "[error] zlib data encountered that could not be unpacked" << std::endl;
-            delete[] data;
             return false;
         }
     }
@@ -620,19 +600,36 @@ inline bool PBFParser::readBlob(std::fstream &stream, ParserThreadData *thread_d
         {
             std::cerr << "[error] lzma data encountered that could not be unpacked" << std::endl;
         }
-        delete[] data;
         return false;
     }
     else
     {
         std::cerr << "[error] Blob contains no data" << std::endl;
-        delete[] data;
         return false;
     }
-    delete[] data;
     return true;
 }
 
+inline bool PBFParser::readBlob(std::fstream &stream, ParserThreadData *thread_data)
+{
+    if (stream.eof())
+    {
+        return false;
+    }
+
+    const int size = thread_data->PBFBlobHeader.datasize();
+    if (size < 0 || size > MAX_BLOB_SIZE)
+    {
+        std::cerr << "[error] invalid Blob size:" << size << std::endl;
+        return false;
+    }
+
+    thread_data->blobBuffer.resize(size);
+    stream.read(thread_data->blobBuffer.data(), sizeof(char) * size);
+    return static_cast<bool>(stream);
+}
+
+// only does I/O, the blob is unpacked and parsed later by decodeBlock
 bool PBFParser::readNextBlock(std::fstream &stream, ParserThreadData *thread_data)
 {
     if (stream.eof())
@@ -650,7 +647,12 @@ bool PBFParser::readNextBlock(std::fstream &stream, ParserThreadData *thread_dat
         return false;
     }
 
-    if (!readBlob(stream, thread_data))
+    return readBlob(stream, thread_data);
+}
+
+bool PBFParser::decodeBlock(ParserThreadData *thread_data)
+{
+    if (!unpackBlob(thread_data))
     {
         return false;
     }
@@ -29,13 +29,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define PBFPARSER_H_
 
 #include "BaseParser.h"
-#include "../DataStructures/ConcurrentQueue.h"
 
 #include <osmpbf/fileformat.pb.h>
 #include <osmpbf/osmformat.pb.h>
 
+#include <atomic>
 #include <fstream>
-#include <memory>
+#include <vector>
 
 class PBFParser : public BaseParser
 {
@@ -49,6 +49,11 @@ class PBFParser : public BaseParser
 
     struct ParserThreadData
     {
+        ParserThreadData()
+            : currentGroupID(0), currentEntityID(0), entityTypeIndicator(TypeDummy), decoded(false)
+        {
+        }
+
         int currentGroupID;
         int currentEntityID;
         EntityType entityTypeIndicator;
@@ -59,7 +64,10 @@ class PBFParser : public BaseParser
         OSMPBF::HeaderBlock PBFHeaderBlock;
         OSMPBF::PrimitiveBlock PBFprimitiveBlock;
 
+        // the blob as read from disk and its unpacked content
+        std::vector<char> blobBuffer;
         std::vector<char> charBuffer;
+        bool decoded;
     };
 
   public:
@@ -73,8 +81,9 @@ class PBFParser : public BaseParser
     inline bool Parse();
 
   private:
-    inline void ReadData();
-    inline void ParseData();
+    inline ParserThreadData *ReadData(bool &end_of_data);
+    inline ParserThreadData *DecodeData(ParserThreadData *thread_data);
+    inline void ParseData(ParserThreadData *thread_data);
     inline void parseDenseNode(ParserThreadData *thread_data);
     inline void parseNode(ParserThreadData *thread_data);
     inline void parseRelation(ParserThreadData *thread_data);
@@ -85,18 +94,23 @@ class PBFParser : public BaseParser
     inline bool readPBFBlobHeader(std::fstream &stream, ParserThreadData *thread_data);
     inline bool unpackZLIB(ParserThreadData *thread_data);
     inline bool unpackLZMA(ParserThreadData *thread_data);
+    inline bool unpackBlob(ParserThreadData *thread_data);
     inline bool readBlob(std::fstream &stream, ParserThreadData *thread_data);
     inline bool readNextBlock(std::fstream &stream, ParserThreadData *thread_data);
+    inline bool decodeBlock(ParserThreadData *thread_data);
 
     static const int NANO = 1000 * 1000 * 1000;
     static const int MAX_BLOB_HEADER_SIZE = 64 * 1024;
     static const int MAX_BLOB_SIZE = 32 * 1024 * 1024;
+    // blocks in flight per parser thread, bounds the memory held by the pipeline
+    static const unsigned BLOCKS_PER_THREAD = 4;
 
     unsigned group_count;
     unsigned block_count;
 
     std::fstream input; // the input stream to parse
-    std::shared_ptr<ConcurrentQueue<ParserThreadData *>> thread_data_queue;
+    // set once a block could not be decoded, parsing stops there
+    std::atomic<bool> decoding_failed;
     unsigned num_parser_threads;
 };
 
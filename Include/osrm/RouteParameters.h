@@ -71,7 +71,15 @@ struct RouteParameters
 
     void addCoordinate(const boost::fusion::vector<double, double> &coordinates);
 
+    void addSource(const boost::fusion::vector<double, double> &coordinates);
+
+    void addDestination(const boost::fusion::vector<double, double> &coordinates);
+
     void setDistanceLimit( unsigned distance_limit );
+
+    void setRadius(const unsigned radius);
+
+    void setPoiFlag(const bool flag);
     
     short zoom_level;
     bool print_instructions;
@@ -89,7 +97,11 @@ struct RouteParameters
     std::vector<std::string> hints;
     std::vector<bool> uturns;
     std::vector<FixedPointCoordinate> coordinates;
+    std::vector<bool> is_source;
+    std::vector<bool> is_destination;
     unsigned distance_limit ;
+    unsigned radius;
+    bool pois;
 };
 
 #endif // ROUTE_PARAMETERS_H
@@ -39,6 +39,7 @@ namespace boost { namespace interprocess { class named_mutex; } }
 #include "../Plugins/HelloWorldPlugin.h"
 #include "../Plugins/LocatePlugin.h"
 #include "../Plugins/NearestPlugin.h"
+#include "../Plugins/RangePlugin.h"
 #include "../Plugins/TimestampPlugin.h"
 #include "../Plugins/ViaRoutePlugin.h"
 #include "../Plugins/PoiDistancesPlugin.h"
@@ -51,103 +52,236 @@ namespace boost { namespace interprocess { class named_mutex; } }
 #include "../Util/simple_logger.hpp"
 
 #include <boost/assert.hpp>
-#include <boost/interprocess/sync/named_condition.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <utility>
 #include <vector>
 
-OSRM_impl::OSRM_impl(ServerPaths server_paths, const bool use_shared_memory)
+namespace
+{
+// counts a query for as long as it runs
+class QueryCountGuard
+{
+  public:
+    QueryCountGuard(ShardedQueryCounter &query_counter, const unsigned shard)
+        : query_counter(query_counter), shard(shard)
+    {
+    }
+    QueryCountGuard(const QueryCountGuard &) = delete;
+    ~QueryCountGuard() { query_counter.Decrement(shard); }
+
+  private:
+    ShardedQueryCounter &query_counter;
+    const unsigned shard;
+};
+}
+
+// a data facade together with the plugins that answer queries on it
+struct OSRM_impl::DataGeneration
+{
+    DataGeneration(BaseDataFacade<QueryEdge::EdgeData> *query_data_facade,
+                   const int max_locations_distance_table,
+                   const int max_results_range_query,
+                   const SharedDataType data_region = DATA_NONE)
+        : query_data_facade(query_data_facade), data_region(data_region)
+    {
+        // The following plugins handle all requests.
+        RegisterPlugin(new DistanceTablePlugin<BaseDataFacade<QueryEdge::EdgeData>>(
+            query_data_facade, max_locations_distance_table));
+        RegisterPlugin(new HelloWorldPlugin());
+        RegisterPlugin(new LocatePlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
+        RegisterPlugin(new NearestPlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
+        RegisterPlugin(new RangePlugin<BaseDataFacade<QueryEdge::EdgeData>>(
+            query_data_facade, max_results_range_query));
+        RegisterPlugin(
+            new TimestampPlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
+        RegisterPlugin(new ViaRoutePlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
+        if (query_data_facade->HasPoiBuckets())
+        {
+            RegisterPlugin(
+                new PoiDistancesPlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
+        }
+        else
+        {
+            SimpleLogger().Write(logWARNING) << "no poi buckets loaded, poitable service disabled";
+        }
+    }
+
+    DataGeneration(const DataGeneration &) = delete;
+
+    ~DataGeneration()
+    {
+        for (PluginMap::value_type &plugin_pointer : plugin_map)
+        {
+            delete plugin_pointer.second;
+        }
+    }
+
+    void RegisterPlugin(BasePlugin *plugin)
+    {
+        SimpleLogger().Write() << "loaded plugin: " << plugin->GetDescriptor();
+        if (plugin_map.find(plugin->GetDescriptor()) != plugin_map.end())
+        {
+            delete plugin_map.find(plugin->GetDescriptor())->second;
+        }
+        plugin_map.emplace(plugin->GetDescriptor(), plugin);
+    }
+
+    std::unique_ptr<BaseDataFacade<QueryEdge::EdgeData>> query_data_facade;
+    // region in shared memory the facade reads from, DATA_NONE for internal memory
+    const SharedDataType data_region;
+    PluginMap plugin_map;
+};
+
+OSRM_impl::OSRM_impl(ServerPaths server_paths,
+                     const bool use_shared_memory,
+                     const int max_locations_distance_table,
+                     const int max_results_range_query)
+    : max_locations_distance_table(max_locations_distance_table),
+      max_results_range_query(max_results_range_query),
+      shared_query_counters(nullptr), current_epoch(0), active_queries(),
+      reload_in_progress(false), failed_reload_timestamp(0)
 {
     if (use_shared_memory)
     {
         barrier = osrm::make_unique<SharedBarriers>();
-        query_data_facade = new SharedDataFacade<QueryEdge::EdgeData>();
+        query_counters_memory.reset(SharedMemoryFactory::Get(
+            QUERY_COUNTERS, sizeof(SharedQueryCounters), true, false));
+        shared_query_counters = static_cast<SharedQueryCounters *>(query_counters_memory->Ptr());
+        generations[0] = LoadSharedDataGeneration();
+        failed_reload_timestamp =
+            static_cast<SharedDataFacade<QueryEdge::EdgeData> *>(
+                generations[0]->query_data_facade.get())->GetLoadedTimestamp();
     }
     else
     {
         // populate base path
         populate_base_path(server_paths);
-        query_data_facade = new InternalDataFacade<QueryEdge::EdgeData>(server_paths);
+        generations[0] = osrm::make_unique<DataGeneration>(
+            new InternalDataFacade<QueryEdge::EdgeData>(server_paths),
+            max_locations_distance_table,
+            max_results_range_query);
     }
-
-    // The following plugins handle all requests.
-    RegisterPlugin(new DistanceTablePlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
-    RegisterPlugin(new HelloWorldPlugin());
-    RegisterPlugin(new LocatePlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
-    RegisterPlugin(new NearestPlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
-    RegisterPlugin(new TimestampPlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
-    RegisterPlugin(new ViaRoutePlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
-    RegisterPlugin(new PoiDistancesPlugin<BaseDataFacade<QueryEdge::EdgeData>>(query_data_facade));
-
 }
 
 OSRM_impl::~OSRM_impl()
 {
-    delete query_data_facade;
-    for (PluginMap::value_type &plugin_pointer : plugin_map)
+    if (reload_thread.joinable())
     {
-        delete plugin_pointer.second;
+        reload_thread.join();
     }
 }
 
-void OSRM_impl::RegisterPlugin(BasePlugin *plugin)
+std::unique_ptr<OSRM_impl::DataGeneration> OSRM_impl::LoadSharedDataGeneration() const
+{
+    // osrm-datastore swaps the regions while holding the query mutex
+    boost::interprocess::scoped_lock<boost::interprocess::named_mutex> query_lock(
+        barrier->query_mutex);
+    auto *shared_data_facade = new SharedDataFacade<QueryEdge::EdgeData>();
+    return osrm::make_unique<DataGeneration>(shared_data_facade,
+                                             max_locations_distance_table,
+                                             max_results_range_query,
+                                             shared_data_facade->GetDataRegion());
+}
+
+unsigned OSRM_impl::PinDataGeneration(const unsigned shard)
 {
-    SimpleLogger().Write() << "loaded plugin: " << plugin->GetDescriptor();
-    if (plugin_map.find(plugin->GetDescriptor()) != plugin_map.end())
+    while (true)
     {
-        delete plugin_map.find(plugin->GetDescriptor())->second;
+        const unsigned epoch = current_epoch.load();
+        active_queries[epoch % 2].Increment(shard);
+        // the epoch did not move while registering, so no reload can free this generation
+        // before the query count drops again
+        if (epoch == current_epoch.load())
+        {
+            return epoch;
+        }
+        active_queries[epoch % 2].Decrement(shard);
     }
-    plugin_map.emplace(plugin->GetDescriptor(), plugin);
 }
 
-void OSRM_impl::RunQuery(RouteParameters &route_parameters, http::Reply &reply)
+void OSRM_impl::WaitForQueries(const unsigned slot) const
 {
-    const PluginMap::const_iterator &iter = plugin_map.find(route_parameters.service);
+    while (0 != active_queries[slot].Sum())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
 
-    if (plugin_map.end() != iter)
+void OSRM_impl::ReloadSharedDataGeneration(const unsigned published_timestamp)
+{
+    try
     {
-        reply.status = http::Reply::ok;
-        if (barrier)
-        {
-            // lock update pending
-            boost::interprocess::scoped_lock<boost::interprocess::named_mutex> pending_lock(
-                barrier->pending_update_mutex);
+        std::unique_ptr<DataGeneration> new_generation = LoadSharedDataGeneration();
+        const unsigned epoch = current_epoch.load();
+        const unsigned retired_slot = epoch % 2;
+        const unsigned next_slot = (epoch + 1) % 2;
 
-            // lock query
-            boost::interprocess::scoped_lock<boost::interprocess::named_mutex> query_lock(
-                barrier->query_mutex);
+        // the previous reload has emptied the other slot already
+        BOOST_ASSERT(!generations[next_slot]);
+        generations[next_slot] = std::move(new_generation);
+        current_epoch.store(epoch + 1);
 
-            // unlock update pending
-            pending_lock.unlock();
+        // unmap the retired data once its last query finished
+        WaitForQueries(retired_slot);
+        generations[retired_slot].reset();
+        SimpleLogger().Write() << "reloaded data from shared memory";
+    }
+    catch (const std::exception &e)
+    {
+        SimpleLogger().Write(logWARNING) << "could not reload data: " << e.what()
+                                         << ", waiting for newer data";
+        failed_reload_timestamp = published_timestamp;
+    }
+    reload_in_progress = false;
+}
 
-            // increment query count
-            ++(barrier->number_of_queries);
+void OSRM_impl::RunQuery(RouteParameters &route_parameters, http::Reply &reply)
+{
+    const unsigned shard = ShardedQueryCounter::GetShardOfCurrentThread();
+    const unsigned epoch = PinDataGeneration(shard);
+    const QueryCountGuard query_count_guard(active_queries[epoch % 2], shard);
+    DataGeneration &generation = *generations[epoch % 2];
 
-            (static_cast<SharedDataFacade<QueryEdge::EdgeData> *>(query_data_facade))
-                ->CheckAndReloadFacade();
-        }
+    // lets osrm-datastore see queries on a data region it is about to replace
+    std::unique_ptr<QueryCountGuard> region_query_count_guard;
+    if (barrier)
+    {
+        ShardedQueryCounter &region_query_counter =
+            shared_query_counters->GetCounter(generation.data_region);
+        region_query_counter.Increment(shard);
+        region_query_count_guard = osrm::make_unique<QueryCountGuard>(region_query_counter, shard);
+    }
 
-        iter->second->HandleRequest(route_parameters, reply);
-        if (barrier)
+    // newer data is loaded in the background, this query still runs on the pinned generation
+    if (barrier)
+    {
+        const auto *shared_data_facade = static_cast<SharedDataFacade<QueryEdge::EdgeData> *>(
+            generation.query_data_facade.get());
+        const unsigned published_timestamp = shared_data_facade->GetPublishedTimestamp();
+        const bool is_outdated = published_timestamp != shared_data_facade->GetLoadedTimestamp();
+        if (is_outdated && published_timestamp != failed_reload_timestamp &&
+            !reload_in_progress.exchange(true))
         {
-            // lock query
-            boost::interprocess::scoped_lock<boost::interprocess::named_mutex> query_lock(
-                barrier->query_mutex);
-
-            // decrement query count
-            --(barrier->number_of_queries);
-            BOOST_ASSERT_MSG(0 <= barrier->number_of_queries, "invalid number of queries");
-
-            // notify all processes that were waiting for this condition
-            if (0 == barrier->number_of_queries)
+            if (reload_thread.joinable())
             {
-                barrier->no_running_queries_condition.notify_all();
+                reload_thread.join();
             }
+            reload_thread =
+                std::thread(&OSRM_impl::ReloadSharedDataGeneration, this, published_timestamp);
         }
     }
+
+    const PluginMap::const_iterator &iter = generation.plugin_map.find(route_parameters.service);
+
+    if (generation.plugin_map.end() != iter)
+    {
+        reply.status = http::Reply::ok;
+        iter->second->HandleRequest(route_parameters, reply);
+    }
     else
     {
         reply = http::Reply::StockReply(http::Reply::badRequest);
@@ -156,8 +290,12 @@ void OSRM_impl::RunQuery(RouteParameters &route_parameters, http::Reply &reply)
 
 // proxy code for compilation firewall
 
-OSRM::OSRM(ServerPaths paths, const bool use_shared_memory)
-    : OSRM_pimpl_(osrm::make_unique<OSRM_impl>(paths, use_shared_memory))
+OSRM::OSRM(ServerPaths paths,
+           const bool use_shared_memory,
+           const int max_locations_distance_table,
+           const int max_results_range_query)
+    : OSRM_pimpl_(osrm::make_unique<OSRM_impl>(
+          paths, use_shared_memory, max_locations_distance_table, max_results_range_query))
 {
 }
 
@@ -35,11 +35,16 @@ struct RouteParameters;
 #include <osrm/ServerPaths.h>
 
 #include "../DataStructures/QueryEdge.h"
+#include "../Server/DataStructures/SharedQueryCounters.h"
 
+#include <array>
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 #include <string>
+#include <thread>
 
+class SharedMemory;
 struct SharedBarriers;
 template <class EdgeDataT> class BaseDataFacade;
 
@@ -47,20 +52,40 @@ class OSRM_impl
 {
   private:
     using PluginMap = std::unordered_map<std::string, BasePlugin *>;
+    struct DataGeneration;
 
   public:
-    OSRM_impl(ServerPaths paths, const bool use_shared_memory);
+    OSRM_impl(ServerPaths paths,
+              const bool use_shared_memory,
+              const int max_locations_distance_table,
+              const int max_results_range_query);
     OSRM_impl(const OSRM_impl &) = delete;
     virtual ~OSRM_impl();
     void RunQuery(RouteParameters &route_parameters, http::Reply &reply);
 
   private:
-    void RegisterPlugin(BasePlugin *plugin);
-    PluginMap plugin_map;
+    std::unique_ptr<DataGeneration> LoadSharedDataGeneration() const;
+    unsigned PinDataGeneration(const unsigned shard);
+    void WaitForQueries(const unsigned slot) const;
+    void ReloadSharedDataGeneration(const unsigned published_timestamp);
+
+    const int max_locations_distance_table;
+    const int max_results_range_query;
     // will only be initialized if shared memory is used
     std::unique_ptr<SharedBarriers> barrier;
-    // base class pointer to the objects
-    BaseDataFacade<QueryEdge::EdgeData> *query_data_facade;
+    std::unique_ptr<SharedMemory> query_counters_memory;
+    SharedQueryCounters *shared_query_counters;
+
+    // Queries pin the generation of current_epoch by counting themselves in its slot. A reload
+    // publishes the new generation in the other slot, bumps the epoch and frees the retired
+    // generation once its last query has left.
+    std::atomic<unsigned> current_epoch;
+    std::array<ShardedQueryCounter, 2> active_queries;
+    std::array<std::unique_ptr<DataGeneration>, 2> generations;
+    std::atomic<bool> reload_in_progress;
+    // a failed reload is only retried once osrm-datastore publishes another timestamp
+    std::atomic<unsigned> failed_reload_timestamp;
+    std::thread reload_thread;
 };
 
 #endif // OSRM_IMPL_H
@@ -39,6 +39,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../Util/StringUtil.h"
 #include "../Util/TimingUtil.h"
 
+#include <cstdint>
 #include <cstdlib>
 
 #include <algorithm>
@@ -53,7 +54,9 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
     std::unique_ptr<SearchEngine<DataFacadeT>> search_engine_ptr;
 
   public:
-    explicit DistanceTablePlugin(DataFacadeT *facade) : descriptor_string("table"), facade(facade)
+    DistanceTablePlugin(DataFacadeT *facade, const int max_locations_distance_table)
+        : max_locations_distance_table(max_locations_distance_table), descriptor_string("table"),
+          facade(facade)
     {
         search_engine_ptr = osrm::make_unique<SearchEngine<DataFacadeT>>(facade);
     }
@@ -90,11 +93,47 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
             raw_route.raw_via_node_coordinates.emplace_back(std::move(coordinate));
         }
 
+        // locations given via loc= are both sources and destinations, as are locations that
+        // library callers added to the coordinates without setting the flags
+        const auto is_source = [&route_parameters](const unsigned i)
+        {
+            return i >= route_parameters.is_source.size() || route_parameters.is_source[i];
+        };
+        const auto is_destination = [&route_parameters](const unsigned i)
+        {
+            return i >= route_parameters.is_destination.size() ||
+                   route_parameters.is_destination[i];
+        };
+        const unsigned number_of_locations =
+            static_cast<unsigned>(raw_route.raw_via_node_coordinates.size());
+        unsigned number_of_sources = 0;
+        unsigned number_of_destinations = 0;
+        for (unsigned i = 0; i < number_of_locations; ++i)
+        {
+            number_of_sources += is_source(i) ? 1 : 0;
+            number_of_destinations += is_destination(i) ? 1 : 0;
+        }
+        if (0 == number_of_sources || 0 == number_of_destinations)
+        {
+            reply = http::Reply::StockReply(http::Reply::badRequest);
+            return;
+        }
+
+        // the limit bounds the size of the table, not the number of locations
+        const uint64_t max_locations = static_cast<uint64_t>(max_locations_distance_table);
+        if (static_cast<uint64_t>(number_of_sources) * number_of_destinations >
+            max_locations * max_locations)
+        {
+            reply = http::Reply::StockReply(http::Reply::badRequest);
+            return;
+        }
+
         const bool checksum_OK = (route_parameters.check_sum == raw_route.check_sum);
-        unsigned max_locations =
-            std::min(100u, static_cast<unsigned>(raw_route.raw_via_node_coordinates.size()));
-        PhantomNodeArray phantom_node_vector(max_locations);
-        for (unsigned i = 0; i < max_locations; ++i)
+        // decode the hints first and snap all remaining coordinates in one batch
+        PhantomNodeArray phantom_node_vectors(number_of_locations);
+        std::vector<unsigned> unhinted_indices;
+        std::vector<FixedPointCoordinate> unhinted_coordinates;
+        for (unsigned i = 0; i < number_of_locations; ++i)
         {
             if (checksum_OK && i < route_parameters.hints.size() &&
                 !route_parameters.hints[i].empty())
@@ -103,21 +142,44 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
                 ObjectEncoder::DecodeFromBase64(route_parameters.hints[i], current_phantom_node);
                 if (current_phantom_node.isValid(facade->GetNumberOfNodes()))
                 {
-                    phantom_node_vector[i].emplace_back(std::move(current_phantom_node));
+                    phantom_node_vectors[i].emplace_back(std::move(current_phantom_node));
                     continue;
                 }
             }
-            facade->IncrementalFindPhantomNodeForCoordinate(raw_route.raw_via_node_coordinates[i],
-                                                            phantom_node_vector[i],
-                                                            route_parameters.zoom_level,
-                                                            1);
+            unhinted_indices.emplace_back(i);
+            unhinted_coordinates.emplace_back(raw_route.raw_via_node_coordinates[i]);
+        }
 
-            BOOST_ASSERT(phantom_node_vector[i].front().isValid(facade->GetNumberOfNodes()));
+        PhantomNodeArray snapped_phantom_node_vectors;
+        facade->IncrementalFindPhantomNodesForCoordinates(
+            unhinted_coordinates, snapped_phantom_node_vectors, route_parameters.zoom_level, 1);
+        for (unsigned i = 0; i < unhinted_indices.size(); ++i)
+        {
+            phantom_node_vectors[unhinted_indices[i]] =
+                std::move(snapped_phantom_node_vectors[i]);
+        }
+
+        PhantomNodeArray source_phantom_node_vector;
+        PhantomNodeArray target_phantom_node_vector;
+        source_phantom_node_vector.reserve(number_of_sources);
+        target_phantom_node_vector.reserve(number_of_destinations);
+        for (unsigned i = 0; i < number_of_locations; ++i)
+        {
+            BOOST_ASSERT(phantom_node_vectors[i].front().isValid(facade->GetNumberOfNodes()));
+            if (is_source(i))
+            {
+                source_phantom_node_vector.emplace_back(phantom_node_vectors[i]);
+            }
+            if (is_destination(i))
+            {
+                target_phantom_node_vector.emplace_back(std::move(phantom_node_vectors[i]));
+            }
         }
 
         // TIMER_START(distance_table);
         std::shared_ptr<std::vector<EdgeWeight>> result_table =
-            search_engine_ptr->distance_table(phantom_node_vector);
+            search_engine_ptr->distance_table(source_phantom_node_vector,
+                                              target_phantom_node_vector);
         // TIMER_STOP(distance_table);
 
         if (!result_table)
@@ -125,14 +187,20 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
             reply = http::Reply::StockReply(http::Reply::badRequest);
             return;
         }
+        if ("binary" == route_parameters.output_format)
+        {
+            RenderBinaryTable(number_of_sources, number_of_destinations, *result_table, reply);
+            return;
+        }
+
         JSON::Object json_object;
         JSON::Array json_array;
-        const unsigned number_of_locations = static_cast<unsigned>(phantom_node_vector.size());
-        for (unsigned row = 0; row < number_of_locations; ++row)
+        for (unsigned row = 0; row < number_of_sources; ++row)
         {
             JSON::Array json_row;
-            auto row_begin_iterator = result_table->begin() + (row * number_of_locations);
-            auto row_end_iterator = result_table->begin() + ((row + 1) * number_of_locations);
+            const std::size_t row_offset = static_cast<std::size_t>(row) * number_of_destinations;
+            auto row_begin_iterator = result_table->begin() + row_offset;
+            auto row_end_iterator = row_begin_iterator + number_of_destinations;
             json_row.values.insert(json_row.values.end(), row_begin_iterator, row_end_iterator);
             json_array.values.push_back(json_row);
         }
@@ -141,6 +209,41 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
     }
 
   private:
+    // output=binary writes this header followed by the row-major table of
+    // number_of_sources * number_of_destinations EdgeWeights, all in host byte order.
+    // Unreachable entries are std::numeric_limits<EdgeWeight>::max().
+    struct BinaryTableHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t check_sum;
+        uint32_t number_of_sources;
+        uint32_t number_of_destinations;
+    };
+
+    void RenderBinaryTable(const unsigned number_of_sources,
+                           const unsigned number_of_destinations,
+                           const std::vector<EdgeWeight> &result_table,
+                           http::Reply &reply) const
+    {
+        BOOST_ASSERT(result_table.size() ==
+                     static_cast<std::size_t>(number_of_sources) * number_of_destinations);
+        const BinaryTableHeader header = {{'O', 'T', 'B', 'L'},
+                                          1,
+                                          facade->GetCheckSum(),
+                                          number_of_sources,
+                                          number_of_destinations};
+        const char *header_begin = reinterpret_cast<const char *>(&header);
+        const char *table_begin = reinterpret_cast<const char *>(result_table.data());
+        reply.content.reserve(reply.content.size() + sizeof(BinaryTableHeader) +
+                              result_table.size() * sizeof(EdgeWeight));
+        reply.content.insert(reply.content.end(), header_begin, header_begin + sizeof(header));
+        reply.content.insert(reply.content.end(),
+                             table_begin,
+                             table_begin + result_table.size() * sizeof(EdgeWeight));
+    }
+
+    int max_locations_distance_table;
     std::string descriptor_string;
     DataFacadeT *facade;
 };
@@ -74,6 +74,8 @@ for (const FixedPointCoordinate &coordinate : route_parameters.coordinates)
 const bool checksum_OK = (route_parameters.check_sum == raw_route.check_sum);
 unsigned max_locations = 1;
 PhantomNodeArray phantom_node_vector(max_locations);
+std::vector<unsigned> unhinted_indices;
+std::vector<FixedPointCoordinate> unhinted_coordinates;
 for (unsigned i = 0; i < max_locations; ++i)
 {
     if (checksum_OK && i < route_parameters.hints.size() &&
@@ -87,47 +89,44 @@ for (unsigned i = 0; i < max_locations; ++i)
             continue;
         }
     }
-    facade->IncrementalFindPhantomNodeForCoordinate(raw_route.raw_via_node_coordinates[i],
-                                                    phantom_node_vector[i],
-                                                    route_parameters.zoom_level,
-                                                    1);
-    
-    BOOST_ASSERT(phantom_node_vector[i].front().isValid(facade->GetNumberOfNodes()));
+    unhinted_indices.emplace_back(i);
+    unhinted_coordinates.emplace_back(raw_route.raw_via_node_coordinates[i]);
+}
+
+PhantomNodeArray snapped_phantom_node_vectors;
+facade->IncrementalFindPhantomNodesForCoordinates(
+    unhinted_coordinates, snapped_phantom_node_vectors, route_parameters.zoom_level, 1);
+for (unsigned i = 0; i < unhinted_indices.size(); ++i)
+{
+    phantom_node_vector[unhinted_indices[i]] = std::move(snapped_phantom_node_vectors[i]);
+    BOOST_ASSERT(
+        phantom_node_vector[unhinted_indices[i]].front().isValid(facade->GetNumberOfNodes()));
 }
 
 SimpleLogger().Write() << "query with distance limit " << route_parameters.distance_limit ;
 
 TIMER_START(poi_distance_table);
-search_engine_ptr->poi_distance_table.initBackwardRouting(raw_route.raw_via_node_coordinates[0])  ;
-//std::shared_ptr<std::unordered_map<NodeID, EdgeWeight>> result_table =
-//search_engine_ptr->poi_distance_table(phantom_node_vector[0].front(), route_parameters.distance_limit);
+const PoiDistanceArena &result_arena =
+    search_engine_ptr->poi_distance_table(phantom_node_vector[0].front(),
+                                          route_parameters.distance_limit);
 TIMER_STOP(poi_distance_table);
 SimpleLogger().Write() << "poi query, after " << TIMER_MSEC(poi_distance_table) << "ms";
 
-/*if (!result_table)
-{
-    reply = http::Reply::StockReply(http::Reply::badRequest);
-    return;
-}*/
-
 FixedPointCoordinate sourceLoc = phantom_node_vector[0].front().location ;
 JSON::Object json_object;
 JSON::Array json_array;
 
-std::vector<PhantomNode> poi_vector ;
-facade->IncrementalFindPhantomPoiNodeForCoordinate( raw_route.raw_via_node_coordinates[0], poi_vector, 14, 100 ) ;
-for ( PhantomNode pnode : poi_vector )
+for (const unsigned poi_id : result_arena.GetTouchedPois())
 {
-    //if( result_table->find( pnode.forward_node_id) != result_table->end() ) {
-        JSON::Object row;
-        row.values["lat"] = pnode.location.lat / COORDINATE_PRECISION ;
-        row.values["lon"] = pnode.location.lon / COORDINATE_PRECISION;
-        row.values["osm_id"] = pnode.info_osm_id ;
-        //row.values["distance_car"] = (*result_table)[pnode.forward_node_id] ;
-        row.values["distance_air"] = FixedPointCoordinate::ApproximateDistance(sourceLoc, pnode.location) ;
-
-        json_array.values.push_back(row);
-    //}
+    const PoiInfo poi = facade->GetPoiInfo(poi_id);
+    JSON::Object row;
+    row.values["lat"] = poi.location.lat / COORDINATE_PRECISION ;
+    row.values["lon"] = poi.location.lon / COORDINATE_PRECISION;
+    row.values["osm_id"] = poi.osm_id ;
+    row.values["distance_car"] = result_arena.GetDistance(poi_id) ;
+    row.values["distance_air"] = FixedPointCoordinate::ApproximateDistance(sourceLoc, poi.location) ;
+
+    json_array.values.push_back(row);
 }
 json_object.values["distance_table"] = json_array;
 JSON::render(reply.content, json_object);
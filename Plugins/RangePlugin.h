@@ -0,0 +1,164 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef RANGE_PLUGIN_H
+#define RANGE_PLUGIN_H
+
+#include "BasePlugin.h"
+#include "../DataStructures/JSONContainer.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/*
+ * This Plugin returns all street segments, or with pois=true all POIs, that lie within radius
+ * meters of one coordinate or inside the bounding box spanned by two coordinates. The results are
+ * rendered into the reply while the index is traversed, no intermediate result list is built.
+ * Queries with more than max_results results are answered with a bad request.
+ */
+
+template <class DataFacadeT> class RangePlugin final : public BasePlugin
+{
+  public:
+    RangePlugin(DataFacadeT *facade, const int max_results)
+        : max_results(static_cast<unsigned>(max_results)), facade(facade),
+          descriptor_string("range")
+    {
+    }
+
+    const std::string GetDescriptor() const final { return descriptor_string; }
+
+    void HandleRequest(const RouteParameters &route_parameters, http::Reply &reply) final
+    {
+        const std::vector<FixedPointCoordinate> &coordinates = route_parameters.coordinates;
+        const bool is_radius_query = (1 == coordinates.size()) && (0 < route_parameters.radius);
+        const bool is_rectangle_query = (2 == coordinates.size());
+        if ((!is_radius_query && !is_rectangle_query) ||
+            !std::all_of(coordinates.begin(),
+                         coordinates.end(),
+                         [](const FixedPointCoordinate &coordinate)
+                         { return coordinate.isValid(); }))
+        {
+            reply = http::Reply::StockReply(http::Reply::badRequest);
+            return;
+        }
+
+        reply.status = http::Reply::ok;
+        AppendToReply("{\"status\":0,\"results\":[", reply);
+        unsigned number_of_results = 0;
+        const auto render_result = [&reply, &number_of_results](const JSON::Object &result)
+        {
+            if (0 != number_of_results)
+            {
+                reply.content.push_back(',');
+            }
+            ++number_of_results;
+            JSON::render(reply.content, result);
+        };
+
+        bool is_complete = true;
+        if (route_parameters.pois)
+        {
+            const auto render_poi = [this, &render_result, &number_of_results](
+                const unsigned poi_id)
+            {
+                if (number_of_results == max_results)
+                {
+                    return false;
+                }
+                const PoiInfo poi = facade->GetPoiInfo(poi_id);
+                JSON::Object result;
+                result.values["lat"] = poi.location.lat / COORDINATE_PRECISION;
+                result.values["lon"] = poi.location.lon / COORDINATE_PRECISION;
+                result.values["osm_id"] = poi.osm_id;
+                render_result(result);
+                return true;
+            };
+            is_complete =
+                is_radius_query
+                    ? facade->ForEachPoiInRadius(coordinates.front(),
+                                                 static_cast<float>(route_parameters.radius),
+                                                 render_poi)
+                    : facade->ForEachPoiInRectangle(
+                          coordinates.front(), coordinates.back(), render_poi);
+        }
+        else
+        {
+            const auto render_segment = [this, &render_result, &number_of_results](
+                const typename DataFacadeT::RTreeLeaf &segment)
+            {
+                if (number_of_results == max_results)
+                {
+                    return false;
+                }
+                JSON::Object result;
+                JSON::Array json_geometry;
+                for (const NodeID node : {segment.u, segment.v})
+                {
+                    const FixedPointCoordinate location = facade->GetCoordinateOfNode(node);
+                    JSON::Array json_coordinate;
+                    json_coordinate.values.push_back(location.lat / COORDINATE_PRECISION);
+                    json_coordinate.values.push_back(location.lon / COORDINATE_PRECISION);
+                    json_geometry.values.push_back(json_coordinate);
+                }
+                result.values["geometry"] = json_geometry;
+                std::string name;
+                facade->GetName(segment.name_id, name);
+                result.values["name"] = name;
+                render_result(result);
+                return true;
+            };
+            is_complete =
+                is_radius_query
+                    ? facade->ForEachSegmentInRadius(coordinates.front(),
+                                                     static_cast<float>(route_parameters.radius),
+                                                     render_segment)
+                    : facade->ForEachSegmentInRectangle(
+                          coordinates.front(), coordinates.back(), render_segment);
+        }
+        if (!is_complete)
+        {
+            reply = http::Reply::StockReply(http::Reply::badRequest);
+            return;
+        }
+        AppendToReply("]}", reply);
+    }
+
+  private:
+    static void AppendToReply(const std::string &text, http::Reply &reply)
+    {
+        reply.content.insert(reply.content.end(), text.begin(), text.end());
+    }
+
+    const unsigned max_results;
+    DataFacadeT *facade;
+    std::string descriptor_string;
+};
+
+#endif // RANGE_PLUGIN_H
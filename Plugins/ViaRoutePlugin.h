@@ -94,6 +94,9 @@ template <class DataFacadeT> class ViaRoutePlugin final : public BasePlugin
         std::vector<PhantomNode> phantom_node_vector(raw_route.raw_via_node_coordinates.size());
         const bool checksum_OK = (route_parameters.check_sum == raw_route.check_sum);
 
+        // decode the hints first and snap all remaining coordinates in one batch
+        std::vector<unsigned> unhinted_indices;
+        std::vector<FixedPointCoordinate> unhinted_coordinates;
         for (unsigned i = 0; i < raw_route.raw_via_node_coordinates.size(); ++i)
         {
             if (checksum_OK && i < route_parameters.hints.size() &&
@@ -105,9 +108,16 @@ template <class DataFacadeT> class ViaRoutePlugin final : public BasePlugin
                     continue;
                 }
             }
-            facade->FindPhantomNodeForCoordinate(raw_route.raw_via_node_coordinates[i],
-                                                 phantom_node_vector[i],
-                                                 route_parameters.zoom_level);
+            unhinted_indices.emplace_back(i);
+            unhinted_coordinates.emplace_back(raw_route.raw_via_node_coordinates[i]);
+        }
+
+        std::vector<PhantomNode> snapped_phantom_nodes;
+        facade->FindPhantomNodesForCoordinates(
+            unhinted_coordinates, snapped_phantom_nodes, route_parameters.zoom_level);
+        for (unsigned i = 0; i < unhinted_indices.size(); ++i)
+        {
+            phantom_node_vector[unhinted_indices[i]] = snapped_phantom_nodes[i];
         }
 
         PhantomNodes current_phantom_node_pair;
@@ -43,6 +43,7 @@ SearchEngineData::SearchEngineHeapPtr SearchEngineData::forwardHeap2;
 SearchEngineData::SearchEngineHeapPtr SearchEngineData::backwardHeap2;
 SearchEngineData::SearchEngineHeapPtr SearchEngineData::forwardHeap3;
 SearchEngineData::SearchEngineHeapPtr SearchEngineData::backwardHeap3;
+SearchEngineData::PoiDistanceArenaPtr SearchEngineData::poiDistanceArena;
 
 template <class DataFacadeT> class BasicRoutingInterface
 {
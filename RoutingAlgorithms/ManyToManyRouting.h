@@ -34,9 +34,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/assert.hpp>
 
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstddef>
 #include <limits>
 #include <memory>
-#include <unordered_map>
 #include <vector>
 
 
@@ -44,20 +47,38 @@ template <class DataFacadeT> class ManyToManyRouting final : public BasicRouting
 {
     struct NodeBucket
     {
+        NodeID node;
         unsigned target_id; // essentially a row in the distance matrix
         EdgeWeight distance;
-        NodeBucket(const unsigned target_id, const EdgeWeight distance)
-        : target_id(target_id), distance(distance)
+        NodeBucket(const NodeID node, const unsigned target_id, const EdgeWeight distance)
+            : node(node), target_id(target_id), distance(distance)
+        {
+        }
+
+        // buckets are ordered by node only, the order of targets within a node does not matter
+        bool operator<(const NodeBucket &other) const { return node < other.node; }
+    };
+
+    // heterogeneous comparison to look up the buckets of a node id
+    struct NodeBucketCompare
+    {
+        bool operator()(const NodeBucket &bucket, const NodeID node) const
         {
+            return bucket.node < node;
+        }
+        bool operator()(const NodeID node, const NodeBucket &bucket) const
+        {
+            return node < bucket.node;
         }
     };
-    
+
     using super = BasicRoutingInterface<DataFacadeT>;
     using QueryHeap = SearchEngineData::QueryHeap;
     SearchEngineData &engine_working_data;
 
-    using SearchSpaceWithBuckets = std::unordered_map<NodeID, std::vector<NodeBucket>>;
-    
+    // all buckets of all backward search spaces in one array, sorted by node
+    using SearchSpaceWithBuckets = std::vector<NodeBucket>;
+
   public:
     ManyToManyRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
         : super(facade), engine_working_data(engine_working_data)
@@ -66,12 +87,18 @@ template <class DataFacadeT> class ManyToManyRouting final : public BasicRouting
 
     virtual ~ManyToManyRouting() {}
 
-    std::shared_ptr<std::vector<EdgeWeight>> operator()(const PhantomNodeArray &phantom_nodes_array)
+    // computes a |sources| x |targets| table, row-major with one row per source
+    std::shared_ptr<std::vector<EdgeWeight>> operator()(const PhantomNodeArray &source_phantoms_array,
+                                                        const PhantomNodeArray &target_phantoms_array)
         const
     {
-        const unsigned number_of_locations = static_cast<unsigned>(phantom_nodes_array.size());
+        const unsigned number_of_sources = static_cast<unsigned>(source_phantoms_array.size());
+        const unsigned number_of_targets = static_cast<unsigned>(target_phantoms_array.size());
+        // the table may exceed 2^32 entries for large --max-table-size values
+        const std::size_t table_size =
+            static_cast<std::size_t>(number_of_sources) * number_of_targets;
         std::shared_ptr<std::vector<EdgeWeight>> result_table =
-            std::make_shared<std::vector<EdgeWeight>>(number_of_locations * number_of_locations,
+            std::make_shared<std::vector<EdgeWeight>>(table_size,
                                                       std::numeric_limits<EdgeWeight>::max());
 
         engine_working_data.InitializeOrClearFirstThreadLocalStorage(
@@ -82,7 +109,7 @@ template <class DataFacadeT> class ManyToManyRouting final : public BasicRouting
         SearchSpaceWithBuckets search_space_with_buckets;
 
         unsigned target_id = 0;
-        for (const std::vector<PhantomNode> &phantom_node_vector : phantom_nodes_array)
+        for (const std::vector<PhantomNode> &phantom_node_vector : target_phantoms_array)
         {
             query_heap.Clear();
             // insert target(s) at distance 0
@@ -111,73 +138,79 @@ template <class DataFacadeT> class ManyToManyRouting final : public BasicRouting
             ++target_id;
         }
 
-        // for each source do forward search
-        unsigned source_id = 0;
-        for (const std::vector<PhantomNode> &phantom_node_vector : phantom_nodes_array)
-        {
-            query_heap.Clear();
-            for (const PhantomNode &phantom_node : phantom_node_vector)
-            {
-                // insert sources at distance 0
-                if (SPECIAL_NODEID != phantom_node.forward_node_id)
-                {
-                    query_heap.Insert(phantom_node.forward_node_id,
-                                      -phantom_node.GetForwardWeightPlusOffset(),
-                                      phantom_node.forward_node_id);
-                }
-                if (SPECIAL_NODEID != phantom_node.reverse_node_id)
-                {
-                    query_heap.Insert(phantom_node.reverse_node_id,
-                                      -phantom_node.GetReverseWeightPlusOffset(),
-                                      phantom_node.reverse_node_id);
-                }
-            }
+        // group the buckets by node for the lookups of the forward searches
+        std::sort(search_space_with_buckets.begin(), search_space_with_buckets.end());
 
-            // explore search space
-            while (!query_heap.Empty())
+        // the forward searches only read the buckets and write disjoint rows of the table,
+        // so the sources are distributed over the TBB workers
+        const unsigned number_of_nodes = super::facade->GetNumberOfNodes();
+        std::vector<EdgeWeight> &distance_table = *result_table;
+        tbb::parallel_for(tbb::blocked_range<unsigned>(0, number_of_sources),
+            [&](const tbb::blocked_range<unsigned> &range)
             {
-                ForwardRoutingStep(source_id,
-                                   number_of_locations,
-                                   query_heap,
-                                   search_space_with_buckets,
-                                   result_table);
-            }
+                for (unsigned source_id = range.begin(); source_id != range.end(); ++source_id)
+                {
+                    QueryHeap &forward_heap =
+                        engine_working_data.InitializeOrClearPooledHeap(number_of_nodes);
+                    for (const PhantomNode &phantom_node : source_phantoms_array[source_id])
+                    {
+                        // insert sources at distance 0
+                        if (SPECIAL_NODEID != phantom_node.forward_node_id)
+                        {
+                            forward_heap.Insert(phantom_node.forward_node_id,
+                                                -phantom_node.GetForwardWeightPlusOffset(),
+                                                phantom_node.forward_node_id);
+                        }
+                        if (SPECIAL_NODEID != phantom_node.reverse_node_id)
+                        {
+                            forward_heap.Insert(phantom_node.reverse_node_id,
+                                                -phantom_node.GetReverseWeightPlusOffset(),
+                                                phantom_node.reverse_node_id);
+                        }
+                    }
 
-            ++source_id;
-        }
-        BOOST_ASSERT(source_id == target_id);
+                    // explore search space
+                    while (!forward_heap.Empty())
+                    {
+                        ForwardRoutingStep(source_id,
+                                           number_of_targets,
+                                           forward_heap,
+                                           search_space_with_buckets,
+                                           distance_table);
+                    }
+                }
+            });
+        BOOST_ASSERT(number_of_targets == target_id);
         return result_table;
     }
 
     void ForwardRoutingStep(const unsigned source_id,
-                            const unsigned number_of_locations,
+                            const unsigned number_of_targets,
                             QueryHeap &query_heap,
                             const SearchSpaceWithBuckets &search_space_with_buckets,
-                            std::shared_ptr<std::vector<EdgeWeight>> result_table) const
+                            std::vector<EdgeWeight> &result_table) const
     {
         const NodeID node = query_heap.DeleteMin();
         const int source_distance = query_heap.GetKey(node);
-
-        // check if each encountered node has an entry
-        const auto bucket_iterator = search_space_with_buckets.find(node);
-        // iterate bucket if there exists one
-        if (bucket_iterator != search_space_with_buckets.end())
+        const std::size_t row_offset = static_cast<std::size_t>(source_id) * number_of_targets;
+
+        // iterate the buckets of the node, the range is empty if there are none
+        const auto bucket_range = std::equal_range(search_space_with_buckets.begin(),
+                                                   search_space_with_buckets.end(),
+                                                   node,
+                                                   NodeBucketCompare());
+        for (auto bucket_iterator = bucket_range.first; bucket_iterator != bucket_range.second;
+             ++bucket_iterator)
         {
-            const std::vector<NodeBucket> &bucket_list = bucket_iterator->second;
-            for (const NodeBucket &current_bucket : bucket_list)
+            // get target id from bucket entry
+            const unsigned target_id = bucket_iterator->target_id;
+            const int target_distance = bucket_iterator->distance;
+            const EdgeWeight current_distance = result_table[row_offset + target_id];
+            // check if new distance is better
+            const EdgeWeight new_distance = source_distance + target_distance;
+            if (new_distance >= 0 && new_distance < current_distance)
             {
-                // get target id from bucket entry
-                const unsigned target_id = current_bucket.target_id;
-                const int target_distance = current_bucket.distance;
-                const EdgeWeight current_distance =
-                    (*result_table)[source_id * number_of_locations + target_id];
-                // check if new distance is better
-                const EdgeWeight new_distance = source_distance + target_distance;
-                if (new_distance >= 0 && new_distance < current_distance)
-                {
-                    (*result_table)[source_id * number_of_locations + target_id] =
-                        (source_distance + target_distance);
-                }
+                result_table[row_offset + target_id] = (source_distance + target_distance);
             }
         }
         if (StallAtNode<true>(node, source_distance, query_heap))
@@ -195,7 +228,7 @@ template <class DataFacadeT> class ManyToManyRouting final : public BasicRouting
         const int target_distance = query_heap.GetKey(node);
 
         // store settled nodes in search space bucket
-        search_space_with_buckets[node].emplace_back(target_id, target_distance);
+        search_space_with_buckets.emplace_back(node, target_id, target_distance);
 
         if (StallAtNode<false>(node, target_distance, query_heap))
         {
@@ -40,7 +40,7 @@ struct APIGrammar : qi::grammar<Iterator>
     explicit APIGrammar(HandlerT * h) : APIGrammar::base_type(api_call), handler(h)
     {
         api_call = qi::lit('/') >> string[boost::bind(&HandlerT::setService, handler, ::_1)] >> *(query) >> -(uturns);
-        query    = ('?') >> (+(zoom | output | jsonp | checksum | location | hint | u | cmp | language | instruction | geometry | alt_route | old_API | num_results | distance_limit) ) ;
+        query    = ('?') >> (+(zoom | output | jsonp | checksum | location | source | destination | hint | u | cmp | language | instruction | geometry | alt_route | old_API | num_results | distance_limit | radius | pois) ) ;
 
         zoom        = (-qi::lit('&')) >> qi::lit('z')            >> '=' >> qi::short_[boost::bind(&HandlerT::setZoomLevel, handler, ::_1)];
         output      = (-qi::lit('&')) >> qi::lit("output")       >> '=' >> string[boost::bind(&HandlerT::setOutputFormat, handler, ::_1)];
@@ -50,6 +50,8 @@ struct APIGrammar : qi::grammar<Iterator>
         geometry    = (-qi::lit('&')) >> qi::lit("geometry")     >> '=' >> qi::bool_[boost::bind(&HandlerT::setGeometryFlag, handler, ::_1)];
         cmp         = (-qi::lit('&')) >> qi::lit("compression")  >> '=' >> qi::bool_[boost::bind(&HandlerT::setCompressionFlag, handler, ::_1)];
         location    = (-qi::lit('&')) >> qi::lit("loc")          >> '=' >> (qi::double_ >> qi::lit(',') >> qi::double_)[boost::bind(&HandlerT::addCoordinate, handler, ::_1)];
+        source      = (-qi::lit('&')) >> qi::lit("src")          >> '=' >> (qi::double_ >> qi::lit(',') >> qi::double_)[boost::bind(&HandlerT::addSource, handler, ::_1)];
+        destination = (-qi::lit('&')) >> qi::lit("dst")          >> '=' >> (qi::double_ >> qi::lit(',') >> qi::double_)[boost::bind(&HandlerT::addDestination, handler, ::_1)];
         hint        = (-qi::lit('&')) >> qi::lit("hint")         >> '=' >> stringwithDot[boost::bind(&HandlerT::addHint, handler, ::_1)];
         u           = (-qi::lit('&')) >> qi::lit("u")            >> '=' >> qi::bool_[boost::bind(&HandlerT::setUTurn, handler, ::_1)];
         uturns      = (-qi::lit('&')) >> qi::lit("uturns")       >> '=' >> qi::bool_[boost::bind(&HandlerT::setAllUTurns, handler, ::_1)];
@@ -58,6 +60,8 @@ struct APIGrammar : qi::grammar<Iterator>
         old_API     = (-qi::lit('&')) >> qi::lit("geomformat")   >> '=' >> string[boost::bind(&HandlerT::setDeprecatedAPIFlag, handler, ::_1)];
         num_results = (-qi::lit('&')) >> qi::lit("num_results")  >> '=' >> qi::short_[boost::bind(&HandlerT::setNumberOfResults, handler, ::_1)];
         distance_limit = (-qi::lit('&')) >> qi::lit("distance_limit")  >> '=' >> qi::uint_[boost::bind(&HandlerT::setDistanceLimit, handler, ::_1)];
+        radius      = (-qi::lit('&')) >> qi::lit("radius")       >> '=' >> qi::uint_[boost::bind(&HandlerT::setRadius, handler, ::_1)];
+        pois        = (-qi::lit('&')) >> qi::lit("pois")         >> '=' >> qi::bool_[boost::bind(&HandlerT::setPoiFlag, handler, ::_1)];
 
         string            = +(qi::char_("a-zA-Z"));
         stringwithDot     = +(qi::char_("a-zA-Z0-9_.-"));
@@ -65,9 +69,11 @@ struct APIGrammar : qi::grammar<Iterator>
     }
 
     qi::rule<Iterator> api_call, query;
-    qi::rule<Iterator, std::string()> service, zoom, output, string, jsonp, checksum, location, hint,
+    qi::rule<Iterator, std::string()> service, zoom, output, string, jsonp, checksum, location, source,
+                                      destination, hint,
                                       stringwithDot, stringwithPercent, language, instruction, geometry,
-                                      cmp, alt_route, u, uturns, old_API, num_results, distance_limit;
+                                      cmp, alt_route, u, uturns, old_API, num_results, distance_limit,
+                                      radius, pois;
 
     HandlerT * handler;
 };
@@ -28,28 +28,76 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Connection.h"
 #include "RequestHandler.h"
 #include "RequestParser.h"
+#include "WorkerPool.h"
+#include "Http/Compressor.h"
 
 #include <boost/assert.hpp>
 #include <boost/bind.hpp>
-#include <boost/iostreams/filtering_stream.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/thread/tss.hpp>
 
+#include <algorithm>
+#include <cstdio>
 #include <string>
 #include <vector>
 
 namespace http
 {
 
-Connection::Connection(boost::asio::io_service &io_service, RequestHandler &handler)
-    : strand(io_service), TCP_socket(io_service), request_handler(handler)
+namespace
+{
+// idle connections are closed after this many seconds without a new request
+const long KEEP_ALIVE_TIMEOUT = 5;
+// compressed replies of at least this size are sent chunked to HTTP/1.1 clients
+const std::size_t CHUNKED_REPLY_SIZE = 1024 * 1024;
+// amount of uncompressed content that goes into a single chunk
+const std::size_t CHUNK_INPUT_SIZE = 256 * 1024;
+// fixed width hex chunk size followed by CRLF, leading zeros are allowed
+const std::size_t CHUNK_HEADER_SIZE = 10;
+const char LAST_CHUNK[] = "0\r\n\r\n";
+
+// zlib streams are expensive to set up, each worker thread keeps its own pair
+struct ThreadCompressors
+{
+    ThreadCompressors() : gzip(gzipRFC1952), deflate(deflateRFC1951) {}
+    Compressor gzip;
+    Compressor deflate;
+};
+boost::thread_specific_ptr<ThreadCompressors> thread_compressors;
+
+Compressor &GetThreadCompressor(const CompressionType compression_type)
+{
+    if (!thread_compressors.get())
+    {
+        thread_compressors.reset(new ThreadCompressors());
+    }
+    Compressor &compressor = (gzipRFC1952 == compression_type) ? thread_compressors->gzip
+                                                                : thread_compressors->deflate;
+    compressor.Reset();
+    return compressor;
+}
+}
+
+Connection::Connection(boost::asio::io_service &io_service,
+                       RequestHandler &handler,
+                       WorkerPool &worker_pool)
+    : strand(io_service), TCP_socket(io_service), idle_timer(io_service),
+      request_handler(handler), worker_pool(worker_pool), unparsed_begin(nullptr),
+      unparsed_end(nullptr),
+      compression_type(noCompression), chunk_write_in_progress(false), last_chunk_queued(false)
 {
 }
 
 boost::asio::ip::tcp::socket &Connection::socket() { return TCP_socket; }
 
 /// Start the first asynchronous operation for the connection.
-void Connection::start()
+void Connection::start() { read_more_input(); }
+
+void Connection::read_more_input()
 {
+    idle_timer.expires_from_now(boost::posix_time::seconds(KEEP_ALIVE_TIMEOUT));
+    idle_timer.async_wait(strand.wrap(boost::bind(&Connection::handle_timeout,
+                                                  this->shared_from_this(),
+                                                  boost::asio::placeholders::error)));
     TCP_socket.async_read_some(
         boost::asio::buffer(incoming_data_buffer),
         strand.wrap(boost::bind(&Connection::handle_read,
@@ -60,115 +108,281 @@ void Connection::start()
 
 void Connection::handle_read(const boost::system::error_code &error, std::size_t bytes_transferred)
 {
+    idle_timer.cancel();
     if (error)
     {
         return;
     }
 
     // no error detected, let's parse the request
-    CompressionType compression_type(noCompression);
+    process_input(incoming_data_buffer.data(), incoming_data_buffer.data() + bytes_transferred);
+}
+
+void Connection::process_input(char *begin, char *end)
+{
     boost::tribool result;
-    boost::tie(result, boost::tuples::ignore) =
-        request_parser.Parse(request,
-                              incoming_data_buffer.data(),
-                              incoming_data_buffer.data() + bytes_transferred,
-                              &compression_type);
+    char *request_end;
+    boost::tie(result, request_end) =
+        request_parser.Parse(request, begin, end, &compression_type);
+    unparsed_begin = request_end;
+    unparsed_end = end;
 
     // the request has been parsed
     if (result)
     {
-        request.endpoint = TCP_socket.remote_endpoint().address();
-        request_handler.handle_request(request, reply);
-
-        // Header compression_header;
-        std::vector<char> compressed_output;
-        std::vector<boost::asio::const_buffer> output_buffer;
+        boost::system::error_code endpoint_error;
+        request.endpoint = TCP_socket.remote_endpoint(endpoint_error).address();
 
-        // compress the result w/ gzip/deflate if requested
-        switch (compression_type)
+        // the asio threads only parse and write, queries are answered by the worker pool
+        if (!worker_pool.TrySubmit(
+                boost::bind(&Connection::handle_request, this->shared_from_this())))
         {
-        case deflateRFC1951:
-            // use deflate for compression
-            reply.headers.insert(reply.headers.begin(), {"Content-Encoding", "deflate"});
-            CompressBufferCollection(reply.content, compression_type, compressed_output);
-            reply.SetSize(static_cast<unsigned>(compressed_output.size()));
-            output_buffer = reply.HeaderstoBuffers();
-            output_buffer.push_back(boost::asio::buffer(compressed_output));
-            break;
-        case gzipRFC1952:
-            // use gzip for compression
-            reply.headers.insert(reply.headers.begin(), {"Content-Encoding", "gzip"});
-            CompressBufferCollection(reply.content, compression_type, compressed_output);
-            reply.SetSize(static_cast<unsigned>(compressed_output.size()));
-            output_buffer = reply.HeaderstoBuffers();
-            output_buffer.push_back(boost::asio::buffer(compressed_output));
-            break;
-        case noCompression:
-            // don't use any compression
-            reply.SetUncompressedSize();
-            output_buffer = reply.ToBuffers();
-            break;
+            reply = Reply::StockReply(Reply::serviceUnavailable);
+            fill_output_buffer();
+            write_reply();
         }
-        // write result to stream
-        boost::asio::async_write(TCP_socket,
-                                 output_buffer,
-                                 strand.wrap(boost::bind(&Connection::handle_write,
-                                                         this->shared_from_this(),
-                                                         boost::asio::placeholders::error)));
     }
     else if (!result)
     { // request is not parseable
         reply = Reply::StockReply(Reply::badRequest);
-
-        boost::asio::async_write(TCP_socket,
-                                 reply.ToBuffers(),
-                                 strand.wrap(boost::bind(&Connection::handle_write,
-                                                         this->shared_from_this(),
-                                                         boost::asio::placeholders::error)));
+        // the rest of the input can not be framed anymore
+        request.keep_alive = false;
+        fill_output_buffer();
+        write_reply();
     }
     else
     {
         // we don't have a result yet, so continue reading
-        TCP_socket.async_read_some(
-            boost::asio::buffer(incoming_data_buffer),
-            strand.wrap(boost::bind(&Connection::handle_read,
-                                    this->shared_from_this(),
-                                    boost::asio::placeholders::error,
-                                    boost::asio::placeholders::bytes_transferred)));
+        read_more_input();
+    }
+}
+
+void Connection::handle_request()
+{
+    request_handler.handle_request(request, reply);
+    if (noCompression != compression_type && request.accepts_chunked_encoding &&
+        CHUNKED_REPLY_SIZE <= reply.content.size())
+    {
+        write_chunked_reply();
+        return;
+    }
+    fill_output_buffer();
+    strand.post(boost::bind(&Connection::write_reply, this->shared_from_this()));
+}
+
+void Connection::fill_output_buffer()
+{
+    reply.headers.emplace_back("Connection", request.keep_alive ? "keep-alive" : "close");
+
+    // compress the result w/ gzip/deflate if requested
+    switch (compression_type)
+    {
+    case deflateRFC1951:
+        // use deflate for compression
+        reply.headers.insert(reply.headers.begin(), {"Content-Encoding", "deflate"});
+        CompressBufferCollection(reply.content, compression_type, compressed_output);
+        reply.SetSize(static_cast<unsigned>(compressed_output.size()));
+        output_buffer = reply.HeaderstoBuffers();
+        output_buffer.push_back(boost::asio::buffer(compressed_output));
+        break;
+    case gzipRFC1952:
+        // use gzip for compression
+        reply.headers.insert(reply.headers.begin(), {"Content-Encoding", "gzip"});
+        CompressBufferCollection(reply.content, compression_type, compressed_output);
+        reply.SetSize(static_cast<unsigned>(compressed_output.size()));
+        output_buffer = reply.HeaderstoBuffers();
+        output_buffer.push_back(boost::asio::buffer(compressed_output));
+        break;
+    case noCompression:
+        // don't use any compression
+        reply.SetUncompressedSize();
+        output_buffer = reply.ToBuffers();
+        break;
+    }
+}
+
+void Connection::write_reply()
+{
+    // write result to stream
+    boost::asio::async_write(TCP_socket,
+                             output_buffer,
+                             strand.wrap(boost::bind(&Connection::handle_write,
+                                                     this->shared_from_this(),
+                                                     boost::asio::placeholders::error)));
+}
+
+void Connection::write_chunked_reply()
+{
+    // the length is unknown until the last slice is compressed
+    reply.headers.erase(std::remove_if(reply.headers.begin(),
+                                       reply.headers.end(),
+                                       [](const Header &header)
+                                       { return "Content-Length" == header.name; }),
+                        reply.headers.end());
+    reply.headers.insert(reply.headers.begin(),
+                         {"Content-Encoding",
+                          (gzipRFC1952 == compression_type) ? "gzip" : "deflate"});
+    reply.headers.emplace_back("Transfer-Encoding", "chunked");
+    reply.headers.emplace_back("Connection", request.keep_alive ? "keep-alive" : "close");
+
+    std::shared_ptr<std::vector<char>> header_chunk = std::make_shared<std::vector<char>>();
+    for (const boost::asio::const_buffer &buffer : reply.HeaderstoBuffers())
+    {
+        const char *data = boost::asio::buffer_cast<const char *>(buffer);
+        header_chunk->insert(header_chunk->end(), data, data + boost::asio::buffer_size(buffer));
+    }
+    strand.post(
+        boost::bind(&Connection::queue_chunk, this->shared_from_this(), header_chunk, false));
+
+    Compressor &compressor = GetThreadCompressor(compression_type);
+    const char *content_begin = reply.content.data();
+    const char *content_end = content_begin + reply.content.size();
+    for (const char *slice_begin = content_begin; slice_begin != content_end;)
+    {
+        const char *slice_end =
+            slice_begin + std::min<std::size_t>(CHUNK_INPUT_SIZE, content_end - slice_begin);
+        const bool last_slice = (slice_end == content_end);
+
+        std::shared_ptr<std::vector<char>> chunk = std::make_shared<std::vector<char>>();
+        chunk->reserve(CHUNK_INPUT_SIZE);
+        chunk->resize(CHUNK_HEADER_SIZE);
+        compressor.Compress(slice_begin, slice_end, last_slice, *chunk);
+        const std::size_t chunk_size = chunk->size() - CHUNK_HEADER_SIZE;
+        if (0 < chunk_size)
+        {
+            char chunk_header[CHUNK_HEADER_SIZE + 1];
+            std::snprintf(chunk_header,
+                          sizeof(chunk_header),
+                          "%08x\r\n",
+                          static_cast<unsigned>(chunk_size));
+            std::copy(chunk_header, chunk_header + CHUNK_HEADER_SIZE, chunk->begin());
+            chunk->push_back('\r');
+            chunk->push_back('\n');
+        }
+        else
+        {
+            // zlib buffered the whole slice
+            chunk->clear();
+        }
+        if (last_slice)
+        {
+            chunk->insert(chunk->end(), LAST_CHUNK, LAST_CHUNK + sizeof(LAST_CHUNK) - 1);
+        }
+        // the connection must not touch the reply content after the last chunk is queued
+        strand.post(boost::bind(
+            &Connection::queue_chunk, this->shared_from_this(), chunk, last_slice));
+        slice_begin = slice_end;
+    }
+}
+
+void Connection::queue_chunk(const std::shared_ptr<std::vector<char>> &chunk,
+                             const bool last_chunk)
+{
+    if (!chunk->empty())
+    {
+        pending_chunks.push_back(chunk);
+    }
+    last_chunk_queued = last_chunk;
+    if (!chunk_write_in_progress)
+    {
+        write_next_chunk();
+    }
+}
+
+void Connection::write_next_chunk()
+{
+    if (pending_chunks.empty())
+    {
+        chunk_write_in_progress = false;
+        if (last_chunk_queued)
+        {
+            handle_write(boost::system::error_code());
+        }
+        return;
+    }
+
+    chunk_write_in_progress = true;
+    boost::asio::async_write(TCP_socket,
+                             boost::asio::buffer(*pending_chunks.front()),
+                             strand.wrap(boost::bind(&Connection::handle_chunk_write,
+                                                     this->shared_from_this(),
+                                                     boost::asio::placeholders::error)));
+}
+
+void Connection::handle_chunk_write(const boost::system::error_code &error)
+{
+    pending_chunks.pop_front();
+    if (error)
+    {
+        // chunk_write_in_progress stays set, chunks the worker still queues are never written
+        pending_chunks.clear();
+        return;
     }
+    write_next_chunk();
 }
 
 /// Handle completion of a write operation.
 void Connection::handle_write(const boost::system::error_code &error)
 {
-    if (!error)
+    if (error)
+    {
+        return;
+    }
+
+    if (!request.keep_alive)
     {
         // Initiate graceful connection closure.
         boost::system::error_code ignore_error;
         TCP_socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignore_error);
+        return;
+    }
+
+    // get ready for the next request on this connection
+    request = Request();
+    request_parser.Reset();
+    compression_type = noCompression;
+    reply = Reply();
+    compressed_output.clear();
+    output_buffer.clear();
+    last_chunk_queued = false;
+
+    // answer pipelined requests before reading from the socket again
+    if (unparsed_begin != unparsed_end)
+    {
+        process_input(unparsed_begin, unparsed_end);
+    }
+    else
+    {
+        read_more_input();
     }
 }
 
-void Connection::CompressBufferCollection(std::vector<char> uncompressed_data,
-                                          CompressionType compression_type,
-                                          std::vector<char> &compressed_data)
+void Connection::handle_timeout(const boost::system::error_code &error)
 {
-    boost::iostreams::gzip_params compression_parameters;
-
-    // there's a trade-off between speed and size. speed wins
-    compression_parameters.level = boost::iostreams::zlib::best_speed;
-    // check which compression flavor is used
-    if (deflateRFC1951 == compression_type)
+    // the timer was cancelled or moved by a read that completed in the meantime
+    if (boost::asio::error::operation_aborted == error ||
+        idle_timer.expires_at() > boost::asio::deadline_timer::traits_type::now())
     {
-        compression_parameters.noheader = true;
+        return;
     }
 
+    // closing the socket aborts the pending read, which releases the connection
+    boost::system::error_code ignore_error;
+    TCP_socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignore_error);
+    TCP_socket.close(ignore_error);
+}
+
+void Connection::CompressBufferCollection(const std::vector<char> &uncompressed_data,
+                                          CompressionType compression_type,
+                                          std::vector<char> &compressed_data)
+{
     BOOST_ASSERT(compressed_data.empty());
-    // plug data into boost's compression stream
-    boost::iostreams::filtering_ostream gzip_stream;
-    gzip_stream.push(boost::iostreams::gzip_compressor(compression_parameters));
-    gzip_stream.push(boost::iostreams::back_inserter(compressed_data));
-    gzip_stream.write(&uncompressed_data[0], uncompressed_data.size());
-    boost::iostreams::close(gzip_stream);
+    // the content is read in place and compressed in a single pass
+    Compressor &compressor = GetThreadCompressor(compression_type);
+    compressed_data.reserve(compressor.Bound(uncompressed_data.size()));
+    compressor.Compress(uncompressed_data.data(),
+                        uncompressed_data.data() + uncompressed_data.size(),
+                        true,
+                        compressed_data);
 }
 }
@@ -39,6 +39,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/config.hpp>
 #include <boost/version.hpp>
 
+ #include <deque>
  #include <memory>
  #include <string>
  #include <vector>
@@ -65,6 +66,7 @@ T* get_pointer(std::shared_ptr<T>& p)
 
 
 class RequestHandler;
+class WorkerPool;
 
 namespace http
 {
@@ -73,7 +75,9 @@ namespace http
 class Connection : public std::enable_shared_from_this<Connection>
 {
   public:
-    explicit Connection(boost::asio::io_service &io_service, RequestHandler &handler);
+    Connection(boost::asio::io_service &io_service,
+               RequestHandler &handler,
+               WorkerPool &worker_pool);
     Connection(const Connection &) = delete;
     Connection() = delete;
 
@@ -83,22 +87,59 @@ class Connection : public std::enable_shared_from_this<Connection>
     void start();
 
   private:
+    /// Wait for more input, the connection is closed if none arrives within the idle timeout.
+    void read_more_input();
+
     void handle_read(const boost::system::error_code &e, std::size_t bytes_transferred);
 
+    /// Parse buffered input and answer the request once it is complete.
+    void process_input(char *begin, char *end);
+
+    /// Runs on a worker thread, computes and compresses the reply.
+    void handle_request();
+
+    /// Add the connection header and compress the reply content if requested.
+    void fill_output_buffer();
+
+    void write_reply();
+
+    /// Runs on a worker thread, compresses large replies slice by slice into HTTP chunks.
+    void write_chunked_reply();
+
+    void queue_chunk(const std::shared_ptr<std::vector<char>> &chunk, const bool last_chunk);
+
+    void write_next_chunk();
+
+    void handle_chunk_write(const boost::system::error_code &e);
+
     /// Handle completion of a write operation.
     void handle_write(const boost::system::error_code &e);
 
-    void CompressBufferCollection(std::vector<char> uncompressed_data,
+    void handle_timeout(const boost::system::error_code &e);
+
+    void CompressBufferCollection(const std::vector<char> &uncompressed_data,
                                   CompressionType compression_type,
                                   std::vector<char> &compressed_data);
 
     boost::asio::io_service::strand strand;
     boost::asio::ip::tcp::socket TCP_socket;
+    boost::asio::deadline_timer idle_timer;
     RequestHandler &request_handler;
+    WorkerPool &worker_pool;
     boost::array<char, 8192> incoming_data_buffer;
+    // pipelined input that arrived behind the request currently answered
+    char *unparsed_begin;
+    char *unparsed_end;
     Request request;
     RequestParser request_parser;
+    CompressionType compression_type;
     Reply reply;
+    std::vector<char> compressed_output;
+    std::vector<boost::asio::const_buffer> output_buffer;
+    // chunks of a chunked reply that still have to be written
+    std::deque<std::shared_ptr<std::vector<char>>> pending_chunks;
+    bool chunk_write_in_progress;
+    bool last_chunk_queued;
 };
 
 } // namespace http
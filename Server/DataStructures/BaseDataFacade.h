@@ -33,6 +33,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../../DataStructures/EdgeBasedNode.h"
 #include "../../DataStructures/ImportNode.h"
 #include "../../DataStructures/PhantomNodes.h"
+#include "../../DataStructures/PoiBuckets.h"
 #include "../../DataStructures/Range.h"
 #include "../../DataStructures/TurnInstructions.h"
 #include "../../Util/OSRMException.h"
@@ -41,7 +42,9 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <osrm/Coordinate.h>
 
+#include <functional>
 #include <string>
+#include <vector>
 
 typedef osrm::range<EdgeID> EdgeRange;
 
@@ -107,13 +110,57 @@ template <class EdgeDataT> class BaseDataFacade
                                             std::vector<PhantomNode> &resulting_phantom_node_vector,
                                             const unsigned zoom_level,
                                             const unsigned number_of_results) = 0;
-    
+
+    // snap a batch of coordinates at once, results are in input order. Returns false if any
+    // coordinate could not be snapped.
     virtual bool
-    IncrementalFindPhantomPoiNodeForCoordinate(const FixedPointCoordinate &input_coordinate,
-                                            std::vector<PhantomNode> &resulting_phantom_node_vector,
-                                            const unsigned zoom_level,
-                                            const unsigned number_of_results) = 0;
-    
+    FindPhantomNodesForCoordinates(const std::vector<FixedPointCoordinate> &input_coordinates,
+                                   std::vector<PhantomNode> &resulting_phantom_nodes,
+                                   const unsigned zoom_level) = 0;
+
+    virtual bool IncrementalFindPhantomNodesForCoordinates(
+        const std::vector<FixedPointCoordinate> &input_coordinates,
+        std::vector<std::vector<PhantomNode>> &resulting_phantom_node_vectors,
+        const unsigned zoom_level,
+        const unsigned number_of_results) = 0;
+
+    // range queries on the r-tree, the callback sees every segment in the rectangle or radius
+    // until it returns false. Returns false if the query was stopped by the callback.
+    virtual bool ForEachSegmentInRectangle(
+        const FixedPointCoordinate &first_corner,
+        const FixedPointCoordinate &second_corner,
+        const std::function<bool(const RTreeLeaf &)> &callback) = 0;
+
+    virtual bool
+    ForEachSegmentInRadius(const FixedPointCoordinate &center,
+                           const float max_distance,
+                           const std::function<bool(const RTreeLeaf &)> &callback) = 0;
+
+    // range queries on the poi index, the callback sees the id of every poi in the radius or
+    // rectangle until it returns false. Returns false if the query was stopped by the callback.
+    virtual bool ForEachPoiInRadius(const FixedPointCoordinate &center,
+                                    const float max_distance,
+                                    const std::function<bool(unsigned)> &callback) const = 0;
+
+    virtual bool ForEachPoiInRectangle(const FixedPointCoordinate &first_corner,
+                                       const FixedPointCoordinate &second_corner,
+                                       const std::function<bool(unsigned)> &callback) const = 0;
+
+    // false if the data was prepared without a .poibuckets file
+    virtual bool HasPoiBuckets() const = 0;
+
+    // precomputed backward search spaces of all pois
+    virtual unsigned GetNumberOfPois() const = 0;
+
+    // largest distance covered by the buckets, INVALID_EDGE_WEIGHT if unbounded
+    virtual EdgeWeight GetPoiBucketRadius() const = 0;
+
+    virtual PoiInfo GetPoiInfo(const unsigned poi_id) const = 0;
+
+    virtual osrm::range<unsigned> GetPoiBucketRange(const NodeID node) const = 0;
+
+    virtual const PoiBucketEntry &GetPoiBucketEntry(const unsigned index) const = 0;
+
     virtual unsigned GetCheckSum() const = 0;
 
     virtual unsigned GetNameIndexFromEdgeID(const unsigned id) const = 0;
@@ -38,11 +38,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../../DataStructures/QueryEdge.h"
 #include "../../DataStructures/SharedMemoryVectorWrapper.h"
 #include "../../DataStructures/StaticGraph.h"
+#include "../../DataStructures/StaticPoiIndex.h"
 #include "../../DataStructures/StaticRTree.h"
 #include "../../DataStructures/RangeTable.h"
 #include "../../Util/BoostFileSystemFix.h"
 #include "../../Util/ProgramOptions.h"
 #include "../../Util/GraphLoader.h"
+#include "../../Util/make_unique.hpp"
 #include "../../Util/simple_logger.hpp"
 
 #include <osrm/Coordinate.h>
@@ -56,6 +58,7 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
     typedef StaticGraph<typename super::EdgeData> QueryGraph;
     typedef typename QueryGraph::InputEdge InputEdge;
     typedef typename super::RTreeLeaf RTreeLeaf;
+    typedef StaticRTree<RTreeLeaf, ShM<FixedPointCoordinate, false>::vector, false> InternalRTree;
 
     InternalDataFacade() {}
 
@@ -63,9 +66,7 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
     unsigned m_number_of_nodes;
     QueryGraph *m_query_graph;
     std::string m_timestamp;
-    
-    std::unordered_set<NodeID> poi_node_ids;
-    std::unordered_map<NodeID, NodeID> m_external_to_internal_node_id;
+
     std::shared_ptr<ShM<FixedPointCoordinate, false>::vector> m_coordinate_list;
     ShM<NodeID, false>::vector m_via_node_list;
     ShM<unsigned, false>::vector m_name_ID_list;
@@ -75,9 +76,14 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
     ShM<bool, false>::vector m_edge_is_compressed;
     ShM<unsigned, false>::vector m_geometry_indices;
     ShM<unsigned, false>::vector m_geometry_list;
-
-    boost::thread_specific_ptr<
-        StaticRTree<RTreeLeaf, ShM<FixedPointCoordinate, false>::vector, false>> m_static_rtree;
+    EdgeWeight m_poi_bucket_radius;
+    ShM<PoiInfo, false>::vector m_poi_list;
+    ShM<unsigned, false>::vector m_poi_bucket_offsets;
+    ShM<PoiBucketEntry, false>::vector m_poi_bucket_list;
+    ShM<PoiBoundingBox, false>::vector m_poi_box_list;
+    std::unique_ptr<StaticPoiIndex<false>> m_poi_index;
+
+    boost::thread_specific_ptr<InternalRTree> m_static_rtree;
     boost::filesystem::path ram_index_path;
     boost::filesystem::path file_index_path;
     RangeTable<16, false> m_name_table;
@@ -135,14 +141,10 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
         nodes_input_stream.read((char *)&number_of_coordinates, sizeof(unsigned));
         m_coordinate_list =
             std::make_shared<std::vector<FixedPointCoordinate>>(number_of_coordinates);
-        m_external_to_internal_node_id = std::unordered_map<NodeID,NodeID>(number_of_coordinates) ;
         for (unsigned i = 0; i < number_of_coordinates; ++i)
         {
             nodes_input_stream.read((char *)&current_node, sizeof(NodeInfo));
-            
             m_coordinate_list->at(i) = FixedPointCoordinate(current_node.lat, current_node.lon);
-            m_external_to_internal_node_id[current_node.node_id] = i;
-            
             BOOST_ASSERT((std::abs(m_coordinate_list->at(i).lat) >> 30) == 0);
             BOOST_ASSERT((std::abs(m_coordinate_list->at(i).lon) >> 30) == 0);
         }
@@ -208,10 +210,9 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
     void LoadRTree()
     {
         BOOST_ASSERT_MSG(!m_coordinate_list->empty(), "coordinates must be loaded before r-tree");
-        BOOST_ASSERT_MSG(!poi_node_ids.empty(), "pois must be loaded before r-tree");
 
         m_static_rtree.reset(
-            new StaticRTree<RTreeLeaf>(ram_index_path, file_index_path, m_coordinate_list, poi_node_ids));
+            new StaticRTree<RTreeLeaf>(ram_index_path, file_index_path, m_coordinate_list));
     }
 
     void LoadStreetNames(const boost::filesystem::path &names_file)
@@ -232,41 +233,58 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
         name_stream.close();
     }
     
-    void LoadNodePoiList(const boost::filesystem::path &poiFile) {
-        SimpleLogger().Write() << "Loading poi File ";
+    void LoadPoiBuckets(const boost::filesystem::path &poi_buckets_file)
+    {
+        boost::filesystem::ifstream bucket_stream(poi_buckets_file, std::ios::binary);
 
-        boost::filesystem::ifstream input_stream(poiFile, std::ios::binary);
-        
         const FingerPrint fingerprint_orig;
         FingerPrint fingerprint_loaded;
-        input_stream.read((char *)&fingerprint_loaded, sizeof(FingerPrint));
-        
-        if (!fingerprint_loaded.TestGraphUtil(fingerprint_orig))
+        bucket_stream.read((char *)&fingerprint_loaded, sizeof(FingerPrint));
+        if (!fingerprint_loaded.TestPrepare(fingerprint_orig))
         {
-            SimpleLogger().Write(logWARNING) << ".osrm was prepared with different build.\n"
-            "Reprocess to get rid of this warning.";
+            SimpleLogger().Write(logWARNING) << ".poibuckets was prepared with different build.\n"
+                                                "Reprocess to get rid of this warning.";
         }
-        
-        NodeID n;
-        input_stream.read((char *)&n, sizeof(NodeID));
-        SimpleLogger().Write() << "Importing n = " << n << " poi ";
-        
-        ExternalMemoryNode current_node;
-        PhantomNode phantom_node ;
-        poi_node_ids = std::unordered_set<NodeID>(n) ;
-        
-        for (NodeID i = 0; i < n; ++i)
+        bucket_stream.read((char *)&m_poi_bucket_radius, sizeof(EdgeWeight));
+
+        unsigned number_of_pois = 0;
+        bucket_stream.read((char *)&number_of_pois, sizeof(unsigned));
+        m_poi_list.resize(number_of_pois);
+        if (number_of_pois > 0)
         {
-            input_stream.read((char *)&current_node, sizeof(ExternalMemoryNode));
-            if (current_node.poi)
-            {
-                poi_node_ids.emplace(m_external_to_internal_node_id[current_node.node_id]) ; //use internal id
-            }
+            bucket_stream.read((char *)&m_poi_list[0], number_of_pois * sizeof(PoiInfo));
         }
-        
-        
-        SimpleLogger().Write() << "nodes in poi file: " << poi_node_ids.size();
-        
+
+        unsigned number_of_offsets = 0;
+        bucket_stream.read((char *)&number_of_offsets, sizeof(unsigned));
+        m_poi_bucket_offsets.resize(number_of_offsets);
+        if (number_of_offsets > 0)
+        {
+            bucket_stream.read((char *)&m_poi_bucket_offsets[0],
+                               number_of_offsets * sizeof(unsigned));
+        }
+
+        unsigned number_of_buckets = 0;
+        bucket_stream.read((char *)&number_of_buckets, sizeof(unsigned));
+        m_poi_bucket_list.resize(number_of_buckets);
+        if (number_of_buckets > 0)
+        {
+            bucket_stream.read((char *)&m_poi_bucket_list[0],
+                               number_of_buckets * sizeof(PoiBucketEntry));
+        }
+
+        unsigned number_of_boxes = 0;
+        bucket_stream.read((char *)&number_of_boxes, sizeof(unsigned));
+        m_poi_box_list.resize(number_of_boxes);
+        if (number_of_boxes > 0)
+        {
+            bucket_stream.read((char *)&m_poi_box_list[0],
+                               number_of_boxes * sizeof(PoiBoundingBox));
+        }
+        m_poi_index = osrm::make_unique<StaticPoiIndex<false>>(m_poi_list, m_poi_box_list);
+        bucket_stream.close();
+        SimpleLogger().Write() << "loaded " << number_of_buckets << " buckets of "
+                               << number_of_pois << " pois";
     }
 
   public:
@@ -307,14 +325,13 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
         {
             throw OSRMException("no names file given in ini file");
         }
-        if (server_paths.find("poi") == server_paths.end())
+        
+        ServerPaths::const_iterator paths_iterator = server_paths.find("poibuckets");
+        boost::filesystem::path poi_buckets_path;
+        if (server_paths.end() != paths_iterator)
         {
-            throw OSRMException("no poi file given in ini file");
+            poi_buckets_path = paths_iterator->second;
         }
-        
-        ServerPaths::const_iterator paths_iterator = server_paths.find("poi");
-        BOOST_ASSERT(server_paths.end() != paths_iterator);
-        const boost::filesystem::path &poi_data_path = paths_iterator->second;
         paths_iterator = server_paths.find("hsgrdata");
         BOOST_ASSERT(server_paths.end() != paths_iterator);
         const boost::filesystem::path &hsgr_path = paths_iterator->second;
@@ -348,10 +365,18 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
         AssertPathExists(nodes_data_path);
         AssertPathExists(edges_data_path);
         LoadNodeAndEdgeInformation(nodes_data_path, edges_data_path);
-        SimpleLogger().Write() << "loading pois" ;
-        AssertPathExists(poi_data_path);
-        LoadNodePoiList(poi_data_path) ;
-        SimpleLogger().Write() << "done number of pois" << poi_node_ids.size() ;
+        if (boost::filesystem::is_regular_file(poi_buckets_path))
+        {
+            SimpleLogger().Write() << "loading poi buckets";
+            LoadPoiBuckets(poi_buckets_path);
+        }
+        else
+        {
+            SimpleLogger().Write(logWARNING) << "no .poibuckets file found, "
+                                                "the poi service will be disabled";
+            m_poi_bucket_radius = 0;
+            m_poi_index = osrm::make_unique<StaticPoiIndex<false>>(m_poi_list, m_poi_box_list);
+        }
         SimpleLogger().Write() << "loading geometries";
         AssertPathExists(geometries_path);
         LoadGeometries(geometries_path);
@@ -462,23 +487,96 @@ template <class EdgeDataT> class InternalDataFacade : public BaseDataFacade<Edge
             input_coordinate, resulting_phantom_node_vector, zoom_level, number_of_results);
     }
 
+    bool FindPhantomNodesForCoordinates(const std::vector<FixedPointCoordinate> &input_coordinates,
+                                        std::vector<PhantomNode> &resulting_phantom_nodes,
+                                        const unsigned zoom_level) final
+    {
+        if (!m_static_rtree.get())
+        {
+            LoadRTree();
+        }
 
+        return m_static_rtree->FindPhantomNodesForCoordinates(
+            input_coordinates, resulting_phantom_nodes, zoom_level);
+    }
 
-    virtual bool
-    IncrementalFindPhantomPoiNodeForCoordinate(const FixedPointCoordinate &input_coordinate,
-                                           std::vector<PhantomNode> &resulting_phantom_node_vector,
-                                           const unsigned zoom_level,
-                                           const unsigned number_of_results)
+    bool IncrementalFindPhantomNodesForCoordinates(
+        const std::vector<FixedPointCoordinate> &input_coordinates,
+        std::vector<std::vector<PhantomNode>> &resulting_phantom_node_vectors,
+        const unsigned zoom_level,
+        const unsigned number_of_results) final
     {
         if (!m_static_rtree.get())
         {
             LoadRTree();
         }
-        
-        return m_static_rtree->IncrementalFindPhantomPoiNodeForCoordinate(
-                                                                       input_coordinate, resulting_phantom_node_vector, zoom_level, number_of_results);
-    
-    
+
+        return m_static_rtree->IncrementalFindPhantomNodesForCoordinates(
+            input_coordinates, resulting_phantom_node_vectors, zoom_level, number_of_results);
+    }
+
+    bool ForEachSegmentInRectangle(const FixedPointCoordinate &first_corner,
+                                   const FixedPointCoordinate &second_corner,
+                                   const std::function<bool(const RTreeLeaf &)> &callback) final
+    {
+        if (!m_static_rtree.get())
+        {
+            LoadRTree();
+        }
+
+        const typename InternalRTree::RectangleT search_rectangle(first_corner, second_corner);
+        return m_static_rtree->ForEachSegmentInRectangle(search_rectangle, callback);
+    }
+
+    bool ForEachSegmentInRadius(const FixedPointCoordinate &center,
+                                const float max_distance,
+                                const std::function<bool(const RTreeLeaf &)> &callback) final
+    {
+        if (!m_static_rtree.get())
+        {
+            LoadRTree();
+        }
+
+        return m_static_rtree->ForEachSegmentInRadius(center, max_distance, callback);
+    }
+
+    bool ForEachPoiInRadius(const FixedPointCoordinate &center,
+                            const float max_distance,
+                            const std::function<bool(unsigned)> &callback) const final
+    {
+        return m_poi_index->ForEachPoiInRadius(center, max_distance, callback);
+    }
+
+    bool ForEachPoiInRectangle(const FixedPointCoordinate &first_corner,
+                               const FixedPointCoordinate &second_corner,
+                               const std::function<bool(unsigned)> &callback) const final
+    {
+        PoiBoundingBox search_box;
+        search_box.Extend(first_corner);
+        search_box.Extend(second_corner);
+        return m_poi_index->ForEachPoiInRectangle(search_box, callback);
+    }
+
+    bool HasPoiBuckets() const final { return !m_poi_bucket_offsets.empty(); }
+
+    unsigned GetNumberOfPois() const final { return static_cast<unsigned>(m_poi_list.size()); }
+
+    EdgeWeight GetPoiBucketRadius() const final { return m_poi_bucket_radius; }
+
+    PoiInfo GetPoiInfo(const unsigned poi_id) const final { return m_poi_list.at(poi_id); }
+
+    osrm::range<unsigned> GetPoiBucketRange(const NodeID node) const final
+    {
+        if (node + 1 >= m_poi_bucket_offsets.size())
+        {
+            return osrm::irange(0u, 0u);
+        }
+        return osrm::irange(m_poi_bucket_offsets[node], m_poi_bucket_offsets[node + 1]);
+    }
+
+    const PoiBucketEntry &GetPoiBucketEntry(const unsigned index) const final
+    {
+        return m_poi_bucket_list[index];
     }
 
     unsigned GetCheckSum() const final { return m_check_sum; }
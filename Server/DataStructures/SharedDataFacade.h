@@ -35,6 +35,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../../DataStructures/RangeTable.h"
 #include "../../DataStructures/StaticGraph.h"
+#include "../../DataStructures/StaticPoiIndex.h"
 #include "../../DataStructures/StaticRTree.h"
 #include "../../Util/BoostFileSystemFix.h"
 #include "../../Util/ProgramOptions.h"
@@ -57,11 +58,11 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
     typedef typename QueryGraph::InputEdge InputEdge;
     typedef typename super::RTreeLeaf RTreeLeaf;
     using SharedRTree = StaticRTree<RTreeLeaf, ShM<FixedPointCoordinate, true>::vector, true>;
-    using TimeStampedRTreePair = std::pair<unsigned, std::shared_ptr<SharedRTree>>;
     using RTreeNode = typename SharedRTree::TreeNode;
 
     SharedDataLayout *data_layout;
     char *shared_memory;
+    std::unique_ptr<SharedMemory> m_regions_memory;
     SharedDataTimestamp *data_timestamp_ptr;
 
     SharedDataType CURRENT_LAYOUT;
@@ -84,8 +85,14 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
     ShM<bool, true>::vector m_edge_is_compressed;
     ShM<unsigned, true>::vector m_geometry_indices;
     ShM<unsigned, true>::vector m_geometry_list;
-
-    boost::thread_specific_ptr<std::pair<unsigned, std::shared_ptr<SharedRTree>>> m_static_rtree;
+    EdgeWeight m_poi_bucket_radius;
+    ShM<PoiInfo, true>::vector m_poi_list;
+    ShM<unsigned, true>::vector m_poi_bucket_offsets;
+    ShM<PoiBucketEntry, true>::vector m_poi_bucket_list;
+    ShM<PoiBoundingBox, true>::vector m_poi_box_list;
+    std::unique_ptr<StaticPoiIndex<true>> m_poi_index;
+
+    std::unique_ptr<SharedRTree> m_static_rtree;
     boost::filesystem::path file_index_path;
 
     std::shared_ptr<RangeTable<16, true>> m_name_table;
@@ -113,12 +120,11 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
 
         RTreeNode *tree_ptr =
             data_layout->GetBlockPtr<RTreeNode>(shared_memory, SharedDataLayout::R_SEARCH_TREE);
-        m_static_rtree.reset(new TimeStampedRTreePair(CURRENT_TIMESTAMP,
-            osrm::make_unique<SharedRTree>(
-                tree_ptr,
-                data_layout->num_entries[SharedDataLayout::R_SEARCH_TREE],
-                file_index_path,
-                m_coordinate_list)));
+        m_static_rtree = osrm::make_unique<SharedRTree>(
+            tree_ptr,
+            data_layout->num_entries[SharedDataLayout::R_SEARCH_TREE],
+            file_index_path,
+            m_coordinate_list);
     }
 
     void LoadGraph()
@@ -217,71 +223,102 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
         m_geometry_list.swap(geometry_list);
     }
 
+    void LoadPoiBuckets()
+    {
+        m_poi_bucket_radius = *data_layout->GetBlockPtr<EdgeWeight>(
+            shared_memory, SharedDataLayout::POI_BUCKET_RADIUS);
+
+        PoiInfo *poi_list_ptr =
+            data_layout->GetBlockPtr<PoiInfo>(shared_memory, SharedDataLayout::POI_LIST);
+        typename ShM<PoiInfo, true>::vector poi_list(
+            poi_list_ptr, data_layout->num_entries[SharedDataLayout::POI_LIST]);
+        m_poi_list.swap(poi_list);
+
+        unsigned *poi_bucket_offsets_ptr =
+            data_layout->GetBlockPtr<unsigned>(shared_memory, SharedDataLayout::POI_BUCKET_OFFSETS);
+        typename ShM<unsigned, true>::vector poi_bucket_offsets(
+            poi_bucket_offsets_ptr, data_layout->num_entries[SharedDataLayout::POI_BUCKET_OFFSETS]);
+        m_poi_bucket_offsets.swap(poi_bucket_offsets);
+
+        PoiBucketEntry *poi_bucket_list_ptr = data_layout->GetBlockPtr<PoiBucketEntry>(
+            shared_memory, SharedDataLayout::POI_BUCKET_LIST);
+        typename ShM<PoiBucketEntry, true>::vector poi_bucket_list(
+            poi_bucket_list_ptr, data_layout->num_entries[SharedDataLayout::POI_BUCKET_LIST]);
+        m_poi_bucket_list.swap(poi_bucket_list);
+
+        PoiBoundingBox *poi_box_list_ptr =
+            data_layout->GetBlockPtr<PoiBoundingBox>(shared_memory, SharedDataLayout::POI_INDEX);
+        typename ShM<PoiBoundingBox, true>::vector poi_box_list(
+            poi_box_list_ptr, data_layout->num_entries[SharedDataLayout::POI_INDEX]);
+        m_poi_box_list.swap(poi_box_list);
+        m_poi_index = osrm::make_unique<StaticPoiIndex<true>>(m_poi_list, m_poi_box_list);
+    }
+
   public:
     virtual ~SharedDataFacade() {}
 
+    // Maps the regions that are current in shared memory. The facade is immutable afterwards and
+    // keeps the segments mapped until it is destroyed, a newer data set needs a new facade.
     SharedDataFacade()
     {
-        data_timestamp_ptr = (SharedDataTimestamp *)SharedMemoryFactory::Get(
-                                 CURRENT_REGIONS, sizeof(SharedDataTimestamp), false, false)->Ptr();
-        CURRENT_LAYOUT = LAYOUT_NONE;
-        CURRENT_DATA = DATA_NONE;
-        CURRENT_TIMESTAMP = 0;
+        m_regions_memory.reset(SharedMemoryFactory::Get(
+            CURRENT_REGIONS, sizeof(SharedDataTimestamp), false, false));
+        data_timestamp_ptr = (SharedDataTimestamp *)m_regions_memory->Ptr();
 
-        // load data
-        CheckAndReloadFacade();
-    }
+        CURRENT_LAYOUT = data_timestamp_ptr->layout;
+        CURRENT_DATA = data_timestamp_ptr->data;
+        CURRENT_TIMESTAMP = data_timestamp_ptr->timestamp;
 
-    void CheckAndReloadFacade()
-    {
-        if (CURRENT_LAYOUT != data_timestamp_ptr->layout ||
-            CURRENT_DATA != data_timestamp_ptr->data ||
-            CURRENT_TIMESTAMP != data_timestamp_ptr->timestamp)
-        {
-            // release the previous shared memory segments
-            SharedMemory::Remove(CURRENT_LAYOUT);
-            SharedMemory::Remove(CURRENT_DATA);
+        m_layout_memory.reset(SharedMemoryFactory::Get(CURRENT_LAYOUT));
 
-            CURRENT_LAYOUT = data_timestamp_ptr->layout;
-            CURRENT_DATA = data_timestamp_ptr->data;
-            CURRENT_TIMESTAMP = data_timestamp_ptr->timestamp;
+        data_layout = (SharedDataLayout *)(m_layout_memory->Ptr());
 
-            m_layout_memory.reset(SharedMemoryFactory::Get(CURRENT_LAYOUT));
+        m_large_memory.reset(SharedMemoryFactory::Get(CURRENT_DATA));
+        shared_memory = (char *)(m_large_memory->Ptr());
 
-            data_layout = (SharedDataLayout *)(m_layout_memory->Ptr());
+        const char *file_index_ptr =
+            data_layout->GetBlockPtr<char>(shared_memory, SharedDataLayout::FILE_INDEX_PATH);
+        file_index_path = boost::filesystem::path(file_index_ptr);
+        if (!boost::filesystem::exists(file_index_path))
+        {
+            SimpleLogger().Write(logDEBUG) << "Leaf file name " << file_index_path.string();
+            throw OSRMException("Could not load leaf index file."
+                                "Is any data loaded into shared memory?");
+        }
 
-            m_large_memory.reset(SharedMemoryFactory::Get(CURRENT_DATA));
-            shared_memory = (char *)(m_large_memory->Ptr());
+        LoadGraph();
+        LoadChecksum();
+        LoadNodeAndEdgeInformation();
+        LoadGeometries();
+        LoadTimestamp();
+        LoadViaNodeList();
+        LoadNames();
+        LoadPoiBuckets();
+        LoadRTree();
 
-            const char *file_index_ptr =
-                data_layout->GetBlockPtr<char>(shared_memory, SharedDataLayout::FILE_INDEX_PATH);
-            file_index_path = boost::filesystem::path(file_index_ptr);
-            if (!boost::filesystem::exists(file_index_path))
+        data_layout->PrintInformation();
+
+        SimpleLogger().Write() << "number of geometries: " << m_coordinate_list->size();
+        for (unsigned i = 0; i < m_coordinate_list->size(); ++i)
+        {
+            if (!GetCoordinateOfNode(i).isValid())
             {
-                SimpleLogger().Write(logDEBUG) << "Leaf file name " << file_index_path.string();
-                throw OSRMException("Could not load leaf index file."
-                                    "Is any data loaded into shared memory?");
+                SimpleLogger().Write() << "coordinate " << i << " not valid";
             }
+        }
+    }
 
-            LoadGraph();
-            LoadChecksum();
-            LoadNodeAndEdgeInformation();
-            LoadGeometries();
-            LoadTimestamp();
-            LoadViaNodeList();
-            LoadNames();
+    SharedDataType GetDataRegion() const { return CURRENT_DATA; }
 
-            data_layout->PrintInformation();
+    // timestamp of the data this facade has mapped
+    unsigned GetLoadedTimestamp() const { return CURRENT_TIMESTAMP; }
 
-            SimpleLogger().Write() << "number of geometries: " << m_coordinate_list->size();
-            for (unsigned i = 0; i < m_coordinate_list->size(); ++i)
-            {
-                if (!GetCoordinateOfNode(i).isValid())
-                {
-                    SimpleLogger().Write() << "coordinate " << i << " not valid";
-                }
-            }
-        }
+    // timestamp of the data osrm-datastore published last. The read is not synchronized with the
+    // datastore, callers have to construct the new facade under the query barrier.
+    unsigned GetPublishedTimestamp() const
+    {
+        const volatile unsigned &current_timestamp = data_timestamp_ptr->timestamp;
+        return current_timestamp;
     }
 
     // search graph access
@@ -361,12 +398,7 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
                                             FixedPointCoordinate &result,
                                             const unsigned zoom_level = 18) final
     {
-        if (!m_static_rtree.get() || CURRENT_TIMESTAMP != m_static_rtree->first)
-        {
-            LoadRTree();
-        }
-
-        return m_static_rtree->second->LocateClosestEndPointForCoordinate(
+        return m_static_rtree->LocateClosestEndPointForCoordinate(
             input_coordinate, result, zoom_level);
     }
 
@@ -374,12 +406,7 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
                                       PhantomNode &resulting_phantom_node,
                                       const unsigned zoom_level) final
     {
-        if (!m_static_rtree.get() || CURRENT_TIMESTAMP != m_static_rtree->first)
-        {
-            LoadRTree();
-        }
-
-        return m_static_rtree->second->FindPhantomNodeForCoordinate(
+        return m_static_rtree->FindPhantomNodeForCoordinate(
             input_coordinate, resulting_phantom_node, zoom_level);
     }
 
@@ -389,30 +416,80 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
                                             const unsigned zoom_level,
                                             const unsigned number_of_results) final
     {
-        if (!m_static_rtree.get() || CURRENT_TIMESTAMP != m_static_rtree->first)
-        {
-            LoadRTree();
-        }
-
-        return m_static_rtree->second->IncrementalFindPhantomNodeForCoordinate(
+        return m_static_rtree->IncrementalFindPhantomNodeForCoordinate(
             input_coordinate, resulting_phantom_node_vector, zoom_level, number_of_results);
     }
 
+    bool FindPhantomNodesForCoordinates(const std::vector<FixedPointCoordinate> &input_coordinates,
+                                        std::vector<PhantomNode> &resulting_phantom_nodes,
+                                        const unsigned zoom_level) final
+    {
+        return m_static_rtree->FindPhantomNodesForCoordinates(
+            input_coordinates, resulting_phantom_nodes, zoom_level);
+    }
+
+    bool IncrementalFindPhantomNodesForCoordinates(
+        const std::vector<FixedPointCoordinate> &input_coordinates,
+        std::vector<std::vector<PhantomNode>> &resulting_phantom_node_vectors,
+        const unsigned zoom_level,
+        const unsigned number_of_results) final
+    {
+        return m_static_rtree->IncrementalFindPhantomNodesForCoordinates(
+            input_coordinates, resulting_phantom_node_vectors, zoom_level, number_of_results);
+    }
+
+    bool ForEachSegmentInRectangle(const FixedPointCoordinate &first_corner,
+                                   const FixedPointCoordinate &second_corner,
+                                   const std::function<bool(const RTreeLeaf &)> &callback) final
+    {
+        const typename SharedRTree::RectangleT search_rectangle(first_corner, second_corner);
+        return m_static_rtree->ForEachSegmentInRectangle(search_rectangle, callback);
+    }
+
+    bool ForEachSegmentInRadius(const FixedPointCoordinate &center,
+                                const float max_distance,
+                                const std::function<bool(const RTreeLeaf &)> &callback) final
+    {
+        return m_static_rtree->ForEachSegmentInRadius(center, max_distance, callback);
+    }
+
+    bool ForEachPoiInRadius(const FixedPointCoordinate &center,
+                            const float max_distance,
+                            const std::function<bool(unsigned)> &callback) const final
+    {
+        return m_poi_index->ForEachPoiInRadius(center, max_distance, callback);
+    }
 
-    virtual bool
-    IncrementalFindPhantomPoiNodeForCoordinate(const FixedPointCoordinate &input_coordinate,
-                                           std::vector<PhantomNode> &resulting_phantom_node_vector,
-                                           const unsigned zoom_level,
-                                           const unsigned number_of_results)
+    bool ForEachPoiInRectangle(const FixedPointCoordinate &first_corner,
+                               const FixedPointCoordinate &second_corner,
+                               const std::function<bool(unsigned)> &callback) const final
     {
-        if (!m_static_rtree.get() || CURRENT_TIMESTAMP != m_static_rtree->first)
+        PoiBoundingBox search_box;
+        search_box.Extend(first_corner);
+        search_box.Extend(second_corner);
+        return m_poi_index->ForEachPoiInRectangle(search_box, callback);
+    }
+
+    bool HasPoiBuckets() const final { return !m_poi_bucket_offsets.empty(); }
+
+    unsigned GetNumberOfPois() const final { return static_cast<unsigned>(m_poi_list.size()); }
+
+    EdgeWeight GetPoiBucketRadius() const final { return m_poi_bucket_radius; }
+
+    PoiInfo GetPoiInfo(const unsigned poi_id) const final { return m_poi_list.at(poi_id); }
+
+    osrm::range<unsigned> GetPoiBucketRange(const NodeID node) const final
+    {
+        if (node + 1 >= m_poi_bucket_offsets.size())
         {
-            LoadRTree();
+            return osrm::irange(0u, 0u);
         }
-    
-        return m_static_rtree->second->IncrementalFindPhantomPoiNodeForCoordinate(
-                                                                           input_coordinate, resulting_phantom_node_vector, zoom_level, number_of_results);
-    
+        return osrm::irange(m_poi_bucket_offsets[node], m_poi_bucket_offsets[node + 1]);
+    }
+
+    const PoiBucketEntry &GetPoiBucketEntry(const unsigned index) const final
+    {
+        return m_poi_bucket_list[index];
     }
 
     unsigned GetCheckSum() const final { return m_check_sum; }
@@ -442,11 +519,6 @@ template <class EdgeDataT> class SharedDataFacade : public BaseDataFacade<EdgeDa
     }
 
     std::string GetTimestamp() const final { return m_timestamp; }
-
-    virtual std::vector<PhantomNode> GetPoisPhantomNodeList() const final
-    {
-        return std::vector<PhantomNode> () ; // TODO implement
-    }
 };
 
 #endif // SHARED_DATA_FACADE_H
@@ -58,6 +58,11 @@ struct SharedDataLayout
         HSGR_CHECKSUM,
         TIMESTAMP,
         FILE_INDEX_PATH,
+        POI_BUCKET_RADIUS,
+        POI_LIST,
+        POI_BUCKET_OFFSETS,
+        POI_BUCKET_LIST,
+        POI_INDEX,
         NUM_BLOCKS
     };
 
@@ -90,6 +95,10 @@ struct SharedDataLayout
         SimpleLogger().Write(logDEBUG) << "geometries_index_list_size: " << num_entries[GEOMETRIES_INDEX];
         SimpleLogger().Write(logDEBUG) << "geometries_list_size:       " << num_entries[GEOMETRIES_LIST];
         SimpleLogger().Write(logDEBUG) << "sizeof(checksum):           " << entry_size[HSGR_CHECKSUM];
+        SimpleLogger().Write(logDEBUG) << "poi_list_size:              " << num_entries[POI_LIST];
+        SimpleLogger().Write(logDEBUG) << "poi_bucket_offsets_size:    " << num_entries[POI_BUCKET_OFFSETS];
+        SimpleLogger().Write(logDEBUG) << "poi_bucket_list_size:       " << num_entries[POI_BUCKET_LIST];
+        SimpleLogger().Write(logDEBUG) << "poi_index_size:             " << num_entries[POI_INDEX];
 
         SimpleLogger().Write(logDEBUG) << "NAME_OFFSETS         " << ": " << GetBlockSize(NAME_OFFSETS         );
         SimpleLogger().Write(logDEBUG) << "NAME_BLOCKS          " << ": " << GetBlockSize(NAME_BLOCKS          );
@@ -108,6 +117,11 @@ struct SharedDataLayout
         SimpleLogger().Write(logDEBUG) << "HSGR_CHECKSUM        " << ": " << GetBlockSize(HSGR_CHECKSUM        );
         SimpleLogger().Write(logDEBUG) << "TIMESTAMP            " << ": " << GetBlockSize(TIMESTAMP            );
         SimpleLogger().Write(logDEBUG) << "FILE_INDEX_PATH      " << ": " << GetBlockSize(FILE_INDEX_PATH      );
+        SimpleLogger().Write(logDEBUG) << "POI_BUCKET_RADIUS    " << ": " << GetBlockSize(POI_BUCKET_RADIUS    );
+        SimpleLogger().Write(logDEBUG) << "POI_LIST             " << ": " << GetBlockSize(POI_LIST             );
+        SimpleLogger().Write(logDEBUG) << "POI_BUCKET_OFFSETS   " << ": " << GetBlockSize(POI_BUCKET_OFFSETS   );
+        SimpleLogger().Write(logDEBUG) << "POI_BUCKET_LIST      " << ": " << GetBlockSize(POI_BUCKET_LIST      );
+        SimpleLogger().Write(logDEBUG) << "POI_INDEX            " << ": " << GetBlockSize(POI_INDEX            );
     }
 
     template<typename T>
@@ -181,7 +195,8 @@ enum SharedDataType
   LAYOUT_2,
   DATA_2,
   LAYOUT_NONE,
-  DATA_NONE };
+  DATA_NONE,
+  QUERY_COUNTERS };
 
 struct SharedDataTimestamp
 {
@@ -0,0 +1,95 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef SHARED_QUERY_COUNTERS_H
+#define SHARED_QUERY_COUNTERS_H
+
+#include "SharedDataType.h"
+
+#include <boost/assert.hpp>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+// Number of running queries. Every thread counts on its own cache line, so that concurrent
+// queries do not contend for a single counter; only the sum over all shards is meaningful.
+// A zero filled block of memory is a valid counter of value zero, which allows to place it in a
+// freshly created shared memory region.
+class ShardedQueryCounter
+{
+  public:
+    static const unsigned NUMBER_OF_SHARDS = 32;
+    static const unsigned CACHE_LINE_SIZE = 64;
+
+    static unsigned GetShardOfCurrentThread()
+    {
+        return static_cast<unsigned>(std::hash<std::thread::id>()(std::this_thread::get_id()) %
+                                     NUMBER_OF_SHARDS);
+    }
+
+    void Increment(const unsigned shard) { shards[shard].count.fetch_add(1); }
+
+    void Decrement(const unsigned shard) { shards[shard].count.fetch_sub(1); }
+
+    int Sum() const
+    {
+        int sum = 0;
+        for (const Shard &shard : shards)
+        {
+            sum += shard.count.load();
+        }
+        BOOST_ASSERT(0 <= sum);
+        return sum;
+    }
+
+  private:
+    struct Shard
+    {
+        std::atomic<int> count;
+        char padding[CACHE_LINE_SIZE - sizeof(std::atomic<int>)];
+    };
+
+    Shard shards[NUMBER_OF_SHARDS];
+};
+
+// Queries running on each of the two data regions, summed over all osrm-routed processes. Lives
+// in the QUERY_COUNTERS region, so that osrm-datastore can wait for the readers of the previous
+// data before it removes the regions.
+struct SharedQueryCounters
+{
+    ShardedQueryCounter &GetCounter(const SharedDataType data_region)
+    {
+        BOOST_ASSERT(DATA_1 == data_region || DATA_2 == data_region);
+        return per_data_region[DATA_1 == data_region ? 0 : 1];
+    }
+
+    ShardedQueryCounter per_data_region[2];
+};
+
+#endif // SHARED_QUERY_COUNTERS_H
@@ -0,0 +1,112 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef COMPRESSOR_H
+#define COMPRESSOR_H
+
+#include "CompressionType.h"
+#include "../../Util/OSRMException.h"
+
+#include <boost/assert.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace http
+{
+
+// Wraps a zlib deflate stream that is reset instead of reallocated between replies.
+class Compressor
+{
+  public:
+    explicit Compressor(const CompressionType compression_type)
+    {
+        BOOST_ASSERT(noCompression != compression_type);
+        stream.zalloc = Z_NULL;
+        stream.zfree = Z_NULL;
+        stream.opaque = Z_NULL;
+        // negative window bits give a raw deflate stream, adding 16 gives a gzip container
+        const int window_bits = (gzipRFC1952 == compression_type) ? MAX_WBITS + 16 : -MAX_WBITS;
+        // there's a trade-off between speed and size. speed wins
+        if (Z_OK != deflateInit2(&stream,
+                                 Z_BEST_SPEED,
+                                 Z_DEFLATED,
+                                 window_bits,
+                                 8,
+                                 Z_DEFAULT_STRATEGY))
+        {
+            throw OSRMException("could not initialize zlib stream");
+        }
+    }
+
+    Compressor(const Compressor &) = delete;
+
+    ~Compressor() { deflateEnd(&stream); }
+
+    // start a new reply
+    void Reset() { deflateReset(&stream); }
+
+    // upper bound of the compressed size of a whole reply
+    std::size_t Bound(const std::size_t uncompressed_size)
+    {
+        return deflateBound(&stream, static_cast<uLong>(uncompressed_size));
+    }
+
+    // Appends the compressed input to output. The last call of a reply has to finish the
+    // stream, earlier calls may leave data buffered inside zlib.
+    void Compress(const char *begin, const char *end, const bool finish, std::vector<char> &output)
+    {
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(begin));
+        stream.avail_in = static_cast<uInt>(end - begin);
+        int result = Z_OK;
+        do
+        {
+            const std::size_t output_size = output.size();
+            const std::size_t free_space =
+                std::max<std::size_t>(output.capacity() - output_size, MIN_OUTPUT_SPACE);
+            output.resize(output_size + free_space);
+            stream.next_out = reinterpret_cast<Bytef *>(&output[output_size]);
+            stream.avail_out = static_cast<uInt>(free_space);
+            result = deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH);
+            BOOST_ASSERT(Z_STREAM_ERROR != result);
+            output.resize(output_size + free_space - stream.avail_out);
+        } while (Z_STREAM_END != result && (finish || 0 == stream.avail_out));
+        BOOST_ASSERT(0 == stream.avail_in);
+    }
+
+  private:
+    static const std::size_t MIN_OUTPUT_SPACE = 16 * 1024;
+
+    z_stream stream;
+};
+
+} // namespace http
+
+#endif // COMPRESSOR_H
@@ -102,6 +102,10 @@ std::string Reply::ToString(Reply::status_type status)
     {
         return badRequestHTML;
     }
+    if (Reply::serviceUnavailable == status)
+    {
+        return serviceUnavailableHTML;
+    }
     return internalServerErrorHTML;
 }
 
@@ -115,6 +119,10 @@ boost::asio::const_buffer Reply::ToBuffer(Reply::status_type status)
     {
         return boost::asio::buffer(internalServerErrorString);
     }
+    if (Reply::serviceUnavailable == status)
+    {
+        return boost::asio::buffer(serviceUnavailableString);
+    }
     return boost::asio::buffer(badRequestString);
 }
 
@@ -37,10 +37,16 @@ namespace http
 
 struct Request
 {
+    Request() : keep_alive(false), accepts_chunked_encoding(false) {}
+
     std::string uri;
     std::string referrer;
     std::string agent;
     boost::asio::ip::address endpoint;
+    // HTTP/1.1 keeps the connection open unless asked otherwise, HTTP/1.0 only on request
+    bool keep_alive;
+    // only HTTP/1.1 clients understand Transfer-Encoding: chunked
+    bool accepts_chunked_encoding;
 };
 
 } // namespace http
@@ -32,6 +32,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../DataStructures/JSONContainer.h"
 #include "../Library/OSRM.h"
+#include "../Util/make_unique.hpp"
 #include "../Util/simple_logger.hpp"
 #include "../Util/StringUtil.h"
 #include "../typedefs.h"
@@ -44,6 +45,24 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <algorithm>
 #include <iostream>
 
+namespace
+{
+// counts a request against the concurrency limit of its plugin for as long as it runs
+class RunningRequestGuard
+{
+  public:
+    explicit RunningRequestGuard(std::atomic<unsigned> &running_requests)
+        : running_requests(running_requests)
+    {
+    }
+    RunningRequestGuard(const RunningRequestGuard &) = delete;
+    ~RunningRequestGuard() { --running_requests; }
+
+  private:
+    std::atomic<unsigned> &running_requests;
+};
+}
+
 RequestHandler::RequestHandler() : routing_machine(nullptr) {}
 
 void RequestHandler::handle_request(const http::Request &req, http::Reply &reply)
@@ -98,20 +117,64 @@ void RequestHandler::handle_request(const http::Request &req, http::Reply &reply
             return;
         }
 
+        // src= and dst= only have a meaning for distance tables
+        const bool has_source_or_destination_only_locations =
+            std::any_of(route_parameters.is_source.begin(),
+                        route_parameters.is_source.end(),
+                        [](const bool is_source)
+                        { return !is_source; }) ||
+            std::any_of(route_parameters.is_destination.begin(),
+                        route_parameters.is_destination.end(),
+                        [](const bool is_destination)
+                        { return !is_destination; });
+        if ("table" != route_parameters.service && has_source_or_destination_only_locations)
+        {
+            reply = http::Reply::StockReply(http::Reply::badRequest);
+            reply.content.clear();
+            JSON::Object json_result;
+            json_result.values["status"] = 400;
+            json_result.values["status_message"] =
+                "src and dst are only supported by the table service";
+            JSON::render(reply.content, json_result);
+            return;
+        }
+
         // parsing done, lets call the right plugin to handle the request
         BOOST_ASSERT_MSG(routing_machine != nullptr, "pointer not init'ed");
 
-        if (!route_parameters.jsonp_parameter.empty())
+        // keep expensive plugins from occupying all workers
+        std::unique_ptr<RunningRequestGuard> running_request_guard;
+        const auto limit_iterator = plugin_limits.find(route_parameters.service);
+        if (plugin_limits.end() != limit_iterator)
+        {
+            PluginLimit &plugin_limit = *limit_iterator->second;
+            if (plugin_limit.running_requests.fetch_add(1) >= plugin_limit.limit)
+            {
+                --plugin_limit.running_requests;
+                reply = http::Reply::StockReply(http::Reply::serviceUnavailable);
+                return;
+            }
+            running_request_guard =
+                osrm::make_unique<RunningRequestGuard>(plugin_limit.running_requests);
+        }
+
+        // binary tables cannot be wrapped into a jsonp callback
+        const bool binary_table_requested =
+            ("table" == route_parameters.service && "binary" == route_parameters.output_format);
+        if (!route_parameters.jsonp_parameter.empty() && !binary_table_requested)
         { // prepend response with jsonp parameter
             const std::string json_p = (route_parameters.jsonp_parameter + "(");
             reply.content.insert(reply.content.end(), json_p.begin(), json_p.end());
         }
         routing_machine->RunQuery(route_parameters, reply);
-        if (!route_parameters.jsonp_parameter.empty())
+        if (!route_parameters.jsonp_parameter.empty() && !binary_table_requested)
         { // append brace to jsonp response
             reply.content.push_back(')');
         }
 
+        // the table plugin answers errors with a json body
+        const bool binary_output = binary_table_requested && http::Reply::ok == reply.status;
+
         // set headers
         reply.headers.emplace_back("Content-Length", cast::integral_to_string(reply.content.size()));
         if ("gpx" == route_parameters.output_format)
@@ -119,6 +182,11 @@ void RequestHandler::handle_request(const http::Request &req, http::Reply &reply
             reply.headers.emplace_back("Content-Type", "application/gpx+xml; charset=UTF-8");
             reply.headers.emplace_back("Content-Disposition", "attachment; filename=\"route.gpx\"");
         }
+        else if (binary_output)
+        { // raw distance table
+            reply.headers.emplace_back("Content-Type", "application/octet-stream");
+            reply.headers.emplace_back("Content-Disposition", "attachment; filename=\"table.bin\"");
+        }
         else if (route_parameters.jsonp_parameter.empty())
         { // json file
             reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
@@ -140,3 +208,8 @@ void RequestHandler::handle_request(const http::Request &req, http::Reply &reply
 }
 
 void RequestHandler::RegisterRoutingMachine(OSRM *osrm) { routing_machine = osrm; }
+
+void RequestHandler::SetPluginConcurrencyLimit(const std::string &service, const unsigned limit)
+{
+    plugin_limits[service] = osrm::make_unique<PluginLimit>(limit);
+}
@@ -28,7 +28,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef REQUEST_HANDLER_H
 #define REQUEST_HANDLER_H
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <unordered_map>
 
 template <typename Iterator, class HandlerT> struct APIGrammar;
 struct RouteParameters;
@@ -52,8 +55,21 @@ class RequestHandler
     void handle_request(const http::Request &req, http::Reply &rep);
     void RegisterRoutingMachine(OSRM *osrm);
 
+    // at most limit requests of the service run at the same time, others get a 503 reply.
+    // Limits have to be set before the server starts.
+    void SetPluginConcurrencyLimit(const std::string &service, const unsigned limit);
+
   private:
+    struct PluginLimit
+    {
+        explicit PluginLimit(const unsigned limit) : limit(limit), running_requests(0) {}
+
+        const unsigned limit;
+        std::atomic<unsigned> running_requests;
+    };
+
     OSRM *routing_machine;
+    std::unordered_map<std::string, std::unique_ptr<PluginLimit>> plugin_limits;
 };
 
 #endif // REQUEST_HANDLER_H
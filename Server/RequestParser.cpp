@@ -29,12 +29,26 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Http/Request.h"
 
+#include <boost/algorithm/string/predicate.hpp>
+
 namespace http
 {
 
-RequestParser::RequestParser() : state_(method_start), header({"", ""}) {}
+RequestParser::RequestParser()
+    : state_(method_start), header({"", ""}), version_major(0), version_minor(0),
+      connection_close(false), connection_keep_alive(false)
+{
+}
 
-void RequestParser::Reset() { state_ = method_start; }
+void RequestParser::Reset()
+{
+    state_ = method_start;
+    header.Clear();
+    version_major = 0;
+    version_minor = 0;
+    connection_close = false;
+    connection_keep_alive = false;
+}
 
 boost::tuple<boost::tribool, char *>
 RequestParser::Parse(Request &req, char *begin, char *end, http::CompressionType *compression_type)
@@ -132,6 +146,7 @@ RequestParser::consume(Request &req, char input, http::CompressionType *compress
     case http_version_major_start:
         if (isDigit(input))
         {
+            version_major = input - '0';
             state_ = http_version_major;
             return boost::indeterminate;
         }
@@ -144,12 +159,14 @@ RequestParser::consume(Request &req, char input, http::CompressionType *compress
         }
         if (isDigit(input))
         {
+            version_major = 10 * version_major + (input - '0');
             return boost::indeterminate;
         }
         return false;
     case http_version_minor_start:
         if (isDigit(input))
         {
+            version_minor = input - '0';
             state_ = http_version_minor;
             return boost::indeterminate;
         }
@@ -162,6 +179,7 @@ RequestParser::consume(Request &req, char input, http::CompressionType *compress
         }
         if (isDigit(input))
         {
+            version_minor = 10 * version_minor + (input - '0');
             return boost::indeterminate;
         }
         return false;
@@ -196,6 +214,12 @@ RequestParser::consume(Request &req, char input, http::CompressionType *compress
             req.agent = header.value;
         }
 
+        if (boost::algorithm::iequals(header.name, "Connection"))
+        {
+            connection_close = boost::algorithm::icontains(header.value, "close");
+            connection_keep_alive = boost::algorithm::icontains(header.value, "keep-alive");
+        }
+
         if (input == '\r')
         {
             state_ = expecting_newline_3;
@@ -264,7 +288,20 @@ RequestParser::consume(Request &req, char input, http::CompressionType *compress
         }
         return false;
     default: // expecting_newline_3:
-        return (input == '\n');
+        if (input != '\n')
+        {
+            return false;
+        }
+        if (1 < version_major || (1 == version_major && 1 <= version_minor))
+        {
+            req.keep_alive = !connection_close;
+            req.accepts_chunked_encoding = true;
+        }
+        else
+        {
+            req.keep_alive = connection_keep_alive;
+        }
+        return true;
         // default:
         //     return false;
     }
@@ -83,6 +83,10 @@ class RequestParser
       expecting_newline_3 } state_;
 
     Header header;
+    unsigned version_major;
+    unsigned version_minor;
+    bool connection_close;
+    bool connection_keep_alive;
 };
 
 } // namespace http
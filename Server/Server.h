@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "Connection.h"
 #include "RequestHandler.h"
+#include "WorkerPool.h"
 
 #include "../Util/cast.hpp"
 #include "../Util/make_unique.hpp"
@@ -50,17 +51,33 @@ class Server
   public:
 
     // Note: returns a shared instead of a unique ptr as it is captured in a lambda somewhere else
-    static std::shared_ptr<Server> CreateServer(std::string &ip_address, int ip_port, unsigned requested_num_threads)
+    static std::shared_ptr<Server> CreateServer(std::string &ip_address,
+                                                int ip_port,
+                                                unsigned requested_num_io_threads,
+                                                unsigned requested_num_worker_threads,
+                                                unsigned max_queued_requests)
     {
         SimpleLogger().Write() << "http 1.1 compression handled by zlib version " << zlibVersion();
         const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
-        const unsigned real_num_threads = std::min(hardware_threads, requested_num_threads);
-        return std::make_shared<Server>(ip_address, ip_port, real_num_threads);
+        const unsigned real_num_io_threads = std::min(hardware_threads, requested_num_io_threads);
+        const unsigned real_num_worker_threads =
+            std::min(hardware_threads, requested_num_worker_threads);
+        return std::make_shared<Server>(ip_address,
+                                        ip_port,
+                                        real_num_io_threads,
+                                        real_num_worker_threads,
+                                        max_queued_requests);
     }
 
-    explicit Server(const std::string &address, const int port, const unsigned thread_pool_size)
-        : thread_pool_size(thread_pool_size), acceptor(io_service),
-          new_connection(std::make_shared<http::Connection>(io_service, request_handler)), request_handler()
+    Server(const std::string &address,
+           const int port,
+           const unsigned thread_pool_size,
+           const unsigned number_of_workers,
+           const unsigned max_queued_requests)
+        : thread_pool_size(thread_pool_size), acceptor(io_service), request_handler(),
+          worker_pool(number_of_workers, max_queued_requests),
+          new_connection(
+              std::make_shared<http::Connection>(io_service, request_handler, worker_pool))
     {
         const std::string port_string = cast::integral_to_string(port);
 
@@ -102,7 +119,8 @@ class Server
         if (!e)
         {
             new_connection->start();
-            new_connection = std::make_shared<http::Connection>(io_service, request_handler);
+            new_connection =
+                std::make_shared<http::Connection>(io_service, request_handler, worker_pool);
             acceptor.async_accept(
                 new_connection->socket(),
                 boost::bind(&Server::HandleAccept, this, boost::asio::placeholders::error));
@@ -112,8 +130,9 @@ class Server
     unsigned thread_pool_size;
     boost::asio::io_service io_service;
     boost::asio::ip::tcp::acceptor acceptor;
-    std::shared_ptr<http::Connection> new_connection;
     RequestHandler request_handler;
+    WorkerPool worker_pool;
+    std::shared_ptr<http::Connection> new_connection;
 };
 
 #endif // SERVER_H
@@ -0,0 +1,72 @@
+/*
+
+Copyright (c) 2014, Project OSRM, Dennis Luxen, others
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+Redistributions of source code must retain the above copyright notice, this list
+of conditions and the following disclaimer.
+Redistributions in binary form must reproduce the above copyright notice, this
+list of conditions and the following disclaimer in the documentation and/or
+other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <tbb/task_arena.h>
+
+#include <atomic>
+
+// Runs request handling off the asio threads. The tasks go to a work-stealing TBB arena, at most
+// max_queued_tasks of them may wait for a free worker. Beyond that, submission fails and the
+// caller is expected to shed the load.
+class WorkerPool
+{
+  public:
+    WorkerPool(const unsigned number_of_workers, const unsigned max_queued_tasks)
+        : arena(static_cast<int>(number_of_workers), 0),
+          max_pending_tasks(number_of_workers + max_queued_tasks), pending_tasks(0)
+    {
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+
+    // the task must not throw, it runs detached from the caller
+    template <typename TaskT> bool TrySubmit(const TaskT &task)
+    {
+        if (pending_tasks.fetch_add(1) >= max_pending_tasks)
+        {
+            --pending_tasks;
+            return false;
+        }
+        arena.enqueue([this, task]()
+                      {
+            task();
+            --pending_tasks;
+        });
+        return true;
+    }
+
+  private:
+    tbb::task_arena arena;
+    const unsigned max_pending_tasks;
+    std::atomic<unsigned> pending_tasks;
+};
+
+#endif // WORKER_POOL_H
@@ -65,7 +65,9 @@ int main(int argc, const char *argv[])
     try
     {
         std::string ip_address;
-        int ip_port, requested_thread_num;
+        int ip_port, requested_thread_num, max_locations_distance_table, max_results_range_query;
+        int requested_io_thread_num, max_queued_requests;
+        std::unordered_map<std::string, unsigned> plugin_concurrency_limits;
         bool use_shared_memory = false, trial = false;
         ServerPaths server_paths;
         if (!GenerateServerProgramOptions(argc,
@@ -75,14 +77,22 @@ int main(int argc, const char *argv[])
                                           ip_port,
                                           requested_thread_num,
                                           use_shared_memory,
-                                          trial))
+                                          trial,
+                                          max_locations_distance_table,
+                                          max_results_range_query,
+                                          requested_io_thread_num,
+                                          max_queued_requests,
+                                          plugin_concurrency_limits))
         {
             return 0;
         }
 
         SimpleLogger().Write() << "starting up engines, " << g_GIT_DESCRIPTION;
 
-        OSRM routing_machine(server_paths, use_shared_memory);
+        OSRM routing_machine(server_paths,
+                             use_shared_memory,
+                             max_locations_distance_table,
+                             max_results_range_query);
 
         RouteParameters route_parameters;
         route_parameters.zoom_level = 18;           // no generalization
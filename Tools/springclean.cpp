@@ -52,6 +52,8 @@ void delete_region(const SharedDataType region)
                 return "DATA_2";
             case LAYOUT_NONE:
                 return "LAYOUT_NONE";
+            case QUERY_COUNTERS:
+                return "QUERY_COUNTERS";
             default: // DATA_NONE:
                 return "DATA_NONE";
             }
@@ -70,6 +72,7 @@ void springclean()
     delete_region(DATA_2);
     delete_region(LAYOUT_2);
     delete_region(CURRENT_REGIONS);
+    delete_region(QUERY_COUNTERS);
 }
 
 int main()
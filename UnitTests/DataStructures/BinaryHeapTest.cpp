@@ -1,10 +1,13 @@
 #include "../../DataStructures/BinaryHeap.h"
+#include "../../DataStructures/DAryHeap.h"
+#include "../../DataStructures/RadixHeap.h"
 #include "../../typedefs.h"
 
 #include <boost/test/unit_test.hpp>
 #include <boost/test/test_case_template.hpp>
 #include <boost/mpl/list.hpp>
 
+#include <queue>
 #include <random>
 
 BOOST_AUTO_TEST_SUITE(binary_heap)
@@ -18,6 +21,7 @@ typedef NodeID TestNodeID;
 typedef int TestKey;
 typedef int TestWeight;
 typedef boost::mpl::list<ArrayStorage<TestNodeID, TestKey>,
+                         TimestampedArrayStorage<TestNodeID, TestKey>,
                          MapStorage<TestNodeID, TestKey>,
                          UnorderedMapStorage<TestNodeID, TestKey>> storage_types;
 
@@ -116,6 +120,33 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(delete_all_test, T, storage_types, RandomDataFi
     BOOST_CHECK(heap.Empty());
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(clear_test, T, storage_types, RandomDataFixture<NUM_NODES>)
+{
+    BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(NUM_NODES);
+
+    for (unsigned idx : order)
+    {
+        heap.Insert(ids[idx], weights[idx], data[idx]);
+    }
+
+    heap.Clear();
+    BOOST_CHECK(heap.Empty());
+
+    // only the nodes inserted after the last clear are known to the heap
+    for (unsigned i = 0; i < NUM_NODES / 2; ++i)
+    {
+        heap.Insert(ids[order[i]], weights[order[i]], data[order[i]]);
+    }
+    for (unsigned i = 0; i < NUM_NODES; ++i)
+    {
+        BOOST_CHECK_EQUAL(heap.WasInserted(ids[order[i]]), i < NUM_NODES / 2);
+    }
+    for (unsigned i = 0; i < NUM_NODES / 2; ++i)
+    {
+        BOOST_CHECK_EQUAL(heap.GetKey(ids[order[i]]), weights[order[i]]);
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE_TEMPLATE(decrease_key_test, T, storage_types, RandomDataFixture<10>)
 {
     BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(10);
@@ -148,4 +179,110 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(decrease_key_test, T, storage_types, RandomData
     }
 }
 
+typedef boost::mpl::list<
+    BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, ArrayStorage<TestNodeID, TestKey>>,
+    DAryHeap<TestNodeID, TestKey, TestWeight, TestData, ArrayStorage<TestNodeID, TestKey>>,
+    DAryHeap<TestNodeID, TestKey, TestWeight, TestData, ArrayStorage<TestNodeID, TestKey>, 8>,
+    RadixHeap<TestNodeID, TestKey, TestWeight, TestData, ArrayStorage<TestNodeID, TestKey>>>
+    heap_types;
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(heap_sort_test, T, heap_types)
+{
+    constexpr unsigned NUM_ELEM = 1000;
+    std::mt19937 g(15);
+    std::uniform_int_distribution<TestWeight> weight_dist(-1000, 1000);
+
+    T heap(NUM_ELEM);
+    std::vector<TestWeight> weights;
+    for (unsigned i = 0; i < NUM_ELEM; ++i)
+    {
+        weights.push_back(weight_dist(g));
+        heap.Insert(i, weights.back(), TestData{i});
+    }
+    BOOST_CHECK_EQUAL(heap.Size(), NUM_ELEM);
+
+    TestWeight last_weight = std::numeric_limits<TestWeight>::min();
+    while (!heap.Empty())
+    {
+        const TestWeight min_weight = heap.MinKey();
+        const TestNodeID node = heap.DeleteMin();
+        BOOST_CHECK_EQUAL(weights[node], min_weight);
+        BOOST_CHECK_LE(last_weight, min_weight);
+        BOOST_CHECK(heap.WasRemoved(node));
+        last_weight = min_weight;
+    }
+}
+
+// runs a dijkstra on a random graph and compares it against a lazy reference implementation
+BOOST_AUTO_TEST_CASE_TEMPLATE(dijkstra_test, T, heap_types)
+{
+    constexpr unsigned NUM_ELEM = 1000;
+    constexpr unsigned NUM_EDGES = 5000;
+    std::mt19937 g(15);
+    std::uniform_int_distribution<TestNodeID> node_dist(0, NUM_ELEM - 1);
+    std::uniform_int_distribution<TestWeight> weight_dist(1, 100);
+
+    std::vector<std::vector<std::pair<TestNodeID, TestWeight>>> adjacency(NUM_ELEM);
+    for (unsigned i = 0; i < NUM_EDGES; ++i)
+    {
+        adjacency[node_dist(g)].emplace_back(node_dist(g), weight_dist(g));
+    }
+
+    std::vector<TestWeight> reference(NUM_ELEM, std::numeric_limits<TestWeight>::max());
+    using QueueEntry = std::pair<TestWeight, TestNodeID>;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+    reference[0] = 0;
+    queue.emplace(0, 0);
+    while (!queue.empty())
+    {
+        const QueueEntry entry = queue.top();
+        queue.pop();
+        if (entry.first > reference[entry.second])
+        {
+            continue;
+        }
+        for (const auto &edge : adjacency[entry.second])
+        {
+            if (entry.first + edge.second < reference[edge.first])
+            {
+                reference[edge.first] = entry.first + edge.second;
+                queue.emplace(reference[edge.first], edge.first);
+            }
+        }
+    }
+
+    T heap(NUM_ELEM);
+    // searches reuse their heaps, so run on a heap that has seen a previous search
+    heap.Insert(1, 0, TestData{0});
+    heap.DeleteMin();
+    heap.Clear();
+
+    heap.Insert(0, 0, TestData{0});
+    while (!heap.Empty())
+    {
+        const TestNodeID node = heap.DeleteMin();
+        const TestWeight distance = heap.GetKey(node);
+        BOOST_CHECK_EQUAL(distance, reference[node]);
+        for (const auto &edge : adjacency[node])
+        {
+            const TestWeight to_distance = distance + edge.second;
+            if (!heap.WasInserted(edge.first))
+            {
+                heap.Insert(edge.first, to_distance, TestData{node});
+            }
+            else if (to_distance < heap.GetKey(edge.first))
+            {
+                heap.GetData(edge.first).value = node;
+                heap.DecreaseKey(edge.first, to_distance);
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < NUM_ELEM; ++i)
+    {
+        BOOST_CHECK_EQUAL(heap.WasInserted(i),
+                          reference[i] != std::numeric_limits<TestWeight>::max());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
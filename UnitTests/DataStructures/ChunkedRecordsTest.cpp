@@ -0,0 +1,166 @@
+#include "../../DataStructures/ChunkedRecords.h"
+#include "../../Util/OSRMException.h"
+#include "../../typedefs.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <sstream>
+
+BOOST_AUTO_TEST_SUITE(chunked_records_test)
+
+using namespace chunked_records;
+
+BOOST_AUTO_TEST_CASE(node_round_trip_test)
+{
+    std::mt19937 g(7);
+    std::vector<ExternalMemoryNode> nodes;
+    NodeID node_id = 0;
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+        node_id += 1 + g() % 100;
+        nodes.emplace_back(static_cast<int>(g() % 180000000) - 90000000,
+                           static_cast<int>(g() % 360000000) - 180000000,
+                           node_id,
+                           0 == g() % 3,
+                           0 == g() % 5,
+                           0 == g() % 7);
+    }
+    nodes.emplace_back(std::numeric_limits<int>::min(),
+                       std::numeric_limits<int>::max(),
+                       std::numeric_limits<NodeID>::max(),
+                       true,
+                       true,
+                       true);
+
+    // two chunks, the second one starts its deltas from scratch
+    std::stringstream stream;
+    NodeChunkEncoder encoder;
+    for (unsigned i = 0; i < nodes.size(); ++i)
+    {
+        encoder.Append(nodes[i]);
+        if (i == 499 || i + 1 == nodes.size())
+        {
+            encoder.Write(stream);
+            encoder.clear();
+        }
+    }
+    BOOST_CHECK(encoder.empty());
+
+    std::vector<ExternalMemoryNode> decoded_nodes, chunk_nodes;
+    Chunk chunk;
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        ReadChunk(stream, chunk);
+        DecodeNodes(chunk, chunk_nodes);
+        decoded_nodes.insert(decoded_nodes.end(), chunk_nodes.begin(), chunk_nodes.end());
+    }
+
+    BOOST_REQUIRE_EQUAL(decoded_nodes.size(), nodes.size());
+    for (unsigned i = 0; i < nodes.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(decoded_nodes[i].node_id, nodes[i].node_id);
+        BOOST_CHECK_EQUAL(decoded_nodes[i].lat, nodes[i].lat);
+        BOOST_CHECK_EQUAL(decoded_nodes[i].lon, nodes[i].lon);
+        BOOST_CHECK_EQUAL(decoded_nodes[i].bollard, nodes[i].bollard);
+        BOOST_CHECK_EQUAL(decoded_nodes[i].trafficLight, nodes[i].trafficLight);
+        BOOST_CHECK_EQUAL(decoded_nodes[i].poi, nodes[i].poi);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(edge_round_trip_test)
+{
+    std::mt19937 g(11);
+    std::vector<ExtractedEdge> edges(1000);
+    NodeID target = 0;
+    for (ExtractedEdge &edge : edges)
+    {
+        target += g() % 4;
+        edge.source = g();
+        edge.target = target;
+        edge.length = 1 + g() % 100000;
+        edge.direction = static_cast<short>(g() % 3);
+        edge.weight = 1 + g() % 100000;
+        edge.name_id = g();
+        edge.is_roundabout = 0 == g() % 2;
+        edge.is_in_tiny_cc = 0 == g() % 3;
+        edge.is_access_restricted = 0 == g() % 5;
+        edge.travel_mode = static_cast<TravelMode>(g() % 16);
+        edge.is_split = 0 == g() % 7;
+    }
+
+    std::stringstream stream;
+    EdgeChunkEncoder encoder;
+    for (const ExtractedEdge &edge : edges)
+    {
+        encoder.Append(edge);
+    }
+    encoder.Write(stream);
+
+    Chunk chunk;
+    std::vector<ExtractedEdge> decoded_edges;
+    ReadChunk(stream, chunk);
+    DecodeEdges(chunk, decoded_edges);
+
+    BOOST_REQUIRE_EQUAL(decoded_edges.size(), edges.size());
+    for (unsigned i = 0; i < edges.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(decoded_edges[i].source, edges[i].source);
+        BOOST_CHECK_EQUAL(decoded_edges[i].target, edges[i].target);
+        BOOST_CHECK_EQUAL(decoded_edges[i].length, edges[i].length);
+        BOOST_CHECK_EQUAL(decoded_edges[i].direction, edges[i].direction);
+        BOOST_CHECK_EQUAL(decoded_edges[i].weight, edges[i].weight);
+        BOOST_CHECK_EQUAL(decoded_edges[i].name_id, edges[i].name_id);
+        BOOST_CHECK_EQUAL(decoded_edges[i].is_roundabout, edges[i].is_roundabout);
+        BOOST_CHECK_EQUAL(decoded_edges[i].is_in_tiny_cc, edges[i].is_in_tiny_cc);
+        BOOST_CHECK_EQUAL(decoded_edges[i].is_access_restricted, edges[i].is_access_restricted);
+        BOOST_CHECK_EQUAL(decoded_edges[i].travel_mode, edges[i].travel_mode);
+        BOOST_CHECK_EQUAL(decoded_edges[i].is_split, edges[i].is_split);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(corruption_test)
+{
+    NodeChunkEncoder encoder;
+    for (unsigned i = 0; i < 100; ++i)
+    {
+        encoder.Append(ExternalMemoryNode(i * 10, i * 20, i * 3, false, false, false));
+    }
+    std::stringstream stream;
+    encoder.Write(stream);
+    const std::string data = stream.str();
+
+    // flipped payload byte
+    std::string corrupted = data;
+    corrupted[corrupted.size() / 2] ^= 0x10;
+    std::stringstream corrupted_stream(corrupted);
+    Chunk chunk;
+    std::vector<ExternalMemoryNode> nodes;
+    ReadChunk(corrupted_stream, chunk);
+    BOOST_CHECK_THROW(DecodeNodes(chunk, nodes), OSRMException);
+
+    // truncated payload
+    std::stringstream truncated_stream(data.substr(0, data.size() - 1));
+    BOOST_CHECK_THROW(ReadChunk(truncated_stream, chunk), OSRMException);
+}
+
+BOOST_AUTO_TEST_CASE(format_header_test)
+{
+    std::stringstream stream;
+    WriteFormatHeader(stream);
+    BOOST_CHECK_NO_THROW(ReadFormatHeader(stream));
+
+    // files of the raw struct format start with the node count
+    std::stringstream old_format_stream;
+    const unsigned number_of_nodes = 1000;
+    old_format_stream.write((char *)&number_of_nodes, sizeof(unsigned));
+    old_format_stream.write((char *)&number_of_nodes, sizeof(unsigned));
+    BOOST_CHECK_THROW(ReadFormatHeader(old_format_stream), OSRMException);
+
+    std::string newer_version = stream.str();
+    newer_version[sizeof(FORMAT_MAGIC)] += 1;
+    std::stringstream newer_version_stream(newer_version);
+    BOOST_CHECK_THROW(ReadFormatHeader(newer_version_stream), OSRMException);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,112 @@
+#include "../../DataStructures/PhantomNodes.h"
+#include "../../DataStructures/QueryEdge.h"
+#include "../../DataStructures/SearchEngineData.h"
+#include "../../DataStructures/StaticGraph.h"
+#include "../../RoutingAlgorithms/ManyToManyRouting.h"
+#include "../../typedefs.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(many_to_many_routing)
+
+typedef StaticGraph<QueryEdge::EdgeData> TestQueryGraph;
+
+// the facade calls of the many-to-many search, answered by a plain query graph
+class TestDataFacade
+{
+  public:
+    typedef QueryEdge::EdgeData EdgeData;
+
+    explicit TestDataFacade(const unsigned number_of_nodes)
+    {
+        // a path 0 - 1 - ... - n-1 of unit edges, contracted in node order, so every edge
+        // points upwards from its lower node and no shortcuts exist
+        std::vector<TestQueryGraph::InputEdge> edges;
+        for (NodeID node = 0; node + 1 < number_of_nodes; ++node)
+        {
+            EdgeData data;
+            data.id = node;
+            data.distance = 1;
+            data.forward = true;
+            data.backward = true;
+            edges.emplace_back(node, node + 1, data);
+        }
+        graph = std::make_shared<TestQueryGraph>(number_of_nodes, edges);
+    }
+
+    unsigned GetNumberOfNodes() const { return graph->GetNumberOfNodes(); }
+
+    TestQueryGraph::EdgeRange GetAdjacentEdgeRange(const NodeID node) const
+    {
+        return graph->GetAdjacentEdgeRange(node);
+    }
+
+    const EdgeData &GetEdgeData(const EdgeID edge) const { return graph->GetEdgeData(edge); }
+
+    NodeID GetTarget(const EdgeID edge) const { return graph->GetTarget(edge); }
+
+  private:
+    std::shared_ptr<TestQueryGraph> graph;
+};
+
+constexpr unsigned TEST_NUM_NODES = 64;
+
+PhantomNodeArray MakePhantomNodes(const unsigned number_of_locations)
+{
+    PhantomNodeArray phantom_nodes_array(number_of_locations);
+    for (unsigned i = 0; i < number_of_locations; ++i)
+    {
+        PhantomNode phantom_node;
+        phantom_node.forward_node_id = (i * 7) % TEST_NUM_NODES;
+        phantom_node.forward_weight = 0;
+        phantom_nodes_array[i].push_back(phantom_node);
+    }
+    return phantom_nodes_array;
+}
+
+void CheckTable(const unsigned number_of_sources, const unsigned number_of_targets)
+{
+    TestDataFacade facade(TEST_NUM_NODES);
+    SearchEngineData engine_working_data;
+    ManyToManyRouting<TestDataFacade> many_to_many(&facade, engine_working_data);
+
+    const PhantomNodeArray source_phantoms_array = MakePhantomNodes(number_of_sources);
+    const PhantomNodeArray target_phantoms_array = MakePhantomNodes(number_of_targets);
+    const std::shared_ptr<std::vector<EdgeWeight>> result_table =
+        many_to_many(source_phantoms_array, target_phantoms_array);
+
+    BOOST_REQUIRE(result_table);
+    BOOST_REQUIRE_EQUAL(result_table->size(),
+                        static_cast<std::size_t>(number_of_sources) * number_of_targets);
+    for (unsigned source_id = 0; source_id < number_of_sources; ++source_id)
+    {
+        const int source_node = source_phantoms_array[source_id].front().forward_node_id;
+        for (unsigned target_id = 0; target_id < number_of_targets; ++target_id)
+        {
+            const int target_node = target_phantoms_array[target_id].front().forward_node_id;
+            const EdgeWeight distance =
+                (*result_table)[static_cast<std::size_t>(source_id) * number_of_targets +
+                                target_id];
+            if (std::abs(source_node - target_node) != distance)
+            {
+                BOOST_ERROR("wrong distance from source " << source_id << " to target "
+                                                          << target_id << ": " << distance);
+                return;
+            }
+        }
+    }
+}
+
+// a table of 100 x 100 locations is what --max-table-size=100 allows, these use up that
+// budget with very different numbers of rows and columns
+BOOST_AUTO_TEST_CASE(single_source_test) { CheckTable(1, 10000); }
+
+BOOST_AUTO_TEST_CASE(single_target_test) { CheckTable(10000, 1); }
+
+BOOST_AUTO_TEST_CASE(asymmetric_test) { CheckTable(7, 1428); }
+
+BOOST_AUTO_TEST_SUITE_END()
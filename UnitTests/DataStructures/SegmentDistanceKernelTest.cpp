@@ -0,0 +1,174 @@
+#include "../../DataStructures/SegmentDistanceKernel.h"
+
+#include <osrm/Coordinate.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(segment_distance_kernel)
+
+constexpr unsigned RANDOM_SEED = 42;
+// not a multiple of any lane width, so the scalar tail is exercised as well
+constexpr uint32_t NUM_SEGMENTS = 1003;
+
+struct SegmentArrays
+{
+    explicit SegmentArrays(const int32_t lat_range, const int32_t lon_range)
+    {
+        std::mt19937 g(RANDOM_SEED);
+        std::uniform_int_distribution<int32_t> lat_udist(-lat_range, lat_range);
+        std::uniform_int_distribution<int32_t> lon_udist(-lon_range, lon_range);
+        for (uint32_t i = 0; i < NUM_SEGMENTS; ++i)
+        {
+            u_lats.push_back(lat_udist(g));
+            u_lons.push_back(lon_udist(g));
+            v_lats.push_back(lat_udist(g));
+            v_lons.push_back(lon_udist(g));
+        }
+    }
+
+    std::vector<int32_t> u_lats, u_lons, v_lats, v_lons;
+};
+
+BOOST_AUTO_TEST_CASE(vector_matches_scalar_test)
+{
+    const SegmentArrays segments(90 * COORDINATE_PRECISION, 180 * COORDINATE_PRECISION);
+    const FixedPointCoordinate query(12345678, -98765432);
+    const float lon_scale = osrm::LongitudeScaleAt(query.lat);
+
+    std::vector<float> batch(NUM_SEGMENTS), reference(NUM_SEGMENTS);
+    osrm::ComputeSquaredSegmentDistances(query,
+                                         lon_scale,
+                                         segments.u_lats.data(),
+                                         segments.u_lons.data(),
+                                         segments.v_lats.data(),
+                                         segments.v_lons.data(),
+                                         NUM_SEGMENTS,
+                                         batch.data());
+    osrm::ComputeSquaredSegmentDistancesScalar(query,
+                                               lon_scale,
+                                               segments.u_lats.data(),
+                                               segments.u_lons.data(),
+                                               segments.v_lats.data(),
+                                               segments.v_lons.data(),
+                                               0,
+                                               NUM_SEGMENTS,
+                                               reference.data());
+
+    for (uint32_t i = 0; i < NUM_SEGMENTS; ++i)
+    {
+        BOOST_CHECK_CLOSE(batch[i], reference[i], 0.01);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(end_point_lower_bound_test)
+{
+    const SegmentArrays points(90 * COORDINATE_PRECISION, 180 * COORDINATE_PRECISION);
+    const FixedPointCoordinate query(-45000000, 7000000);
+    int max_abs_lat = std::abs(query.lat);
+    for (const int32_t lat : points.u_lats)
+    {
+        max_abs_lat = std::max(max_abs_lat, std::abs(lat));
+    }
+
+    std::vector<float> squared_distances(NUM_SEGMENTS);
+    osrm::ComputeSquaredSegmentDistances(query,
+                                         osrm::LongitudeScaleAt(max_abs_lat),
+                                         points.u_lats.data(),
+                                         points.u_lons.data(),
+                                         points.u_lats.data(),
+                                         points.u_lons.data(),
+                                         NUM_SEGMENTS,
+                                         squared_distances.data());
+
+    for (uint32_t i = 0; i < NUM_SEGMENTS; ++i)
+    {
+        const float lower_bound =
+            std::sqrt(squared_distances[i]) * osrm::FIXED_POINT_UNIT_IN_METERS;
+        const float exact = FixedPointCoordinate::ApproximateEuclideanDistance(
+            query.lat, query.lon, points.u_lats[i], points.u_lons[i]);
+        BOOST_CHECK_LE(lower_bound * 0.999f, exact);
+    }
+}
+
+// scaled at the highest latitude the kernel stays below the reference distance up to the slack,
+// which the r-tree relies on to prune segments without computing the reference
+BOOST_AUTO_TEST_CASE(segment_lower_bound_test)
+{
+    const SegmentArrays segments(10000, 10000);
+    for (const int base_lat : {0, 45000000, -70000000, 80000000})
+    {
+        const FixedPointCoordinate query(base_lat + 600, -400);
+        std::vector<int32_t> u_lats(segments.u_lats), v_lats(segments.v_lats);
+        int max_abs_lat = std::abs(query.lat);
+        for (uint32_t i = 0; i < NUM_SEGMENTS; ++i)
+        {
+            u_lats[i] += base_lat;
+            v_lats[i] += base_lat;
+            max_abs_lat = std::max(max_abs_lat, std::max(std::abs(u_lats[i]), std::abs(v_lats[i])));
+        }
+
+        std::vector<float> squared_distances(NUM_SEGMENTS);
+        osrm::ComputeSquaredSegmentDistances(query,
+                                             osrm::LongitudeScaleAt(max_abs_lat),
+                                             u_lats.data(),
+                                             segments.u_lons.data(),
+                                             v_lats.data(),
+                                             segments.v_lons.data(),
+                                             NUM_SEGMENTS,
+                                             squared_distances.data());
+
+        for (uint32_t i = 0; i < NUM_SEGMENTS; ++i)
+        {
+            const float lower_bound =
+                std::sqrt(squared_distances[i]) * osrm::FIXED_POINT_UNIT_IN_METERS;
+            float ratio = 0.;
+            FixedPointCoordinate foot_point;
+            const float reference = FixedPointCoordinate::ComputePerpendicularDistance(
+                FixedPointCoordinate(u_lats[i], segments.u_lons[i]),
+                FixedPointCoordinate(v_lats[i], segments.v_lons[i]),
+                query,
+                foot_point,
+                ratio);
+            BOOST_CHECK_LE(lower_bound * 0.999f,
+                           reference + osrm::SEGMENT_LOWER_BOUND_SLACK_IN_METERS);
+        }
+    }
+}
+
+// on short segments the local projection agrees with the reference implementation
+BOOST_AUTO_TEST_CASE(reference_distance_test)
+{
+    const FixedPointCoordinate query(52520000, 13405000);
+    const std::vector<int32_t> u_lats = {52519000, 52521000, 52515000, 52520500};
+    const std::vector<int32_t> u_lons = {13400000, 13401000, 13410000, 13406000};
+    const std::vector<int32_t> v_lats = {52519500, 52522000, 52518000, 52520500};
+    const std::vector<int32_t> v_lons = {13410000, 13409000, 13415000, 13407000};
+
+    std::vector<float> squared_distances(u_lats.size());
+    osrm::ComputeSquaredSegmentDistances(query,
+                                         osrm::LongitudeScaleAt(query.lat),
+                                         u_lats.data(),
+                                         u_lons.data(),
+                                         v_lats.data(),
+                                         v_lons.data(),
+                                         u_lats.size(),
+                                         squared_distances.data());
+
+    for (uint32_t i = 0; i < u_lats.size(); ++i)
+    {
+        const float distance = std::sqrt(squared_distances[i]) * osrm::FIXED_POINT_UNIT_IN_METERS;
+        const float reference = FixedPointCoordinate::ComputePerpendicularDistance(
+            FixedPointCoordinate(u_lats[i], u_lons[i]),
+            FixedPointCoordinate(v_lats[i], v_lons[i]),
+            query);
+        BOOST_CHECK_CLOSE(distance, reference, 2.);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,169 @@
+#include "../../DataStructures/StaticPoiIndex.h"
+#include "../../typedefs.h"
+
+#include <osrm/Coordinate.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(static_poi_index)
+
+constexpr unsigned TEST_BRANCHING_FACTOR = 4;
+typedef StaticPoiIndex<false, TEST_BRANCHING_FACTOR> TestStaticPoiIndex;
+
+// Choosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 13;
+// a city sized area, large enough to span several levels of the index
+static const int32_t TEST_MIN_LAT = 52.4 * COORDINATE_PRECISION;
+static const int32_t TEST_MAX_LAT = 52.6 * COORDINATE_PRECISION;
+static const int32_t TEST_MIN_LON = 13.2 * COORDINATE_PRECISION;
+static const int32_t TEST_MAX_LON = 13.6 * COORDINATE_PRECISION;
+
+struct RandomPoiFixture
+{
+    RandomPoiFixture(const unsigned number_of_pois, const unsigned number_of_queries)
+    {
+        std::mt19937 g(RANDOM_SEED);
+        std::uniform_int_distribution<> lat_udist(TEST_MIN_LAT, TEST_MAX_LAT);
+        std::uniform_int_distribution<> lon_udist(TEST_MIN_LON, TEST_MAX_LON);
+
+        std::vector<FixedPointCoordinate> locations;
+        for (unsigned i = 0; i < number_of_pois; ++i)
+        {
+            locations.emplace_back(lat_udist(g), lon_udist(g));
+        }
+        for (const unsigned i : TestStaticPoiIndex::HilbertOrder(locations))
+        {
+            poi_list.emplace_back(locations[i], i);
+        }
+        for (unsigned i = 0; i < number_of_queries; ++i)
+        {
+            queries.emplace_back(lat_udist(g), lon_udist(g));
+        }
+        TestStaticPoiIndex::Build(poi_list, box_list);
+    }
+
+    std::vector<PoiInfo> poi_list;
+    std::vector<PoiBoundingBox> box_list;
+    std::vector<FixedPointCoordinate> queries;
+};
+
+BOOST_AUTO_TEST_CASE(pois_in_radius_match_linear_search)
+{
+    const float radius = 1500.;
+    const RandomPoiFixture fixture(1000, 100);
+    const TestStaticPoiIndex index(fixture.poi_list, fixture.box_list);
+
+    for (const FixedPointCoordinate &query : fixture.queries)
+    {
+        std::vector<unsigned> result_poi_ids;
+        index.PoisInRadius(query, radius, result_poi_ids);
+
+        std::vector<unsigned> expected_poi_ids;
+        for (unsigned poi_id = 0; poi_id < fixture.poi_list.size(); ++poi_id)
+        {
+            if (FixedPointCoordinate::ApproximateEuclideanDistance(
+                    query, fixture.poi_list[poi_id].location) <= radius)
+            {
+                expected_poi_ids.push_back(poi_id);
+            }
+        }
+        BOOST_CHECK_EQUAL_COLLECTIONS(result_poi_ids.begin(),
+                                      result_poi_ids.end(),
+                                      expected_poi_ids.begin(),
+                                      expected_poi_ids.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pois_in_rectangle_match_linear_search)
+{
+    const int32_t half_extent = 0.02 * COORDINATE_PRECISION;
+    const RandomPoiFixture fixture(1000, 100);
+    const TestStaticPoiIndex index(fixture.poi_list, fixture.box_list);
+
+    for (const FixedPointCoordinate &query : fixture.queries)
+    {
+        PoiBoundingBox search_box;
+        search_box.Extend(FixedPointCoordinate(query.lat - half_extent, query.lon - half_extent));
+        search_box.Extend(
+            FixedPointCoordinate(query.lat + half_extent, query.lon + 2 * half_extent));
+        std::vector<unsigned> result_poi_ids;
+        index.PoisInRectangle(search_box, result_poi_ids);
+
+        std::vector<unsigned> expected_poi_ids;
+        for (unsigned poi_id = 0; poi_id < fixture.poi_list.size(); ++poi_id)
+        {
+            if (search_box.Contains(fixture.poi_list[poi_id].location))
+            {
+                expected_poi_ids.push_back(poi_id);
+            }
+        }
+        BOOST_CHECK_EQUAL_COLLECTIONS(result_poi_ids.begin(),
+                                      result_poi_ids.end(),
+                                      expected_poi_ids.begin(),
+                                      expected_poi_ids.end());
+    }
+}
+
+// a callback returning false ends the traversal, the pois seen up to then come first in id order
+BOOST_AUTO_TEST_CASE(stopped_range_queries)
+{
+    const unsigned max_results = 5;
+    const RandomPoiFixture fixture(1000, 1);
+    const TestStaticPoiIndex index(fixture.poi_list, fixture.box_list);
+    const FixedPointCoordinate &query = fixture.queries.front();
+    PoiBoundingBox search_box;
+    search_box.Extend(FixedPointCoordinate(TEST_MIN_LAT, TEST_MIN_LON));
+    search_box.Extend(FixedPointCoordinate(TEST_MAX_LAT, TEST_MAX_LON));
+
+    std::vector<unsigned> result_poi_ids;
+    const auto collect_up_to_max = [&result_poi_ids, max_results](const unsigned poi_id)
+    {
+        if (result_poi_ids.size() == max_results)
+        {
+            return false;
+        }
+        result_poi_ids.push_back(poi_id);
+        return true;
+    };
+    const std::vector<unsigned> expected_poi_ids = {0, 1, 2, 3, 4};
+
+    BOOST_CHECK(!index.ForEachPoiInRadius(query, 100000., collect_up_to_max));
+    BOOST_CHECK_EQUAL_COLLECTIONS(result_poi_ids.begin(),
+                                  result_poi_ids.end(),
+                                  expected_poi_ids.begin(),
+                                  expected_poi_ids.end());
+
+    result_poi_ids.clear();
+    BOOST_CHECK(!index.ForEachPoiInRectangle(search_box, collect_up_to_max));
+    BOOST_CHECK_EQUAL_COLLECTIONS(result_poi_ids.begin(),
+                                  result_poi_ids.end(),
+                                  expected_poi_ids.begin(),
+                                  expected_poi_ids.end());
+
+    // a query with fewer results than the callback accepts runs to completion
+    result_poi_ids.clear();
+    BOOST_CHECK(index.ForEachPoiInRadius(query, 0., collect_up_to_max));
+    BOOST_CHECK(result_poi_ids.size() < max_results);
+}
+
+BOOST_AUTO_TEST_CASE(empty_and_single_poi)
+{
+    std::vector<unsigned> result_poi_ids;
+    const FixedPointCoordinate query(TEST_MIN_LAT, TEST_MIN_LON);
+
+    const RandomPoiFixture empty_fixture(0, 0);
+    const TestStaticPoiIndex empty_index(empty_fixture.poi_list, empty_fixture.box_list);
+    empty_index.PoisInRadius(query, 1000., result_poi_ids);
+    BOOST_CHECK(result_poi_ids.empty());
+
+    const RandomPoiFixture single_fixture(1, 0);
+    const TestStaticPoiIndex single_index(single_fixture.poi_list, single_fixture.box_list);
+    single_index.PoisInRadius(query, 100000., result_poi_ids);
+    BOOST_REQUIRE_EQUAL(result_poi_ids.size(), 1u);
+    BOOST_CHECK_EQUAL(result_poi_ids.front(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
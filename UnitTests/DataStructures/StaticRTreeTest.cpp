@@ -300,6 +300,13 @@ void sampling_verify_rtree(RTreeT &rtree, LinearSearchNN &lsnn, unsigned num_sam
         PhantomNode phantom_ln;
         lsnn.FindPhantomNodeForCoordinate(q, phantom_ln, 1);
         BOOST_CHECK_EQUAL(phantom_rtree, phantom_ln);
+
+        // without a limit on the inspected segments the incremental search is exact as well
+        std::vector<PhantomNode> incremental_rtree;
+        rtree.IncrementalFindPhantomNodeForCoordinate(
+            q, incremental_rtree, 1, 1, std::numeric_limits<unsigned>::max());
+        BOOST_REQUIRE(!incremental_rtree.empty());
+        BOOST_CHECK_EQUAL(incremental_rtree.front().location, phantom_ln.location);
     }
 }
 
@@ -307,7 +314,8 @@ template <typename FixtureT, typename RTreeT = TestStaticRTree>
 void build_rtree(const std::string &prefix,
                  FixtureT *fixture,
                  std::string &leaves_path,
-                 std::string &nodes_path)
+                 std::string &nodes_path,
+                 const uint32_t leaf_node_size = TEST_LEAF_NODE_SIZE)
 {
     nodes_path = prefix + ".ramIndex";
     leaves_path = prefix + ".fileIndex";
@@ -319,15 +327,17 @@ void build_rtree(const std::string &prefix,
     node_stream.write((char *)&(fixture->nodes[0]), num_nodes * sizeof(NodeInfo));
     node_stream.close();
 
-    RTreeT r(fixture->edges, nodes_path, leaves_path, fixture->nodes);
+    RTreeT r(fixture->edges, nodes_path, leaves_path, fixture->nodes, leaf_node_size);
 }
 
 template <typename FixtureT, typename RTreeT = TestStaticRTree>
-void construction_test(const std::string &prefix, FixtureT *fixture)
+void construction_test(const std::string &prefix,
+                       FixtureT *fixture,
+                       const uint32_t leaf_node_size = TEST_LEAF_NODE_SIZE)
 {
     std::string leaves_path;
     std::string nodes_path;
-    build_rtree<FixtureT, RTreeT>(prefix, fixture, leaves_path, nodes_path);
+    build_rtree<FixtureT, RTreeT>(prefix, fixture, leaves_path, nodes_path, leaf_node_size);
     RTreeT rtree(nodes_path, leaves_path, fixture->coords);
     LinearSearchNN lsnn(fixture->coords, fixture->edges);
 
@@ -360,6 +370,167 @@ BOOST_FIXTURE_TEST_CASE(construct_multiple_levels_test, TestRandomGraphFixture_M
     construction_test("test_5", this);
 }
 
+// batches are large enough to be spread over threads and must match the single lookups
+BOOST_FIXTURE_TEST_CASE(batch_lookup_test, TestRandomGraphFixture_Branch)
+{
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree<TestRandomGraphFixture_Branch>("test_batch", this, leaves_path, nodes_path);
+    TestStaticRTree rtree(nodes_path, leaves_path, coords);
+
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_int_distribution<> lat_udist(WORLD_MIN_LAT, WORLD_MAX_LAT);
+    std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+    std::vector<FixedPointCoordinate> queries;
+    for (unsigned i = 0; i < 300; i++)
+    {
+        queries.emplace_back(FixedPointCoordinate(lat_udist(g), lon_udist(g)));
+    }
+
+    std::vector<PhantomNode> batch_phantoms;
+    BOOST_CHECK(rtree.FindPhantomNodesForCoordinates(queries, batch_phantoms, 1));
+    std::vector<std::vector<PhantomNode>> batch_phantom_vectors;
+    BOOST_CHECK(
+        rtree.IncrementalFindPhantomNodesForCoordinates(queries, batch_phantom_vectors, 1, 2));
+    BOOST_REQUIRE_EQUAL(batch_phantoms.size(), queries.size());
+    BOOST_REQUIRE_EQUAL(batch_phantom_vectors.size(), queries.size());
+
+    for (unsigned i = 0; i < queries.size(); i++)
+    {
+        PhantomNode phantom;
+        rtree.FindPhantomNodeForCoordinate(queries[i], phantom, 1);
+        BOOST_CHECK_EQUAL(phantom, batch_phantoms[i]);
+
+        std::vector<PhantomNode> phantom_vector;
+        rtree.IncrementalFindPhantomNodeForCoordinate(queries[i], phantom_vector, 1, 2);
+        BOOST_REQUIRE_EQUAL(phantom_vector.size(), batch_phantom_vectors[i].size());
+        for (unsigned j = 0; j < phantom_vector.size(); j++)
+        {
+            BOOST_CHECK_EQUAL(phantom_vector[j], batch_phantom_vectors[i][j]);
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(range_query_test, TestRandomGraphFixture_Branch)
+{
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree<TestRandomGraphFixture_Branch>("test_range", this, leaves_path, nodes_path);
+    TestStaticRTree rtree(nodes_path, leaves_path, coords);
+
+    std::mt19937 g(RANDOM_SEED);
+    std::uniform_int_distribution<> lat_udist(WORLD_MIN_LAT, WORLD_MAX_LAT);
+    std::uniform_int_distribution<> lon_udist(WORLD_MIN_LON, WORLD_MAX_LON);
+    const auto by_nodes = [](const TestData &first, const TestData &second)
+    {
+        return std::make_pair(first.u, first.v) < std::make_pair(second.u, second.v);
+    };
+    const auto same_nodes = [](const TestData &first, const TestData &second)
+    {
+        return first.u == second.u && first.v == second.v;
+    };
+
+    for (unsigned i = 0; i < 50; i++)
+    {
+        const FixedPointCoordinate first_corner(lat_udist(g), lon_udist(g));
+        const FixedPointCoordinate second_corner(lat_udist(g) / 4, lon_udist(g) / 4);
+        const TestStaticRTree::RectangleT search_rectangle(first_corner, second_corner);
+        const FixedPointCoordinate center(lat_udist(g), lon_udist(g));
+        const float radius = 2000000.;
+
+        std::vector<TestData> rectangle_segments, radius_segments;
+        rtree.FindSegmentsInRectangle(search_rectangle, rectangle_segments);
+        rtree.FindSegmentsInRadius(center, radius, radius_segments);
+
+        std::vector<TestData> expected_rectangle_segments, expected_radius_segments;
+        for (const TestData &edge : edges)
+        {
+            const FixedPointCoordinate &u = coords->at(edge.u);
+            const FixedPointCoordinate &v = coords->at(edge.v);
+            if (search_rectangle.Intersects(u, v))
+            {
+                expected_rectangle_segments.emplace_back(edge);
+            }
+            if (FixedPointCoordinate::ComputePerpendicularDistance(u, v, center) <= radius)
+            {
+                expected_radius_segments.emplace_back(edge);
+            }
+        }
+
+        std::sort(rectangle_segments.begin(), rectangle_segments.end(), by_nodes);
+        std::sort(expected_rectangle_segments.begin(), expected_rectangle_segments.end(), by_nodes);
+        BOOST_REQUIRE_EQUAL(rectangle_segments.size(), expected_rectangle_segments.size());
+        BOOST_CHECK(std::equal(rectangle_segments.begin(),
+                               rectangle_segments.end(),
+                               expected_rectangle_segments.begin(),
+                               same_nodes));
+
+        std::sort(radius_segments.begin(), radius_segments.end(), by_nodes);
+        std::sort(expected_radius_segments.begin(), expected_radius_segments.end(), by_nodes);
+        BOOST_REQUIRE_EQUAL(radius_segments.size(), expected_radius_segments.size());
+        BOOST_CHECK(std::equal(radius_segments.begin(),
+                               radius_segments.end(),
+                               expected_radius_segments.begin(),
+                               same_nodes));
+
+        // a callback returning false stops the traversal at once
+        unsigned number_of_calls = 0;
+        const bool is_complete = rtree.ForEachSegmentInRadius(center,
+                                                              radius,
+                                                              [&number_of_calls](const TestData &)
+                                                              {
+            ++number_of_calls;
+            return false;
+        });
+        BOOST_CHECK_EQUAL(is_complete, radius_segments.empty());
+        BOOST_CHECK_EQUAL(number_of_calls, radius_segments.empty() ? 0u : 1u);
+    }
+}
+
+// truncated leaf files and leaf files without the format header are refused when mapped
+BOOST_FIXTURE_TEST_CASE(broken_leaf_file_test, TestRandomGraphFixture_LeafHalfFull)
+{
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree<TestRandomGraphFixture_LeafHalfFull>("test_broken", this, leaves_path, nodes_path);
+    const uint64_t leaf_file_size = boost::filesystem::file_size(leaves_path);
+
+    boost::filesystem::resize_file(leaves_path, leaf_file_size - 1);
+    BOOST_CHECK_THROW(TestStaticRTree(nodes_path, leaves_path, coords), OSRMException);
+
+    // previous format: element count followed by the leaves
+    boost::filesystem::resize_file(leaves_path, leaf_file_size);
+    {
+        boost::filesystem::fstream leaf_stream(
+            leaves_path, std::ios::binary | std::ios::in | std::ios::out);
+        const uint64_t element_count = edges.size();
+        leaf_stream.write((char *)&element_count, sizeof(uint64_t));
+    }
+    BOOST_CHECK_THROW(TestStaticRTree(nodes_path, leaves_path, coords), OSRMException);
+}
+
+// the leaf size is read back from the leaf file, not taken from the template argument
+BOOST_FIXTURE_TEST_CASE(construct_custom_leaf_size_test, TestRandomGraphFixture_Branch)
+{
+    construction_test("test_6", this, TEST_LEAF_NODE_SIZE / 4);
+}
+
+// osrm-prepare may run again while a server still has the leaf file mapped
+BOOST_FIXTURE_TEST_CASE(rebuild_while_mapped_test, TestRandomGraphFixture_Branch)
+{
+    std::string leaves_path;
+    std::string nodes_path;
+    build_rtree<TestRandomGraphFixture_Branch>("test_rebuild", this, leaves_path, nodes_path);
+    TestStaticRTree rtree(nodes_path, leaves_path, coords);
+
+    // smaller leaves give a shorter file, shrinking the mapped one in place would fault
+    build_rtree<TestRandomGraphFixture_Branch>(
+        "test_rebuild", this, leaves_path, nodes_path, TEST_LEAF_NODE_SIZE / 4);
+    BOOST_CHECK(!boost::filesystem::exists(leaves_path + ".tmp"));
+
+    simple_verify_rtree(rtree, coords, edges);
+}
+
 /*
  * Bug: If you querry a point that lies between two BBs that have a gap,
  * one BB will be pruned, even if it could contain a nearer match.
@@ -391,7 +562,7 @@ BOOST_AUTO_TEST_CASE(regression_test)
     std::string leaves_path;
     std::string nodes_path;
     build_rtree<GraphFixture, MiniStaticRTree>(
-        "test_regression", &fixture, leaves_path, nodes_path);
+        "test_regression", &fixture, leaves_path, nodes_path, 3);
     MiniStaticRTree rtree(nodes_path, leaves_path, fixture.coords);
 
     // query a node just right of the center of the gap
@@ -464,4 +635,30 @@ BOOST_AUTO_TEST_CASE(rectangle_test)
     TestRectangle(10, 10, 0, 0);
 }
 
+BOOST_AUTO_TEST_CASE(rectangle_intersection_test)
+{
+    const int precision = COORDINATE_PRECISION;
+    const TestStaticRTree::RectangleT rect(FixedPointCoordinate(0, 0),
+                                           FixedPointCoordinate(10 * precision, 10 * precision));
+
+    // crossing rectangles that do not contain each other's corners
+    const TestStaticRTree::RectangleT cross(FixedPointCoordinate(-5 * precision, 4 * precision),
+                                            FixedPointCoordinate(15 * precision, 6 * precision));
+    BOOST_CHECK(rect.Intersects(cross));
+    BOOST_CHECK(cross.Intersects(rect));
+    const TestStaticRTree::RectangleT apart(FixedPointCoordinate(11 * precision, 0),
+                                            FixedPointCoordinate(12 * precision, 10 * precision));
+    BOOST_CHECK(!rect.Intersects(apart));
+
+    // segments crossing the rectangle without an end point inside
+    BOOST_CHECK(rect.Intersects(FixedPointCoordinate(-5 * precision, 5 * precision),
+                                FixedPointCoordinate(15 * precision, 5 * precision)));
+    BOOST_CHECK(rect.Intersects(FixedPointCoordinate(-1 * precision, 5 * precision),
+                                FixedPointCoordinate(5 * precision, -1 * precision)));
+    BOOST_CHECK(!rect.Intersects(FixedPointCoordinate(-2 * precision, 1 * precision),
+                                 FixedPointCoordinate(1 * precision, -2 * precision)));
+    BOOST_CHECK(!rect.Intersects(FixedPointCoordinate(11 * precision, -5 * precision),
+                                 FixedPointCoordinate(11 * precision, 15 * precision)));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -77,7 +77,10 @@ bool GenerateDataStoreOptions(const int argc, const char *argv[], ServerPaths &p
         boost::program_options::value<boost::filesystem::path>(&paths["namesdata"]),
         ".names file")("timestamp",
                        boost::program_options::value<boost::filesystem::path>(&paths["timestamp"]),
-                       ".timestamp file");
+                       ".timestamp file")(
+        "poibuckets",
+        boost::program_options::value<boost::filesystem::path>(&paths["poibuckets"]),
+        ".poibuckets file");
 
     // hidden options, will be allowed both on command line and in config
     // file, but will not be shown to the user
@@ -137,7 +140,9 @@ bool GenerateDataStoreOptions(const int argc, const char *argv[], ServerPaths &p
                                    (paths.find("fileindex") != paths.end() &&
                                     !paths.find("fileindex")->second.string().empty()) ||
                                    (paths.find("timestamp") != paths.end() &&
-                                    !paths.find("timestamp")->second.string().empty());
+                                    !paths.find("timestamp")->second.string().empty()) ||
+                                   (paths.find("poibuckets") != paths.end() &&
+                                    !paths.find("poibuckets")->second.string().empty());
 
     if (parameter_present)
     {
@@ -216,6 +221,12 @@ bool GenerateDataStoreOptions(const int argc, const char *argv[], ServerPaths &p
         {
             path_iterator->second = base_string + ".timestamp";
         }
+
+        path_iterator = paths.find("poibuckets");
+        if (path_iterator != paths.end())
+        {
+            path_iterator->second = base_string + ".poibuckets";
+        }
     }
 
     path_iterator = paths.find("hsgrdata");
@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define GRAPHLOADER_H
 
 #include "OSRMException.h"
+#include "../DataStructures/ChunkedRecords.h"
 #include "../DataStructures/ImportNode.h"
 #include "../DataStructures/ImportEdge.h"
 #include "../DataStructures/QueryNode.h"
@@ -42,6 +43,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/filesystem/fstream.hpp>
 
 #include <tbb/parallel_sort.h>
+#include <tbb/pipeline.h>
+#include <tbb/task_scheduler_init.h>
 
 #include <cmath>
 
@@ -70,32 +73,87 @@ NodeID readBinaryOSRMGraphFromStream(std::istream &input_stream,
         SimpleLogger().Write(logWARNING) << ".osrm was prepared with different build.\n"
                                             "Reprocess to get rid of this warning.";
     }
-
-    NodeID n, source, target;
-    EdgeID m;
-    short dir; // direction (0 = open, 1 = forward, 2+ = open)
-    std::unordered_map<NodeID, NodeID> ext_to_int_id_map;
-    input_stream.read((char *)&n, sizeof(NodeID));
-    SimpleLogger().Write() << "Importing n = " << n << " nodes ";
-    ExternalMemoryNode current_node;
-    for (NodeID i = 0; i < n; ++i)
+    chunked_records::ReadFormatHeader(input_stream);
+
+    // Chunks are read sequentially, verified and decoded in parallel and consumed in file order.
+    // At most number_of_tokens chunks are in flight, so their buffers are reused round robin.
+    const unsigned number_of_tokens = 2 * tbb::task_scheduler_init::default_num_threads();
+    unsigned chunk_counter = 0;
+    unsigned number_of_records_read = 0;
+    const auto read_chunk = [&](const unsigned number_of_records,
+                                chunked_records::Chunk &chunk,
+                                tbb::flow_control &flow_control)
     {
-        input_stream.read((char *)&current_node, sizeof(ExternalMemoryNode));
-        int_to_ext_node_id_map->emplace_back(current_node.lat, current_node.lon, current_node.node_id);
-        ext_to_int_id_map.emplace(current_node.node_id, i);
-        if (current_node.bollard)
-        {
-            barrier_node_list.emplace_back(i);
-        }
-        if (current_node.trafficLight)
+        if (number_of_records_read == number_of_records)
         {
-            traffic_light_node_list.emplace_back(i);
+            flow_control.stop();
+            return false;
         }
-        if (current_node.poi)
+        chunked_records::ReadChunk(input_stream, chunk);
+        number_of_records_read += chunk.number_of_records;
+        if (number_of_records < number_of_records_read)
         {
-            poi_node_list.emplace_back(i);
+            throw OSRMException("record count mismatch in .osrm file, re-run osrm-extract");
         }
-    }
+        return true;
+    };
+
+    struct NodeBatch
+    {
+        chunked_records::Chunk chunk;
+        std::vector<ExternalMemoryNode> nodes;
+    };
+
+    NodeID n;
+    EdgeID m;
+    std::unordered_map<NodeID, NodeID> ext_to_int_id_map;
+    input_stream.read((char *)&n, sizeof(NodeID));
+    SimpleLogger().Write() << "Importing n = " << n << " nodes ";
+    ext_to_int_id_map.reserve(n);
+    int_to_ext_node_id_map->reserve(int_to_ext_node_id_map->size() + n);
+
+    std::vector<NodeBatch> node_batches(number_of_tokens);
+    NodeID internal_id = 0;
+    tbb::parallel_pipeline(
+        number_of_tokens,
+        tbb::make_filter<void, NodeBatch *>(tbb::filter::serial_in_order,
+                                            [&](tbb::flow_control &flow_control) -> NodeBatch *
+                                            {
+            NodeBatch *batch = &node_batches[chunk_counter++ % number_of_tokens];
+            return read_chunk(n, batch->chunk, flow_control) ? batch : nullptr;
+        }) &
+            tbb::make_filter<NodeBatch *, NodeBatch *>(
+                tbb::filter::parallel,
+                [](NodeBatch *batch)
+                {
+                    chunked_records::DecodeNodes(batch->chunk, batch->nodes);
+                    return batch;
+                }) &
+            tbb::make_filter<NodeBatch *, void>(
+                tbb::filter::serial_in_order,
+                [&](NodeBatch *batch)
+                {
+                    for (const ExternalMemoryNode &current_node : batch->nodes)
+                    {
+                        int_to_ext_node_id_map->emplace_back(
+                            current_node.lat, current_node.lon, current_node.node_id);
+                        ext_to_int_id_map.emplace(current_node.node_id, internal_id);
+                        if (current_node.bollard)
+                        {
+                            barrier_node_list.emplace_back(internal_id);
+                        }
+                        if (current_node.trafficLight)
+                        {
+                            traffic_light_node_list.emplace_back(internal_id);
+                        }
+                        if (current_node.poi)
+                        {
+                            poi_node_list.emplace_back(internal_id);
+                        }
+                        ++internal_id;
+                    }
+                }));
+    node_batches.clear();
 
     // tighten vector sizes
     barrier_node_list.shrink_to_fit();
@@ -129,80 +187,98 @@ NodeID readBinaryOSRMGraphFromStream(std::istream &input_stream,
         current_restriction.toNode = internal_id_iter->second;
     }
 
-    edge_list.reserve(m);
-    EdgeWeight weight;
-    NodeID nameID;
-    int length;
-    bool is_roundabout, ignore_in_grid, is_access_restricted, is_split;
-    TravelMode travel_mode;
-    for (EdgeID i = 0; i < m; ++i)
+    struct EdgeBatch
     {
-        input_stream.read((char *)&source, sizeof(unsigned));
-        input_stream.read((char *)&target, sizeof(unsigned));
-        input_stream.read((char *)&length, sizeof(int));
-        input_stream.read((char *)&dir, sizeof(short));
-        input_stream.read((char *)&weight, sizeof(int));
-        input_stream.read((char *)&nameID, sizeof(unsigned));
-        input_stream.read((char *)&is_roundabout, sizeof(bool));
-        input_stream.read((char *)&ignore_in_grid, sizeof(bool));
-        input_stream.read((char *)&is_access_restricted, sizeof(bool));
-        input_stream.read((char *)&travel_mode, sizeof(TravelMode));
-        input_stream.read((char *)&is_split, sizeof(bool));
-
-        BOOST_ASSERT_MSG(length > 0, "loaded null length edge");
-        BOOST_ASSERT_MSG(weight > 0, "loaded null weight");
-        BOOST_ASSERT_MSG(0 <= dir && dir <= 2, "loaded bogus direction");
-
-        bool forward = true;
-        bool backward = true;
-        if (1 == dir)
-        {
-            backward = false;
-        }
-        if (2 == dir)
-        {
-            forward = false;
-        }
+        chunked_records::Chunk chunk;
+        std::vector<ExtractedEdge> extracted_edges;
+        std::vector<EdgeT> edges;
+    };
 
-        // translate the external NodeIDs to internal IDs
-        auto internal_id_iter = ext_to_int_id_map.find(source);
-        if (ext_to_int_id_map.find(source) == ext_to_int_id_map.end())
-        {
+    edge_list.reserve(m);
+    std::vector<EdgeBatch> edge_batches(number_of_tokens);
+    number_of_records_read = 0;
+    tbb::parallel_pipeline(
+        number_of_tokens,
+        tbb::make_filter<void, EdgeBatch *>(tbb::filter::serial_in_order,
+                                            [&](tbb::flow_control &flow_control) -> EdgeBatch *
+                                            {
+            EdgeBatch *batch = &edge_batches[chunk_counter++ % number_of_tokens];
+            return read_chunk(m, batch->chunk, flow_control) ? batch : nullptr;
+        }) &
+            tbb::make_filter<EdgeBatch *, EdgeBatch *>(
+                tbb::filter::parallel,
+                [&ext_to_int_id_map](EdgeBatch *batch)
+                {
+                    chunked_records::DecodeEdges(batch->chunk, batch->extracted_edges);
+                    batch->edges.clear();
+                    for (const ExtractedEdge &extracted_edge : batch->extracted_edges)
+                    {
+                        BOOST_ASSERT_MSG(extracted_edge.length > 0, "loaded null length edge");
+                        BOOST_ASSERT_MSG(extracted_edge.weight > 0, "loaded null weight");
+                        BOOST_ASSERT_MSG(0 <= extracted_edge.direction &&
+                                             extracted_edge.direction <= 2,
+                                         "loaded bogus direction");
+
+                        bool forward = true;
+                        bool backward = true;
+                        if (1 == extracted_edge.direction)
+                        {
+                            backward = false;
+                        }
+                        if (2 == extracted_edge.direction)
+                        {
+                            forward = false;
+                        }
+
+                        // translate the external NodeIDs to internal IDs, the map is only read
+                        auto internal_id_iter = ext_to_int_id_map.find(extracted_edge.source);
+                        if (internal_id_iter == ext_to_int_id_map.end())
+                        {
 #ifndef NDEBUG
-            SimpleLogger().Write(logWARNING) << " unresolved source NodeID: " << source;
+                            SimpleLogger().Write(logWARNING)
+                                << " unresolved source NodeID: " << extracted_edge.source;
 #endif
-            continue;
-        }
-        source = internal_id_iter->second;
-        internal_id_iter = ext_to_int_id_map.find(target);
-        if (ext_to_int_id_map.find(target) == ext_to_int_id_map.end())
-        {
+                            continue;
+                        }
+                        NodeID source = internal_id_iter->second;
+                        internal_id_iter = ext_to_int_id_map.find(extracted_edge.target);
+                        if (internal_id_iter == ext_to_int_id_map.end())
+                        {
 #ifndef NDEBUG
-            SimpleLogger().Write(logWARNING) << "unresolved target NodeID : " << target;
+                            SimpleLogger().Write(logWARNING)
+                                << "unresolved target NodeID : " << extracted_edge.target;
 #endif
-            continue;
-        }
-        target = internal_id_iter->second;
-        BOOST_ASSERT_MSG(source != UINT_MAX && target != UINT_MAX, "nonexisting source or target");
-
-        if (source > target)
-        {
-            std::swap(source, target);
-            std::swap(forward, backward);
-        }
-
-        edge_list.emplace_back(source,
-                               target,
-                               nameID,
-                               weight,
-                               forward,
-                               backward,
-                               is_roundabout,
-                               ignore_in_grid,
-                               is_access_restricted,
-                               travel_mode,
-                               is_split);
-    }
+                            continue;
+                        }
+                        NodeID target = internal_id_iter->second;
+                        BOOST_ASSERT_MSG(source != UINT_MAX && target != UINT_MAX,
+                                         "nonexisting source or target");
+
+                        if (source > target)
+                        {
+                            std::swap(source, target);
+                            std::swap(forward, backward);
+                        }
+
+                        batch->edges.emplace_back(source,
+                                                  target,
+                                                  extracted_edge.name_id,
+                                                  extracted_edge.weight,
+                                                  forward,
+                                                  backward,
+                                                  extracted_edge.is_roundabout,
+                                                  extracted_edge.is_in_tiny_cc,
+                                                  extracted_edge.is_access_restricted,
+                                                  extracted_edge.travel_mode,
+                                                  extracted_edge.is_split);
+                    }
+                    return batch;
+                }) &
+            tbb::make_filter<EdgeBatch *, void>(
+                tbb::filter::serial_in_order,
+                [&edge_list](EdgeBatch *batch)
+                { edge_list.insert(edge_list.end(), batch->edges.begin(), batch->edges.end()); }));
+    edge_batches.clear();
 
     tbb::parallel_sort(edge_list.begin(), edge_list.end());
     for (unsigned i = 1; i < edge_list.size(); ++i)
@@ -268,116 +344,6 @@ NodeID readBinaryOSRMGraphFromStream(std::istream &input_stream,
     return n;
 }
 
-template <typename EdgeT, typename CoordinateT>
-NodeID readBinaryOSRMGraphFromStream(std::istream &input_stream,
-                                     std::vector<EdgeT> &edge_list,
-                                     std::vector<CoordinateT> & coordinate_list)
-{
-    const FingerPrint fingerprint_orig;
-    FingerPrint fingerprint_loaded;
-    input_stream.read((char *)&fingerprint_loaded, sizeof(FingerPrint));
-
-    if (!fingerprint_loaded.TestGraphUtil(fingerprint_orig))
-    {
-        SimpleLogger().Write(logWARNING) << ".osrm was prepared with different build.\n"
-                                            "Reprocess to get rid of this warning.";
-    }
-
-    NodeID n, source, target;
-    EdgeID m;
-    short dir; // direction (0 = open, 1 = forward, 2+ = open)
-    std::unordered_map<NodeID, NodeID> ext_to_int_id_map;
-
-    input_stream.read((char *)&n, sizeof(NodeID));
-    SimpleLogger().Write() << "Importing n = " << n << " nodes ";
-    ExternalMemoryNode current_node;
-    for (NodeID i = 0; i < n; ++i)
-    {
-        input_stream.read((char *)&current_node, sizeof(ExternalMemoryNode));
-        coordinate_list.emplace_back(current_node.lat, current_node.lon);
-        ext_to_int_id_map.emplace(current_node.node_id, i);
-    }
-
-    input_stream.read((char *)&m, sizeof(unsigned));
-    SimpleLogger().Write() << " and " << m << " edges ";
-
-    edge_list.reserve(m);
-    EdgeWeight weight;
-    NodeID nameID;
-    int length;
-    bool is_roundabout, ignore_in_grid, is_access_restricted, is_split;
-    TravelMode travel_mode;
-
-    for (EdgeID i = 0; i < m; ++i)
-    {
-        input_stream.read((char *)&source, sizeof(unsigned));
-        input_stream.read((char *)&target, sizeof(unsigned));
-        input_stream.read((char *)&length, sizeof(int));
-        input_stream.read((char *)&dir, sizeof(short));
-        input_stream.read((char *)&weight, sizeof(int));
-        input_stream.read((char *)&nameID, sizeof(unsigned));
-        input_stream.read((char *)&is_roundabout, sizeof(bool));
-        input_stream.read((char *)&ignore_in_grid, sizeof(bool));
-        input_stream.read((char *)&is_access_restricted, sizeof(bool));
-        input_stream.read((char *)&travel_mode, sizeof(TravelMode));
-        input_stream.read((char *)&is_split, sizeof(bool));
-
-        BOOST_ASSERT_MSG(length > 0, "loaded null length edge");
-        BOOST_ASSERT_MSG(weight > 0, "loaded null weight");
-        BOOST_ASSERT_MSG(0 <= dir && dir <= 2, "loaded bogus direction");
-
-        // translate the external NodeIDs to internal IDs
-        auto internal_id_iter = ext_to_int_id_map.find(source);
-        if (ext_to_int_id_map.find(source) == ext_to_int_id_map.end())
-        {
-#ifndef NDEBUG
-            SimpleLogger().Write(logWARNING) << " unresolved source NodeID: " << source;
-#endif
-            continue;
-        }
-        source = internal_id_iter->second;
-        internal_id_iter = ext_to_int_id_map.find(target);
-        if (ext_to_int_id_map.find(target) == ext_to_int_id_map.end())
-        {
-#ifndef NDEBUG
-            SimpleLogger().Write(logWARNING) << "unresolved target NodeID : " << target;
-#endif
-            continue;
-        }
-        target = internal_id_iter->second;
-        BOOST_ASSERT_MSG(source != UINT_MAX && target != UINT_MAX, "nonexisting source or target");
-
-        if (source > target)
-        {
-            std::swap(source, target);
-        }
-
-        edge_list.emplace_back(source,
-                               target);
-    }
-
-    tbb::parallel_sort(edge_list.begin(), edge_list.end());
-    for (unsigned i = 1; i < edge_list.size(); ++i)
-    {
-        if ((edge_list[i - 1].target == edge_list[i].target) &&
-            (edge_list[i - 1].source == edge_list[i].source))
-        {
-                edge_list[i].distance = std::min(edge_list[i - 1].distance, edge_list[i].distance);
-                edge_list[i - 1].source = UINT_MAX;
-        }
-    }
-    const auto new_end_iter = std::remove_if(edge_list.begin(),
-                                       edge_list.end(),
-                                       [](const EdgeT &edge)
-                                       { return edge.source == SPECIAL_NODEID; });
-    ext_to_int_id_map.clear();
-    edge_list.erase(new_end_iter, edge_list.end()); // remove excess candidates.
-    edge_list.shrink_to_fit();
-    SimpleLogger().Write() << "Graph loaded ok and has " << n << " nodes and " << edge_list.size() << " edges";
-    return n;
-}
-
-
 template <typename NodeT, typename EdgeT>
 unsigned readHSGRFromStream(const boost::filesystem::path &hsgr_file,
                             std::vector<NodeT> &node_list,
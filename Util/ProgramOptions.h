@@ -38,8 +38,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/any.hpp>
 #include <boost/program_options.hpp>
 
+#include <cstdlib>
+
 #include <fstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 const static unsigned INIT_OK_START_ENGINE = 0;
 const static unsigned INIT_OK_DO_NOT_START_ENGINE = 1;
@@ -56,8 +60,8 @@ inline void populate_base_path(ServerPaths &server_paths)
         const std::string base_string = path_iterator->second.string();
         SimpleLogger().Write() << "populating base path: " << base_string;
 
-        server_paths["poi"] = base_string + ".poi";
-        BOOST_ASSERT(server_paths.find("poi") != server_paths.end());
+        server_paths["poibuckets"] = base_string + ".poibuckets";
+        BOOST_ASSERT(server_paths.find("poibuckets") != server_paths.end());
         server_paths["hsgrdata"] = base_string + ".hsgr";
         BOOST_ASSERT(server_paths.find("hsgrdata") != server_paths.end());
         server_paths["nodesdata"] = base_string + ".nodes";
@@ -143,6 +147,27 @@ inline void populate_base_path(ServerPaths &server_paths)
     SimpleLogger().Write(logDEBUG) << "Index file:\t" << server_paths["fileindex"];
     SimpleLogger().Write(logDEBUG) << "Names file:\t" << server_paths["namesdata"];
     SimpleLogger().Write(logDEBUG) << "Timestamp file:\t" << server_paths["timestamp"];
+    SimpleLogger().Write(logDEBUG) << "POI buckets file:\t" << server_paths["poibuckets"];
+}
+
+// parses limits given as <plugin>=<number of parallel requests>
+inline void
+ParsePluginConcurrencyLimits(const std::vector<std::string> &plugin_concurrency_options,
+                             std::unordered_map<std::string, unsigned> &plugin_concurrency_limits)
+{
+    for (const std::string &plugin_concurrency : plugin_concurrency_options)
+    {
+        const std::string::size_type separator = plugin_concurrency.find('=');
+        const int limit = (std::string::npos == separator)
+                              ? 0
+                              : std::atoi(plugin_concurrency.c_str() + separator + 1);
+        if (0 == separator || 1 > limit)
+        {
+            throw OSRMException("Plugin concurrency must be given as <plugin>=<positive number>");
+        }
+        plugin_concurrency_limits[plugin_concurrency.substr(0, separator)] =
+            static_cast<unsigned>(limit);
+    }
 }
 
 // generate boost::program_options object for the routing part
@@ -153,8 +178,16 @@ inline unsigned GenerateServerProgramOptions(const int argc,
                                              int &ip_port,
                                              int &requested_num_threads,
                                              bool &use_shared_memory,
-                                             bool &trial)
+                                             bool &trial,
+                                             int &max_locations_distance_table,
+                                             int &max_results_range_query,
+                                             int &requested_num_io_threads,
+                                             int &max_queued_requests,
+                                             std::unordered_map<std::string, unsigned> &
+                                                 plugin_concurrency_limits)
 {
+    std::vector<std::string> plugin_concurrency_options;
+
     // declare a group of options that will be allowed only on command line
     boost::program_options::options_description generic_options("Options");
     generic_options.add_options()("version,v", "Show version")("help,h", "Show this help message")(
@@ -191,16 +224,35 @@ inline unsigned GenerateServerProgramOptions(const int argc,
         ".names file")("timestamp",
                        boost::program_options::value<boost::filesystem::path>(&paths["timestamp"]),
                        ".timestamp file")(
+        "poibuckets",
+        boost::program_options::value<boost::filesystem::path>(&paths["poibuckets"]),
+        ".poibuckets file")(
         "ip,i",
         boost::program_options::value<std::string>(&ip_address)->default_value("0.0.0.0"),
         "IP address")(
         "port,p", boost::program_options::value<int>(&ip_port)->default_value(5000), "TCP/IP port")(
         "threads,t",
         boost::program_options::value<int>(&requested_num_threads)->default_value(8),
-        "Number of threads to use")(
+        "Number of threads answering queries")(
+        "io-threads",
+        boost::program_options::value<int>(&requested_num_io_threads)->default_value(2),
+        "Number of threads reading requests and writing replies")(
+        "max-queued-requests",
+        boost::program_options::value<int>(&max_queued_requests)->default_value(256),
+        "Requests waiting for a free thread before the server replies with 503")(
+        "plugin-concurrency",
+        boost::program_options::value<std::vector<std::string>>(&plugin_concurrency_options)
+            ->composing(),
+        "Max. parallel requests of a plugin, e.g. table=2, may be given more than once")(
         "sharedmemory,s",
         boost::program_options::value<bool>(&use_shared_memory)->implicit_value(true),
-        "Load data from shared memory");
+        "Load data from shared memory")(
+        "max-table-size",
+        boost::program_options::value<int>(&max_locations_distance_table)->default_value(100),
+        "Max. locations supported in distance table query")(
+        "max-range-results",
+        boost::program_options::value<int>(&max_results_range_query)->default_value(10000),
+        "Max. segments or POIs returned by a range query");
 
     // hidden options, will be allowed both on command line and in config
     // file, but will not be shown to the user
@@ -258,6 +310,7 @@ inline unsigned GenerateServerProgramOptions(const int argc,
         boost::program_options::store(parse_config_file(config_stream, config_file_options),
                                       option_variables);
         boost::program_options::notify(option_variables);
+        ParsePluginConcurrencyLimits(plugin_concurrency_options, plugin_concurrency_limits);
         return INIT_OK_START_ENGINE;
     }
 
@@ -266,6 +319,28 @@ inline unsigned GenerateServerProgramOptions(const int argc,
         throw OSRMException("Number of threads must be a positive number");
     }
 
+    if (1 > max_locations_distance_table)
+    {
+        throw OSRMException("Max location for distance table must be a positive number");
+    }
+
+    if (1 > max_results_range_query)
+    {
+        throw OSRMException("Max results of range queries must be a positive number");
+    }
+
+    if (1 > requested_num_io_threads)
+    {
+        throw OSRMException("Number of io threads must be a positive number");
+    }
+
+    if (0 > max_queued_requests)
+    {
+        throw OSRMException("Number of queued requests must not be negative");
+    }
+
+    ParsePluginConcurrencyLimits(plugin_concurrency_options, plugin_concurrency_limits);
+
     if (!use_shared_memory && option_variables.count("base"))
     {
         return INIT_OK_START_ENGINE;
@@ -26,16 +26,19 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "DataStructures/OriginalEdgeData.h"
+#include "DataStructures/PoiBuckets.h"
 #include "DataStructures/RangeTable.h"
 #include "DataStructures/QueryEdge.h"
 #include "DataStructures/SharedMemoryFactory.h"
 #include "DataStructures/SharedMemoryVectorWrapper.h"
 #include "DataStructures/StaticGraph.h"
+#include "DataStructures/StaticPoiIndex.h"
 #include "DataStructures/StaticRTree.h"
 #include "DataStructures/TurnInstructions.h"
 #include "Server/DataStructures/BaseDataFacade.h"
 #include "Server/DataStructures/SharedDataType.h"
 #include "Server/DataStructures/SharedBarriers.h"
+#include "Server/DataStructures/SharedQueryCounters.h"
 #include "Util/BoostFileSystemFix.h"
 #include "Util/DataStoreOptions.h"
 #include "Util/simple_logger.hpp"
@@ -53,12 +56,15 @@ using QueryGraph = StaticGraph<QueryEdge::EdgeData>;
 #endif
 
 #include <boost/filesystem/fstream.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
 #include <boost/iostreams/seek.hpp>
 
 #include <cstdint>
 
+#include <chrono>
 #include <fstream>
 #include <string>
+#include <thread>
 
 // delete a shared memory region. report warning if it could not be deleted
 void delete_region(const SharedDataType region)
@@ -81,6 +87,8 @@ void delete_region(const SharedDataType region)
                 return "DATA_2";
             case LAYOUT_NONE:
                 return "LAYOUT_NONE";
+            case QUERY_COUNTERS:
+                return "QUERY_COUNTERS";
             default: // DATA_NONE:
                 return "DATA_NONE";
             }
@@ -194,6 +202,18 @@ int main(const int argc, const char *argv[])
         BOOST_ASSERT(server_paths.end() != paths_iterator);
         BOOST_ASSERT(!paths_iterator->second.empty());
         const boost::filesystem::path &geometries_data_path = paths_iterator->second;
+        paths_iterator = server_paths.find("poibuckets");
+        boost::filesystem::path poi_buckets_data_path;
+        if (server_paths.end() != paths_iterator)
+        {
+            poi_buckets_data_path = paths_iterator->second;
+        }
+        const bool has_poi_buckets = boost::filesystem::is_regular_file(poi_buckets_data_path);
+        if (!has_poi_buckets)
+        {
+            SimpleLogger().Write(logWARNING) << "no .poibuckets file found, "
+                                                "the poi service will be disabled";
+        }
 
         // determine segment to use
         bool segment2_in_use = SharedMemory::RegionExists(LAYOUT_2);
@@ -344,6 +364,55 @@ int main(const int argc, const char *argv[])
         geometry_input_stream.read((char *)&number_of_compressed_geometries, sizeof(unsigned));
         shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::GEOMETRIES_LIST,
                                                   number_of_compressed_geometries);
+
+        // load poi bucket sizes, without a .poibuckets file all poi blocks stay empty
+        boost::filesystem::ifstream poi_buckets_input_stream;
+        EdgeWeight poi_bucket_radius = 0;
+        shared_layout_ptr->SetBlockSize<EdgeWeight>(SharedDataLayout::POI_BUCKET_RADIUS, 1);
+        if (has_poi_buckets)
+        {
+            poi_buckets_input_stream.open(poi_buckets_data_path, std::ios::binary);
+            FingerPrint poi_fingerprint_loaded;
+            poi_buckets_input_stream.read((char *)&poi_fingerprint_loaded, sizeof(FingerPrint));
+            if (!poi_fingerprint_loaded.TestPrepare(fingerprint_orig))
+            {
+                SimpleLogger().Write(logWARNING)
+                    << ".poibuckets was prepared with different build. "
+                       "Reprocess to get rid of this warning.";
+            }
+            poi_buckets_input_stream.read((char *)&poi_bucket_radius, sizeof(EdgeWeight));
+            unsigned number_of_pois = 0;
+            poi_buckets_input_stream.read((char *)&number_of_pois, sizeof(unsigned));
+            shared_layout_ptr->SetBlockSize<PoiInfo>(SharedDataLayout::POI_LIST, number_of_pois);
+            boost::iostreams::seek(
+                poi_buckets_input_stream, number_of_pois * sizeof(PoiInfo), BOOST_IOS::cur);
+            unsigned number_of_poi_bucket_offsets = 0;
+            poi_buckets_input_stream.read((char *)&number_of_poi_bucket_offsets, sizeof(unsigned));
+            shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::POI_BUCKET_OFFSETS,
+                                                      number_of_poi_bucket_offsets);
+            boost::iostreams::seek(poi_buckets_input_stream,
+                                   number_of_poi_bucket_offsets * sizeof(unsigned),
+                                   BOOST_IOS::cur);
+            unsigned number_of_poi_buckets = 0;
+            poi_buckets_input_stream.read((char *)&number_of_poi_buckets, sizeof(unsigned));
+            shared_layout_ptr->SetBlockSize<PoiBucketEntry>(SharedDataLayout::POI_BUCKET_LIST,
+                                                            number_of_poi_buckets);
+            boost::iostreams::seek(poi_buckets_input_stream,
+                                   number_of_poi_buckets * sizeof(PoiBucketEntry),
+                                   BOOST_IOS::cur);
+            unsigned number_of_poi_boxes = 0;
+            poi_buckets_input_stream.read((char *)&number_of_poi_boxes, sizeof(unsigned));
+            shared_layout_ptr->SetBlockSize<PoiBoundingBox>(SharedDataLayout::POI_INDEX,
+                                                            number_of_poi_boxes);
+        }
+        else
+        {
+            shared_layout_ptr->SetBlockSize<PoiInfo>(SharedDataLayout::POI_LIST, 0);
+            shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::POI_BUCKET_OFFSETS, 0);
+            shared_layout_ptr->SetBlockSize<PoiBucketEntry>(SharedDataLayout::POI_BUCKET_LIST, 0);
+            shared_layout_ptr->SetBlockSize<PoiBoundingBox>(SharedDataLayout::POI_INDEX, 0);
+        }
+
         // allocate shared memory block
         SimpleLogger().Write() << "allocating shared memory of "
                                << shared_layout_ptr->GetSizeOfLayout() << " bytes";
@@ -527,24 +596,99 @@ int main(const int argc, const char *argv[])
         }
         hsgr_input_stream.close();
 
+        // load the precomputed poi buckets
+        EdgeWeight *poi_bucket_radius_ptr = shared_layout_ptr->GetBlockPtr<EdgeWeight, true>(
+            shared_memory_ptr, SharedDataLayout::POI_BUCKET_RADIUS);
+        *poi_bucket_radius_ptr = poi_bucket_radius;
+        if (has_poi_buckets)
+        {
+            poi_buckets_input_stream.seekg(sizeof(FingerPrint) + sizeof(EdgeWeight),
+                                           poi_buckets_input_stream.beg);
+            poi_buckets_input_stream.read((char *)&temporary_value, sizeof(unsigned));
+            BOOST_ASSERT(temporary_value ==
+                         shared_layout_ptr->num_entries[SharedDataLayout::POI_LIST]);
+            PoiInfo *poi_list_ptr = shared_layout_ptr->GetBlockPtr<PoiInfo, true>(
+                shared_memory_ptr, SharedDataLayout::POI_LIST);
+            if (shared_layout_ptr->GetBlockSize(SharedDataLayout::POI_LIST) > 0)
+            {
+                poi_buckets_input_stream.read(
+                    (char *)poi_list_ptr,
+                    shared_layout_ptr->GetBlockSize(SharedDataLayout::POI_LIST));
+            }
+
+            poi_buckets_input_stream.read((char *)&temporary_value, sizeof(unsigned));
+            BOOST_ASSERT(temporary_value ==
+                         shared_layout_ptr->num_entries[SharedDataLayout::POI_BUCKET_OFFSETS]);
+            unsigned *poi_bucket_offsets_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+                shared_memory_ptr, SharedDataLayout::POI_BUCKET_OFFSETS);
+            if (shared_layout_ptr->GetBlockSize(SharedDataLayout::POI_BUCKET_OFFSETS) > 0)
+            {
+                poi_buckets_input_stream.read(
+                    (char *)poi_bucket_offsets_ptr,
+                    shared_layout_ptr->GetBlockSize(SharedDataLayout::POI_BUCKET_OFFSETS));
+            }
+
+            poi_buckets_input_stream.read((char *)&temporary_value, sizeof(unsigned));
+            BOOST_ASSERT(temporary_value ==
+                         shared_layout_ptr->num_entries[SharedDataLayout::POI_BUCKET_LIST]);
+            PoiBucketEntry *poi_bucket_list_ptr =
+                shared_layout_ptr->GetBlockPtr<PoiBucketEntry, true>(
+                    shared_memory_ptr, SharedDataLayout::POI_BUCKET_LIST);
+            if (shared_layout_ptr->GetBlockSize(SharedDataLayout::POI_BUCKET_LIST) > 0)
+            {
+                poi_buckets_input_stream.read(
+                    (char *)poi_bucket_list_ptr,
+                    shared_layout_ptr->GetBlockSize(SharedDataLayout::POI_BUCKET_LIST));
+            }
+
+            poi_buckets_input_stream.read((char *)&temporary_value, sizeof(unsigned));
+            BOOST_ASSERT(temporary_value ==
+                         shared_layout_ptr->num_entries[SharedDataLayout::POI_INDEX]);
+            PoiBoundingBox *poi_box_list_ptr = shared_layout_ptr->GetBlockPtr<PoiBoundingBox, true>(
+                shared_memory_ptr, SharedDataLayout::POI_INDEX);
+            if (shared_layout_ptr->GetBlockSize(SharedDataLayout::POI_INDEX) > 0)
+            {
+                poi_buckets_input_stream.read(
+                    (char *)poi_box_list_ptr,
+                    shared_layout_ptr->GetBlockSize(SharedDataLayout::POI_INDEX));
+            }
+            poi_buckets_input_stream.close();
+        }
+
         // acquire lock
         SharedMemory *data_type_memory =
             SharedMemoryFactory::Get(CURRENT_REGIONS, sizeof(SharedDataTimestamp), true, false);
         SharedDataTimestamp *data_timestamp_ptr =
             static_cast<SharedDataTimestamp *>(data_type_memory->Ptr());
 
-        boost::interprocess::scoped_lock<boost::interprocess::named_mutex> query_lock(
-            barrier.query_mutex);
+        std::unique_ptr<SharedMemory> query_counters_memory(SharedMemoryFactory::Get(
+            QUERY_COUNTERS, sizeof(SharedQueryCounters), true, false));
+        SharedQueryCounters *query_counters =
+            static_cast<SharedQueryCounters *>(query_counters_memory->Ptr());
 
-        // notify all processes that were waiting for this condition
-        if (0 < barrier.number_of_queries)
         {
-            barrier.no_running_queries_condition.wait(query_lock);
+            boost::interprocess::scoped_lock<boost::interprocess::named_mutex> query_lock(
+                barrier.query_mutex);
+            data_timestamp_ptr->layout = layout_region;
+            data_timestamp_ptr->data = data_region;
+            data_timestamp_ptr->timestamp += 1;
         }
 
-        data_timestamp_ptr->layout = layout_region;
-        data_timestamp_ptr->data = data_region;
-        data_timestamp_ptr->timestamp += 1;
+        // Servers pick up the new regions with their next query. Give the queries that still run
+        // on the previous data some time to finish; removing the regions is safe either way, they
+        // stay mapped by the servers until the last reader has left.
+        const ShardedQueryCounter &previous_queries =
+            query_counters->GetCounter(previous_data_region);
+        const auto wait_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (0 < previous_queries.Sum() && std::chrono::steady_clock::now() < wait_deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (0 < previous_queries.Sum())
+        {
+            SimpleLogger().Write(logWARNING) << previous_queries.Sum()
+                                             << " queries still run on the previous data";
+        }
         delete_region(previous_data_region);
         delete_region(previous_layout_region);
         SimpleLogger().Write() << "all data loaded";
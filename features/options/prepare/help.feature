@@ -16,7 +16,9 @@ Feature: osrm-prepare command line options: help
         And stdout should contain "--restrictions"
         And stdout should contain "--profile"
         And stdout should contain "--threads"
-        And stdout should contain 15 lines
+        And stdout should contain "--poi-radius"
+        And stdout should contain "--rtree-leaf-size"
+        And stdout should contain 18 lines
         And it should exit with code 0
 
     Scenario: osrm-prepare - Help, short
@@ -31,7 +33,9 @@ Feature: osrm-prepare command line options: help
         And stdout should contain "--restrictions"
         And stdout should contain "--profile"
         And stdout should contain "--threads"
-        And stdout should contain 15 lines
+        And stdout should contain "--poi-radius"
+        And stdout should contain "--rtree-leaf-size"
+        And stdout should contain 18 lines
         And it should exit with code 0
 
     Scenario: osrm-prepare - Help, long
@@ -46,5 +50,7 @@ Feature: osrm-prepare command line options: help
         And stdout should contain "--restrictions"
         And stdout should contain "--profile"
         And stdout should contain "--threads"
-        And stdout should contain 15 lines
+        And stdout should contain "--poi-radius"
+        And stdout should contain "--rtree-leaf-size"
+        And stdout should contain 18 lines
         And it should exit with code 0
@@ -21,11 +21,17 @@ Feature: osrm-routed command line options: help
         And stdout should contain "--fileindex arg"
         And stdout should contain "--namesdata arg"
         And stdout should contain "--timestamp arg"
+        And stdout should contain "--poibuckets arg"
         And stdout should contain "--ip"
         And stdout should contain "--port"
         And stdout should contain "--threads"
+        And stdout should contain "--io-threads"
+        And stdout should contain "--max-queued-requests"
+        And stdout should contain "--plugin-concurrency"
         And stdout should contain "--sharedmemory"
-        And stdout should contain 22 lines
+        And stdout should contain "--max-table-size"
+        And stdout should contain "--max-range-results"
+        And stdout should contain 33 lines
         And it should exit with code 0
 
     Scenario: osrm-routed - Help, short
@@ -45,11 +51,17 @@ Feature: osrm-routed command line options: help
         And stdout should contain "--fileindex arg"
         And stdout should contain "--namesdata arg"
         And stdout should contain "--timestamp arg"
+        And stdout should contain "--poibuckets arg"
         And stdout should contain "--ip"
         And stdout should contain "--port"
         And stdout should contain "--threads"
+        And stdout should contain "--io-threads"
+        And stdout should contain "--max-queued-requests"
+        And stdout should contain "--plugin-concurrency"
         And stdout should contain "--sharedmemory"
-        And stdout should contain 22 lines
+        And stdout should contain "--max-table-size"
+        And stdout should contain "--max-range-results"
+        And stdout should contain 33 lines
         And it should exit with code 0
 
     Scenario: osrm-routed - Help, long
@@ -69,9 +81,15 @@ Feature: osrm-routed command line options: help
         And stdout should contain "--fileindex arg"
         And stdout should contain "--namesdata arg"
         And stdout should contain "--timestamp arg"
+        And stdout should contain "--poibuckets arg"
         And stdout should contain "--ip"
         And stdout should contain "--port"
         And stdout should contain "--threads"
+        And stdout should contain "--io-threads"
+        And stdout should contain "--max-queued-requests"
+        And stdout should contain "--plugin-concurrency"
         And stdout should contain "--sharedmemory"
-        And stdout should contain 22 lines
+        And stdout should contain "--max-table-size"
+        And stdout should contain "--max-range-results"
+        And stdout should contain 33 lines
         And it should exit with code 0
@@ -159,6 +159,18 @@ function get_exceptions(vector)
   end
 end
 
+-- way_function only reads these tags, ways that agree on them share one result
+way_tag_keys = { "highway", "route", "area", "oneway", "impassable", "status", "duration", "maxspeed", "surface", "tracktype", "smoothness", "name", "ref", "junction", "service", "maxspeed:forward", "maxspeed:backward" }
+
+function get_way_tag_keys(vector)
+  for i,v in ipairs(way_tag_keys) do
+    vector:Add(v)
+  end
+  for i,v in ipairs(access_tags_hierachy) do
+    vector:Add(v)
+  end
+end
+
 local function parse_maxspeed(source)
   if not source then
     return 0
@@ -128,7 +128,9 @@ int main(int argc, const char *argv[])
 
         bool use_shared_memory = false, trial_run = false;
         std::string ip_address;
-        int ip_port, requested_thread_num;
+        int ip_port, requested_thread_num, max_locations_distance_table, max_results_range_query;
+        int requested_io_thread_num, max_queued_requests;
+        std::unordered_map<std::string, unsigned> plugin_concurrency_limits;
 
         ServerPaths server_paths;
 
@@ -139,7 +141,12 @@ int main(int argc, const char *argv[])
                                                                   ip_port,
                                                                   requested_thread_num,
                                                                   use_shared_memory,
-                                                                  trial_run);
+                                                                  trial_run,
+                                                                  max_locations_distance_table,
+                                                                  max_results_range_query,
+                                                                  requested_io_thread_num,
+                                                                  max_queued_requests,
+                                                                  plugin_concurrency_limits);
         if (init_result == INIT_OK_DO_NOT_START_ENGINE)
         {
             return 0;
@@ -164,8 +171,12 @@ int main(int argc, const char *argv[])
         }
 
         SimpleLogger().Write(logDEBUG) << "Threads:\t" << requested_thread_num;
+        SimpleLogger().Write(logDEBUG) << "IO threads:\t" << requested_io_thread_num;
+        SimpleLogger().Write(logDEBUG) << "Max. queued requests:\t" << max_queued_requests;
         SimpleLogger().Write(logDEBUG) << "IP address:\t" << ip_address;
         SimpleLogger().Write(logDEBUG) << "IP port:\t" << ip_port;
+        SimpleLogger().Write(logDEBUG) << "Max. table size:\t" << max_locations_distance_table;
+        SimpleLogger().Write(logDEBUG) << "Max. range results:\t" << max_results_range_query;
 #ifndef _WIN32
         int sig = 0;
         sigset_t new_mask;
@@ -174,11 +185,24 @@ int main(int argc, const char *argv[])
         pthread_sigmask(SIG_BLOCK, &new_mask, &old_mask);
 #endif
 
-        OSRM osrm_lib(server_paths, use_shared_memory);
-        auto routing_server =
-            Server::CreateServer(ip_address, ip_port, requested_thread_num);
+        OSRM osrm_lib(server_paths,
+                      use_shared_memory,
+                      max_locations_distance_table,
+                      max_results_range_query);
+        auto routing_server = Server::CreateServer(ip_address,
+                                                   ip_port,
+                                                   requested_io_thread_num,
+                                                   requested_thread_num,
+                                                   max_queued_requests);
 
         routing_server->GetRequestHandlerPtr().RegisterRoutingMachine(&osrm_lib);
+        for (const auto &plugin_concurrency_limit : plugin_concurrency_limits)
+        {
+            SimpleLogger().Write(logDEBUG) << "Max. parallel " << plugin_concurrency_limit.first
+                                           << " requests:\t" << plugin_concurrency_limit.second;
+            routing_server->GetRequestHandlerPtr().SetPluginConcurrencyLimit(
+                plugin_concurrency_limit.first, plugin_concurrency_limit.second);
+        }
 
         if (trial_run)
         {